@@ -0,0 +1,307 @@
+#include <GP02.h>
+#include <GP02Basic.h>
+#include <GP02Format.h>
+/*
+   This sketch measures the GP02 library on the target itself. It needs no GPS:
+   a canned GP-02 epoch stored in flash is fed to the parser repeatedly.
+
+   BENCH_CONFIG selects which parser is timed (and therefore linked):
+     0  GP02 (full featured)
+     1  GP02Basic<GP02Feature::All>
+     2  GP02Basic<Location, Date, Time, Speed, Course, Age>
+     3  GP02Basic<Location, Time>
+     4  GP02Basic<Location>
+     5  GP02 plus the GP02Format record formatters, timed against snprintf
+     6  GP02 built with -D_GPS_LAZY_DECODE (fields decoded on first read)
+   extras/bench/footprint.sh builds the sketch once per configuration and
+   tabulates the flash and RAM reported by the compiler.
+*/
+#ifndef BENCH_CONFIG
+#define BENCH_CONFIG 0
+#endif
+
+typedef GP02Basic<GP02Feature::All> BasicAll;
+typedef GP02Basic<GP02Feature::Location, GP02Feature::Date, GP02Feature::Time, GP02Feature::Speed, GP02Feature::Course, GP02Feature::Age> BasicNav;
+typedef GP02Basic<GP02Feature::Location, GP02Feature::Time> BasicLogger;
+typedef GP02Basic<GP02Feature::Location> BasicLocation;
+
+#if BENCH_CONFIG == 0
+typedef GP02 Parser;
+#elif BENCH_CONFIG == 1
+typedef BasicAll Parser;
+#elif BENCH_CONFIG == 2
+typedef BasicNav Parser;
+#elif BENCH_CONFIG == 3
+typedef BasicLogger Parser;
+#elif BENCH_CONFIG == 4
+typedef BasicLocation Parser;
+#else
+typedef GP02 Parser;
+#endif
+
+// the library must be compiled with the same switch, so it cannot be defined in the sketch
+#if BENCH_CONFIG == 6 && !defined(_GPS_LAZY_DECODE)
+#error "BENCH_CONFIG 6 needs _GPS_LAZY_DECODE in GP02Config.h or the build flags (see extras/bench/footprint.sh)"
+#endif
+
+static const uint16_t PASSES = 50;
+static const uint16_t FORMAT_PASSES = 100;
+
+static const char sample[] PROGMEM =
+  "$GNGGA,120000.000,4100.49200,N,02858.70400,E,1,09,1.3,40.0,M,0.0,M,,*40\r\n"
+  "$GNGSA,A,3,05,11,17,23,,,,,,,,,2.1,1.3,1.7,1*34\r\n"
+  "$GPGSV,2,1,08,02,79,194,22,05,30,125,35,08,61,056,22,11,12,347,35*7D\r\n"
+  "$GPGSV,2,2,08,14,43,278,22,17,74,209,35,20,25,140,22,23,56,071,35*74\r\n"
+  "$GNRMC,120000.000,A,4100.49200,N,02858.70400,E,35.00,0.00,181026,,,A*47\r\n"
+  "$GNVTG,0.00,T,,M,35.00,N,64.82,K,A*2D\r\n";
+
+Parser gps;
+
+static void printRow(const __FlashStringHelper *name, unsigned long value, const __FlashStringHelper *unit)
+{
+  Serial.print(name);
+  Serial.print(F(": "));
+  Serial.print(value);
+  Serial.print(' ');
+  Serial.println(unit);
+}
+
+static void benchFootprint()
+{
+  Serial.println(F("-- sizeof() per configuration --"));
+  printRow(F("GP02                  "), sizeof(GP02), F("bytes"));
+  printRow(F("GP02Basic<All>        "), sizeof(BasicAll), F("bytes"));
+  printRow(F("GP02Basic<nav + Age>  "), sizeof(BasicNav), F("bytes"));
+  printRow(F("GP02Basic<Loc, Time>  "), sizeof(BasicLogger), F("bytes"));
+  printRow(F("GP02Basic<Location>   "), sizeof(BasicLocation), F("bytes"));
+#if defined(__AVR__)
+  extern char __data_load_end;
+  printRow(F("flash used (this build)"), (unsigned long)&__data_load_end, F("bytes"));
+#endif
+}
+
+static void benchParse()
+{
+  Serial.print(F("-- parse, config "));
+  Serial.print(BENCH_CONFIG);
+  Serial.println(F(" --"));
+
+  unsigned long sentences = 0, chars = 0;
+  unsigned long start = micros();
+  for (uint16_t pass = 0; pass < PASSES; ++pass)
+    for (const char *p = sample; pgm_read_byte(p); ++p, ++chars)
+      if (gps.encode(pgm_read_byte(p)))
+        ++sentences;
+  unsigned long elapsed = micros() - start;
+
+  printRow(F("sentences"), sentences, F(""));
+  printRow(F("per sentence"), elapsed / (sentences ? sentences : 1), F("us"));
+  printRow(F("per char    "), elapsed * 1000UL / chars, F("ns"));
+}
+
+// The slowest single encode() call, i.e. how far a time-budgeted loop can overrun between
+// two clock reads. Terminators that complete a sentence are reported separately from the rest.
+static void benchWorstByte()
+{
+  Serial.println(F("-- worst-case cost of one byte --"));
+
+  // the cost of the two micros() calls around each byte is subtracted
+  unsigned long overhead = ULONG_MAX;
+  for (uint8_t i = 0; i < 32; ++i)
+  {
+    unsigned long t = micros();
+    unsigned long d = micros() - t;
+    if (d < overhead)
+      overhead = d;
+  }
+
+  unsigned long worstChar = 0, worstTerm = 0, worstSentence = 0;
+  for (uint16_t pass = 0; pass < PASSES; ++pass)
+    for (const char *p = sample; pgm_read_byte(p); ++p)
+    {
+      char c = pgm_read_byte(p);
+      unsigned long t = micros();
+      bool done = gps.encode(c);
+      unsigned long d = micros() - t;
+      d = d > overhead ? d - overhead : 0;
+      unsigned long &worst = done ? worstSentence : c == ',' || c == '*' || c == '\r' || c == '\n' ? worstTerm : worstChar;
+      if (d > worst)
+        worst = d;
+    }
+
+  printRow(F("ordinary char   "), worstChar, F("us"));
+  printRow(F("term end        "), worstTerm, F("us"));
+  printRow(F("sentence end    "), worstSentence, F("us"));
+}
+
+#if BENCH_CONFIG == 0 || BENCH_CONFIG >= 5
+// Replays the flash sample through the available()/read() interface of a serial port.
+struct SampleSource
+{
+  const char *p;
+  uint16_t left;
+
+  int available() { return left; }
+  int read()
+  {
+    if (left == 0)
+      return -1;
+    if (pgm_read_byte(p) == 0)
+      p = sample;
+    --left;
+    return pgm_read_byte(p++);
+  }
+};
+
+// A 1 kHz control loop that grants the parser a fixed slice per tick.
+static void benchBudget()
+{
+  static const uint16_t SLICE = 200;
+  Serial.print(F("-- encodeFor(), "));
+  Serial.print(SLICE);
+  Serial.println(F(" us slice --"));
+
+  SampleSource source = { sample, (uint16_t)(PASSES * strlen_P(sample)) };
+  unsigned long calls = 0, sentences = 0, worst = 0, overruns = 0;
+  int backlog = source.available();
+  while (backlog > 0)
+  {
+    GP02Drain d = gps.encodeFor(source, 0, SLICE);
+    ++calls;
+    sentences += d.sentences;
+    if (d.elapsed > worst)
+      worst = d.elapsed;
+    if (d.elapsed > SLICE)
+      ++overruns;
+    backlog = d.backlog;
+  }
+
+  printRow(F("calls       "), calls, F(""));
+  printRow(F("sentences   "), sentences, F(""));
+  printRow(F("longest call"), worst, F("us"));
+  printRow(F("overruns    "), overruns, F(""));
+}
+
+// A tracker that only logs time and position: the fields it never reads are the ones
+// _GPS_LAZY_DECODE no longer decodes.
+static void benchParseAndRead()
+{
+  Serial.println(F("-- parse, reading time and location only --"));
+
+  unsigned long sentences = 0, chars = 0;
+  uint32_t check = 0;
+  unsigned long start = micros();
+  for (uint16_t pass = 0; pass < PASSES; ++pass)
+    for (const char *p = sample; pgm_read_byte(p); ++p, ++chars)
+      if (gps.encode(pgm_read_byte(p)))
+      {
+        ++sentences;
+        if (gps.location.isUpdated())
+          check += gps.time.value() + (uint32_t)(gps.location.lat() * 1000) + (uint32_t)(gps.location.lng() * 1000);
+      }
+  unsigned long elapsed = micros() - start;
+
+  printRow(F("per sentence"), elapsed / (sentences ? sentences : 1), F("us"));
+  printRow(F("per char    "), elapsed * 1000UL / chars, F("ns"));
+  printRow(F("(checksum)  "), check, F(""));
+}
+#endif
+
+#if BENCH_CONFIG == 5
+// The same CSV record the way FullExample prints values: float accessors and printf.
+static size_t snprintfCsv(char *buf, size_t size)
+{
+  char lat[16], lng[16], alt[12], speed[12], course[12], hdop[12];
+#if defined(__AVR__)
+  // avr-libc's printf has no %f
+  dtostrf(gps.location.lat(), 1, 7, lat);
+  dtostrf(gps.location.lng(), 1, 7, lng);
+  dtostrf(gps.speed.knots(), 1, 2, speed);
+  dtostrf(gps.course.deg(), 1, 2, course);
+  dtostrf(gps.altitude.meters(), 1, 2, alt);
+  dtostrf(gps.hdop.hdop(), 1, 2, hdop);
+#else
+  snprintf(lat, sizeof(lat), "%.7f", gps.location.lat());
+  snprintf(lng, sizeof(lng), "%.7f", gps.location.lng());
+  snprintf(speed, sizeof(speed), "%.2f", gps.speed.knots());
+  snprintf(course, sizeof(course), "%.2f", gps.course.deg());
+  snprintf(alt, sizeof(alt), "%.2f", gps.altitude.meters());
+  snprintf(hdop, sizeof(hdop), "%.2f", gps.hdop.hdop());
+#endif
+  return snprintf(buf, size, "%04u-%02u-%02u,%02u:%02u:%02u.%02u,%s,%s,%s,%s,%s,%lu,%s,%c",
+    gps.date.year(), gps.date.month(), gps.date.day(), gps.time.hour(), gps.time.minute(),
+    gps.time.second(), gps.time.centisecond(), lat, lng, speed, course, alt,
+    (unsigned long)gps.satellites.value(), hdop, (char)gps.location.FixQuality());
+}
+
+static void printFormatRow(const __FlashStringHelper *name, unsigned long elapsed, size_t length)
+{
+  Serial.print(name);
+  Serial.print(F(": "));
+  Serial.print(elapsed / FORMAT_PASSES);
+  Serial.print(F(" us, "));
+  Serial.print((unsigned long)length);
+  Serial.println(F(" bytes"));
+}
+
+static void benchFormat()
+{
+  Serial.println(F("-- format one epoch --"));
+  // the parse loop replays one timestamp, so take the record from the fields, not the epoch
+  GP02Fix fix;
+  GP02Format::capture(gps, fix);
+  char buf[GP02_FORMAT_MAX];
+  size_t length = 0;
+  unsigned long start;
+
+  start = micros();
+  for (uint16_t i = 0; i < FORMAT_PASSES; ++i)
+    length = snprintfCsv(buf, sizeof(buf));
+  printFormatRow(F("snprintf CSV    "), micros() - start, length);
+  Serial.println(buf);
+
+  start = micros();
+  for (uint16_t i = 0; i < FORMAT_PASSES; ++i)
+    length = GP02Format::csv(buf, sizeof(buf), fix);
+  printFormatRow(F("GP02Format CSV  "), micros() - start, length);
+  Serial.println(buf);
+
+  start = micros();
+  for (uint16_t i = 0; i < FORMAT_PASSES; ++i)
+    length = GP02Format::text(buf, sizeof(buf), fix);
+  printFormatRow(F("GP02Format text "), micros() - start, length);
+
+  start = micros();
+  for (uint16_t i = 0; i < FORMAT_PASSES; ++i)
+    length = GP02Format::json(buf, sizeof(buf), fix);
+  printFormatRow(F("GP02Format JSON "), micros() - start, length);
+
+  start = micros();
+  for (uint16_t i = 0; i < FORMAT_PASSES; ++i)
+    length = GP02Format::cbor((uint8_t *)buf, sizeof(buf), fix);
+  printFormatRow(F("GP02Format CBOR "), micros() - start, length);
+}
+#endif
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println(F("Benchmark.ino"));
+  Serial.print(F("GP02 library v. ")); Serial.println(GP02::libraryVersion());
+  Serial.println();
+
+  benchFootprint();
+  benchParse();
+  benchWorstByte();
+#if BENCH_CONFIG == 0 || BENCH_CONFIG >= 5
+  benchParseAndRead();
+  benchBudget();
+#endif
+#if BENCH_CONFIG == 5
+  benchFormat();
+#endif
+}
+
+void loop()
+{
+}
@@ -0,0 +1,26 @@
+#!/bin/sh
+# Builds examples/Benchmark once per BENCH_CONFIG and tabulates flash and RAM usage.
+#
+#   extras/bench/footprint.sh [FQBN]        (default arduino:avr:uno)
+#
+# Requires arduino-cli with the board's core installed. Run from "software files".
+
+FQBN=${1:-arduino:avr:uno}
+NAMES="GP02 GP02Basic<All> GP02Basic<nav+Age> GP02Basic<Loc,Time> GP02Basic<Location> GP02+Format GP02(lazy)"
+
+printf "%-22s %10s %10s\n" "configuration" "flash" "ram"
+n=0
+for name in $NAMES; do
+  flags="-DBENCH_CONFIG=$n"
+  # configuration 6 needs the library itself built in lazy decode mode
+  [ $n -eq 6 ] && flags="$flags -D_GPS_LAZY_DECODE"
+  out=$(arduino-cli compile --fqbn "$FQBN" --library . \
+        --build-property "compiler.cpp.extra_flags=$flags" examples/Benchmark 2>&1) || {
+    echo "$out" >&2
+    exit 1
+  }
+  flash=$(echo "$out" | sed -n 's/^Sketch uses \([0-9]*\) bytes.*/\1/p')
+  ram=$(echo "$out" | sed -n 's/^Global variables use \([0-9]*\) bytes.*/\1/p')
+  printf "%-22s %10s %10s\n" "$name" "$flash" "$ram"
+  n=$((n + 1))
+done
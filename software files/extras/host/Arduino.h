@@ -0,0 +1,32 @@
+#ifndef GP02_HOST_ARDUINO_h
+#define GP02_HOST_ARDUINO_h
+
+/*
+Minimal stand-in for the Arduino core so that src/GP02.cpp builds on a host.
+GP02.cpp provides millis() and micros() itself when ARDUINO is not defined.
+*/
+
+#include <chrono>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint8_t byte;
+
+// host builds have the RAM for epoch assembly, which the host tools rely on
+#ifndef _GPS_EPOCHS
+#define _GPS_EPOCHS
+#endif
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+#define TWO_PI 6.283185307179586476925286766559
+#define radians(deg) ((deg)*0.017453292519943295769236907684886)
+#define degrees(rad) ((rad)*57.295779513082320876798154814105)
+#define sq(x) ((x)*(x))
+
+unsigned long millis();
+unsigned long micros();
+
+#endif // def(GP02_HOST_ARDUINO_h)
@@ -0,0 +1,261 @@
+/*
+GP02Await - C++20 coroutine interface for GP02 receivers on a GP02SerialHub.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+*/
+
+#include "GP02Await.h"
+
+#include <string.h>
+#include <time.h>
+
+GP02Waiter::GP02Waiter(GP02AsyncReceiver &receiver, const char *sentenceName, std::chrono::milliseconds timeout)
+  :  rx(receiver)
+  ,  sentence(sentenceName)
+  ,  deadline(INT64_MAX)
+  ,  rxLink(this)
+  ,  timerLink(this)
+  ,  timedOut(false)
+{
+  if (timeout == std::chrono::milliseconds::max())
+    return;
+  // saturate rather than wrap, which would time out at once
+  int64_t t = GP02EventLoop::now(), ms = timeout.count() < 0 ? 0 : (int64_t)timeout.count();
+  deadline = ms >= (INT64_MAX - t) / 1000000LL ? INT64_MAX : t + ms * 1000000LL;
+}
+
+/**
+ * @brief Unlinks a waiter whose coroutine was destroyed while suspended.
+ */
+GP02Waiter::~GP02Waiter()
+{
+  rxLink.unlink();
+  timerLink.unlink();
+}
+
+/**
+ * @brief Registers the suspended coroutine with its receiver and, if needed, the timer list.
+ *
+ * @return False, so that the coroutine is not suspended, if the receiver is being destroyed;
+ * the wait then ends as timed out.
+ */
+bool GP02Waiter::suspend(std::coroutine_handle<> h)
+{
+  if (rx.closing)
+  {
+    timedOut = true;
+    return false;
+  }
+  handle = h;
+  rxLink.insertBefore(rx.waiters);
+  if (deadline != INT64_MAX)
+    rx.loop.arm(*this);
+  return true;
+}
+
+/**
+ * @brief Opens a serial device and registers it with the loop's hub.
+ *
+ * @param loop The event loop that services this receiver.
+ * @param path The serial device.
+ * @param baud The line rate of the receiver.
+ * @param terminator The sentence that closes an epoch (see GP02::enableEpochs()).
+ */
+GP02AsyncReceiver::GP02AsyncReceiver(GP02EventLoop &l, const char *path, unsigned long baud, uint8_t terminator)
+  :  loop(l)
+  ,  closing(false)
+{
+  gps.enableEpochs(terminator);
+  port = loop.hub.open(path, baud, gps);
+  if (port >= 0)
+    loop.add(*this);
+}
+
+/**
+ * @brief Registers an already open descriptor, e.g. one side of a pseudo-terminal pair.
+ *
+ * @param loop The event loop that services this receiver.
+ * @param fd The descriptor to read from; it remains owned by the caller.
+ * @param baud The line rate, used for first-byte time estimates; 0 if unknown.
+ * @param terminator The sentence that closes an epoch (see GP02::enableEpochs()).
+ */
+GP02AsyncReceiver::GP02AsyncReceiver(GP02EventLoop &l, int fd, unsigned long baud, uint8_t terminator)
+  :  loop(l)
+  ,  closing(false)
+{
+  gps.enableEpochs(terminator);
+  port = loop.hub.attach(fd, gps, baud);
+  if (port >= 0)
+    loop.add(*this);
+}
+
+/**
+ * @brief Closes the port and resumes every coroutine still waiting on this receiver as timed out.
+ *
+ * Left linked, the waiters would later be resumed by the timer list or the next sentence
+ * through a destroyed receiver.
+ */
+GP02AsyncReceiver::~GP02AsyncReceiver()
+{
+  closing = true;
+  while (waiters.linked())
+  {
+    GP02Waiter *w = waiters.next->owner;
+    w->rxLink.unlink();
+    w->timerLink.unlink();
+    w->timedOut = true;
+    w->handle.resume();
+  }
+  if (port >= 0)
+  {
+    loop.hub.close(port);
+    loop.receivers[port] = NULL;
+  }
+}
+
+bool GP02AsyncReceiver::isOpen() const
+{
+  if (closing)
+    return false;
+  const GP02SerialPort *p = port >= 0 ? loop.hub.port(port) : NULL;
+  return p != NULL && p->isOpen();
+}
+
+/**
+ * @brief Resumes the waiters satisfied by a sentence that just passed its checksum.
+ *
+ * The wait list is detached before resuming anything, so coroutines that immediately wait
+ * again are queued for the next sentence rather than being resumed twice. A published epoch
+ * is consumed here whether or not anyone is waiting for it.
+ *
+ * @param name The sentence identifier, e.g. "GNRMC".
+ */
+void GP02AsyncReceiver::sentenceReceived(const char *name)
+{
+  // the receiver consumes every epoch, so a later nextFix() never sees a stale one
+  bool fixReady = gps.epoch.isUpdated();
+  const GP02Fix &fix = gps.epoch.value();
+  if (!waiters.linked())
+    return;
+
+  GP02Link ready;
+  for (GP02Link *l = waiters.next; l != &waiters; )
+  {
+    GP02Link *next = l->next;
+    GP02Waiter *w = l->owner;
+    bool match = w->sentence == NULL ? fixReady
+      : strlen(w->sentence) == 3 ? strcmp(name + 2, w->sentence) == 0 : strcmp(name, w->sentence) == 0;
+    if (match)
+    {
+      l->unlink();
+      l->insertBefore(ready);
+    }
+    l = next;
+  }
+  if (!ready.linked())
+    return;
+
+  if (fixReady)
+  {
+    for (GP02Link *l = ready.next; l != &ready; l = l->next)
+      if (l->owner->sentence == NULL)
+        l->owner->fix = fix;
+  }
+
+  while (ready.linked())
+  {
+    GP02Waiter *w = ready.next->owner;
+    ready.next->unlink();
+    w->timerLink.unlink();
+    w->handle.resume();
+  }
+}
+
+GP02EventLoop::GP02EventLoop(GP02SerialHub &h)
+  :  hub(h)
+  ,  stopped(false)
+{
+  hub.onSentence(onSentence, this);
+}
+
+int64_t GP02EventLoop::now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void GP02EventLoop::add(GP02AsyncReceiver &rx)
+{
+  if (receivers.size() <= (size_t)rx.port)
+    receivers.resize(rx.port + 1, NULL);
+  receivers[rx.port] = &rx;
+}
+
+/**
+ * @brief Inserts a waiter into the timer list, which is kept sorted by deadline.
+ */
+void GP02EventLoop::arm(GP02Waiter &w)
+{
+  GP02Link *pos = timers.next;
+  while (pos != &timers && pos->owner->deadline <= w.deadline)
+    pos = pos->next;
+  w.timerLink.insertBefore(*pos);
+}
+
+/**
+ * @brief Resumes every waiter whose deadline has passed, reporting a timeout.
+ */
+void GP02EventLoop::expire()
+{
+  int64_t t = now();
+  while (timers.linked() && timers.next->owner->deadline <= t)
+  {
+    GP02Waiter *w = timers.next->owner;
+    w->timerLink.unlink();
+    w->rxLink.unlink();
+    w->timedOut = true;
+    w->handle.resume();
+  }
+}
+
+void GP02EventLoop::onSentence(void *context, GP02SerialPort &port, const char *sentence)
+{
+  GP02EventLoop *loop = (GP02EventLoop *)context;
+  if ((size_t)port.index() < loop->receivers.size() && loop->receivers[port.index()] != NULL)
+    loop->receivers[port.index()]->sentenceReceived(sentence);
+}
+
+/**
+ * @brief Waits for input or the next timeout once and resumes the coroutines that are due.
+ *
+ * @param maxWaitMs The longest time to block, or -1 to block until input or the next deadline.
+ * @return The number of valid sentences parsed, or -1 if the hub failed.
+ */
+int GP02EventLoop::runOnce(int maxWaitMs)
+{
+  int wait = maxWaitMs;
+  if (timers.linked())
+  {
+    int64_t ms = (timers.next->owner->deadline - now() + 999999) / 1000000;
+    if (ms < 0)
+      ms = 0;
+    if (wait < 0 || ms < wait)
+      wait = (int)ms;
+  }
+
+  int sentences = hub.poll(wait);
+  expire();
+  return sentences;
+}
+
+void GP02EventLoop::run()
+{
+  stopped = false;
+  while (!stopped)
+    if (runOnce() < 0)
+      break;
+}
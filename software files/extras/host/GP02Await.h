@@ -0,0 +1,164 @@
+#ifndef GP02Await_h
+#define GP02Await_h
+
+/*
+GP02Await - C++20 coroutine interface for GP02 receivers on a GP02SerialHub.
+
+A GP02EventLoop drives the hub and resumes coroutines that wait for a receiver's next epoch
+fix or next sentence of a given type, with optional timeouts, so that many receivers are
+serviced from one thread without polling isUpdated():
+
+   GP02Task track(GP02AsyncReceiver &rx)
+   {
+     for (;;)
+     {
+       std::optional<GP02Fix> fix = co_await rx.nextFix(std::chrono::seconds(2));
+       if (!fix)
+         puts("no fix for 2 s");
+     }
+   }
+
+Awaiters live in the awaiting coroutine's frame and are linked intrusively into the
+receiver's wait list and the loop's timer list, so waiting for a fix never allocates.
+Destroying a receiver resumes its waiters as timed out, with isOpen() false, so a coroutine
+that loops while the receiver is open ends before the receiver is gone.
+
+Requires -std=c++20.
+*/
+
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <vector>
+
+#include "GP02Serial.h"
+
+class GP02EventLoop;
+class GP02AsyncReceiver;
+class GP02Waiter;
+
+// fire-and-forget coroutine type; the frame is released when the coroutine finishes
+struct GP02Task
+{
+  struct promise_type
+  {
+    GP02Task get_return_object()              { return GP02Task(); }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept   { return {}; }
+    void return_void()                        {}
+    void unhandled_exception()                { std::terminate(); }
+  };
+};
+
+struct GP02Link
+{
+  GP02Link *prev, *next;
+  GP02Waiter *owner;
+
+  explicit GP02Link(GP02Waiter *o = NULL) : prev(this), next(this), owner(o) {}
+  bool linked() const { return next != this; }
+  void unlink()       { prev->next = next; next->prev = prev; prev = next = this; }
+  void insertBefore(GP02Link &pos) { prev = pos.prev; next = &pos; pos.prev->next = this; pos.prev = this; }
+};
+
+class GP02Waiter
+{
+protected:
+  friend class GP02EventLoop;
+  friend class GP02AsyncReceiver;
+
+  GP02Waiter(GP02AsyncReceiver &receiver, const char *sentenceName, std::chrono::milliseconds timeout);
+  GP02Waiter(const GP02Waiter &) = delete;
+  GP02Waiter &operator=(const GP02Waiter &) = delete;
+  ~GP02Waiter();
+  bool suspend(std::coroutine_handle<> h);
+
+  GP02AsyncReceiver &rx;
+  const char *sentence;          // NULL when waiting for a fix
+  int64_t deadline;              // steady clock nanoseconds, INT64_MAX for none
+  std::coroutine_handle<> handle;
+  GP02Link rxLink, timerLink;
+  GP02Fix fix;
+  bool timedOut;                 // also set when the receiver was destroyed
+};
+
+class GP02FixAwaiter : GP02Waiter
+{
+public:
+  GP02FixAwaiter(GP02AsyncReceiver &receiver, std::chrono::milliseconds timeout) : GP02Waiter(receiver, NULL, timeout) {}
+
+  bool await_ready() const noexcept            { return false; }
+  bool await_suspend(std::coroutine_handle<> h) { return suspend(h); }
+  std::optional<GP02Fix> await_resume() const   { return timedOut ? std::nullopt : std::optional<GP02Fix>(fix); }
+};
+
+class GP02SentenceAwaiter : GP02Waiter
+{
+public:
+  GP02SentenceAwaiter(GP02AsyncReceiver &receiver, const char *name, std::chrono::milliseconds timeout) : GP02Waiter(receiver, name, timeout) {}
+
+  bool await_ready() const noexcept            { return false; }
+  bool await_suspend(std::coroutine_handle<> h) { return suspend(h); }
+  bool await_resume() const                     { return !timedOut; }
+};
+
+class GP02AsyncReceiver
+{
+public:
+  GP02AsyncReceiver(GP02EventLoop &loop, const char *path, unsigned long baud, uint8_t terminator = GP02Epoch::None);
+  GP02AsyncReceiver(GP02EventLoop &loop, int fd, unsigned long baud = 0, uint8_t terminator = GP02Epoch::None);
+  ~GP02AsyncReceiver();
+
+  bool isOpen() const;
+  int index() const { return port; }
+
+  // resumes with the next epoch fix, or std::nullopt on timeout or when the receiver is destroyed
+  GP02FixAwaiter nextFix(std::chrono::milliseconds timeout = std::chrono::milliseconds::max())
+  { return GP02FixAwaiter(*this, timeout); }
+
+  // resumes with true once a sentence passes its checksum; "GSV" matches any talker, "BDGSV" only BD;
+  // false on timeout or when the receiver is destroyed
+  GP02SentenceAwaiter nextSentence(const char *name, std::chrono::milliseconds timeout = std::chrono::milliseconds::max())
+  { return GP02SentenceAwaiter(*this, name, timeout); }
+
+  GP02 gps;
+
+private:
+  friend class GP02EventLoop;
+  friend class GP02Waiter;
+  GP02EventLoop &loop;
+  int port;
+  bool closing;                  // in the destructor; new waits complete at once
+  GP02Link waiters;
+
+  void sentenceReceived(const char *name);
+};
+
+class GP02EventLoop
+{
+public:
+  explicit GP02EventLoop(GP02SerialHub &hub);
+
+  void run();                    // until stop() is called
+  void stop() { stopped = true; }
+  int runOnce(int maxWaitMs = -1);
+
+  GP02SerialHub &serialHub() { return hub; }
+  static int64_t now();          // steady clock nanoseconds
+
+private:
+  friend class GP02AsyncReceiver;
+  friend class GP02Waiter;
+  GP02SerialHub &hub;
+  std::vector<GP02AsyncReceiver *> receivers;  // indexed by hub port
+  GP02Link timers;               // sorted by deadline
+  bool stopped;
+
+  void add(GP02AsyncReceiver &rx);
+  void arm(GP02Waiter &w);
+  void expire();
+  static void onSentence(void *context, GP02SerialPort &port, const char *sentence);
+};
+
+#endif // def(GP02Await_h)
@@ -0,0 +1,247 @@
+/*
+GP02Fleet - multi-stream ingest with a lock-free latest-fix store.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+*/
+
+#include "GP02Fleet.h"
+
+#include <math.h>
+
+#define _GP02_FLEET_POLL_MS 50
+
+GP02BoundingBox::GP02BoundingBox(double minLat, double minLng, double maxLat, double maxLng)
+  :  minLatE7((int32_t)lround(minLat * 1e7))
+  ,  minLngE7((int32_t)lround(minLng * 1e7))
+  ,  maxLatE7((int32_t)lround(maxLat * 1e7))
+  ,  maxLngE7((int32_t)lround(maxLng * 1e7))
+{
+}
+
+/**
+ * @brief Tests whether a position lies inside the box, edges included.
+ */
+bool GP02BoundingBox::contains(int32_t latE7, int32_t lngE7) const
+{
+  if (latE7 < minLatE7 || latE7 > maxLatE7)
+    return false;
+  if (minLngE7 <= maxLngE7)
+    return lngE7 >= minLngE7 && lngE7 <= maxLngE7;
+  return lngE7 >= minLngE7 || lngE7 <= maxLngE7;
+}
+
+GP02FleetStore::GP02FleetStore(size_t units)
+  :  count(units)
+  ,  slots(new Slot[units])
+{
+}
+
+/**
+ * @brief Converts RawDegrees to signed 1e-7 degrees, rounding to nearest.
+ */
+int32_t GP02FleetStore::toE7(const RawDegrees &deg)
+{
+  int32_t e7 = (int32_t)(deg.deg * 10000000L + (deg.billionths + 50) / 100);
+  return deg.negative ? -e7 : e7;
+}
+
+/**
+ * @brief Makes a fix the latest one of its unit.
+ *
+ * Only the worker that owns the unit may call this; readers are never blocked.
+ *
+ * @param unit The unit number.
+ * @param fix The completed epoch.
+ * @param rxTime CLOCK_REALTIME nanoseconds of the read that completed the epoch.
+ */
+void GP02FleetStore::publish(uint32_t unit, const GP02Fix &fix, int64_t rxTime)
+{
+  if (unit >= count)
+    return;
+  GP02SeqLock<GP02FleetEntry> &slot = slots[unit].entry;
+  GP02FleetEntry e;
+  e.unit = unit;
+  e.epochs = slot.version() + 1;
+  e.latE7 = toE7(fix.lat);
+  e.lngE7 = toE7(fix.lng);
+  e.rxTime = rxTime;
+  e.fix = fix;
+  slot.store(e);
+}
+
+/**
+ * @brief Copies the latest fix of a unit.
+ *
+ * @return False if the unit does not exist or has not published an epoch yet.
+ */
+bool GP02FleetStore::latest(uint32_t unit, GP02FleetEntry &out) const
+{
+  return unit < count && slots[unit].entry.load(out);
+}
+
+/**
+ * @brief Appends the latest fix of every unit whose position lies inside a box.
+ *
+ * Units whose latest epoch has no location are skipped. Each entry is a consistent
+ * snapshot, but different units may be read at slightly different times.
+ *
+ * @return The number of entries appended.
+ */
+size_t GP02FleetStore::within(const GP02BoundingBox &box, std::vector<GP02FleetEntry> &out) const
+{
+  size_t found = 0;
+  GP02FleetEntry e;
+  for (size_t i = 0; i < count; ++i)
+    if (slots[i].entry.load(e) && e.fix.has(GP02Fix::HasLocation) && box.contains(e.latE7, e.lngE7))
+    {
+      out.push_back(e);
+      ++found;
+    }
+  return found;
+}
+
+/**
+ * @brief Returns the number of epochs published over all units.
+ */
+uint64_t GP02FleetStore::published() const
+{
+  uint64_t total = 0;
+  for (size_t i = 0; i < count; ++i)
+    total += slots[i].entry.version();
+  return total;
+}
+
+GP02FleetServer::GP02FleetServer(unsigned workerThreads, size_t maxUnits)
+  :  fixes(maxUnits)
+  ,  unitCount(0)
+  ,  running(false)
+{
+  if (workerThreads == 0)
+    workerThreads = std::thread::hardware_concurrency();
+  if (workerThreads == 0)
+    workerThreads = 1;
+  for (unsigned i = 0; i < workerThreads; ++i)
+  {
+    workers.push_back(std::unique_ptr<Worker>(new Worker()));
+    workers.back()->server = this;
+    workers.back()->hub.onSentence(onSentence, workers.back().get());
+  }
+}
+
+GP02FleetServer::~GP02FleetServer()
+{
+  stop();
+}
+
+/**
+ * @brief Opens a serial device as a new unit.
+ *
+ * @param path The serial device.
+ * @param baud The line rate of the receiver.
+ * @param terminator The sentence that closes an epoch (see GP02::enableEpochs()).
+ * @return The unit number, or -1 if the device could not be opened, the store is full or
+ * the server is running.
+ */
+int GP02FleetServer::open(const char *path, unsigned long baud, uint8_t terminator)
+{
+  return add(-1, path, baud, terminator);
+}
+
+/**
+ * @brief Adds an already open descriptor (pipe, socket, pseudo-terminal) as a new unit.
+ *
+ * The descriptor remains owned by the caller.
+ *
+ * @return The unit number, or -1 on failure.
+ */
+int GP02FleetServer::attach(int fd, unsigned long baud, uint8_t terminator)
+{
+  return add(fd, NULL, baud, terminator);
+}
+
+int GP02FleetServer::add(int fd, const char *path, unsigned long baud, uint8_t terminator)
+{
+  if (running || unitCount >= fixes.size())
+    return -1;
+
+  // units are dealt round-robin so that every worker gets a similar load
+  Worker &w = *workers[unitCount % workers.size()];
+  std::unique_ptr<Unit> u(new Unit());
+  u->gps.enableEpochs(terminator);
+  u->port = path ? w.hub.open(path, baud, u->gps) : w.hub.attach(fd, u->gps, baud);
+  if (u->port < 0)
+    return -1;
+
+  w.units.push_back((uint32_t)unitCount);
+  unitTable.push_back(std::move(u));
+  return (int)unitCount++;
+}
+
+/**
+ * @brief Starts one thread per worker.
+ *
+ * @return False if the server was already running.
+ */
+bool GP02FleetServer::start()
+{
+  if (running.exchange(true))
+    return false;
+  for (size_t i = 0; i < workers.size(); ++i)
+  {
+    Worker *w = workers[i].get();
+    w->thread = std::thread([this, w]() { run(*w); });
+  }
+  return true;
+}
+
+/**
+ * @brief Stops and joins the worker threads. The latest fixes stay readable.
+ */
+void GP02FleetServer::stop()
+{
+  running = false;
+  for (size_t i = 0; i < workers.size(); ++i)
+    if (workers[i]->thread.joinable())
+      workers[i]->thread.join();
+}
+
+/**
+ * @brief Worker thread body: services the worker's hub until stop() is called.
+ */
+void GP02FleetServer::run(Worker &w)
+{
+  while (running.load(std::memory_order_relaxed))
+    if (w.hub.poll(_GP02_FLEET_POLL_MS) < 0)
+      break;
+}
+
+/**
+ * @brief Hub sentence handler: publishes each epoch as soon as the sentence closing it passes.
+ */
+void GP02FleetServer::onSentence(void *context, GP02SerialPort &port, const char *)
+{
+  Worker &w = *static_cast<Worker *>(context);
+  GP02Epoch &epoch = port.gps().epoch;
+  if (epoch.isUpdated())
+    w.server->fixes.publish(w.units[port.index()], epoch.value(), port.rxTime());
+}
+
+uint64_t GP02FleetServer::bytesRead() const
+{
+  uint64_t total = 0;
+  for (size_t i = 0; i < workers.size(); ++i)
+    for (size_t p = 0; p < workers[i]->hub.portCount(); ++p)
+      total += workers[i]->hub.port((int)p)->bytesRead();
+  return total;
+}
+
+uint32_t GP02FleetServer::failedChecksum() const
+{
+  uint32_t total = 0;
+  for (size_t i = 0; i < unitTable.size(); ++i)
+    total += unitTable[i]->gps.failedChecksum();
+  return total;
+}
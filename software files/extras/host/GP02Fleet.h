@@ -0,0 +1,124 @@
+#ifndef GP02Fleet_h
+#define GP02Fleet_h
+
+/*
+GP02Fleet - multi-stream ingest with a lock-free latest-fix store.
+
+A GP02FleetServer runs one GP02 parser per unit (serial port, pipe or socket) on a pool of
+worker threads. Each worker owns a GP02SerialHub for its share of the units and publishes
+every completed epoch into a GP02FleetStore. The store has one GP02SeqLock slot per unit,
+so any number of reader threads can ask "where is unit X" or "which units are inside this
+box" without taking a lock and without slowing the workers down:
+
+   GP02FleetServer server(4);
+   int unit = server.open("/dev/ttyUSB0", 9600);
+   server.start();
+   ...
+   GP02FleetEntry e;
+   if (server.store().latest(unit, e)) ...
+
+Units are added before start(); the store is sized once and never reallocated, which is
+what lets readers index it without synchronisation. See gp02fleet.cpp for a benchmark
+driven by GP02Synth streams.
+*/
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "GP02SeqLock.h"
+#include "GP02Serial.h"
+
+struct GP02FleetEntry
+{
+  uint32_t unit;
+  uint32_t epochs;               // epochs published for this unit so far
+  int32_t latE7, lngE7;          // signed 1e-7 degrees, for bounding-box tests
+  int64_t rxTime;                // CLOCK_REALTIME ns of the read that completed the epoch
+  GP02Fix fix;
+};
+
+// Latitude/longitude box in 1e-7 degrees; minLng > maxLng wraps across the antimeridian.
+struct GP02BoundingBox
+{
+  int32_t minLatE7, minLngE7, maxLatE7, maxLngE7;
+
+  GP02BoundingBox(double minLat, double minLng, double maxLat, double maxLng);
+  bool contains(int32_t latE7, int32_t lngE7) const;
+};
+
+class GP02FleetStore
+{
+public:
+  explicit GP02FleetStore(size_t units);
+
+  void publish(uint32_t unit, const GP02Fix &fix, int64_t rxTime);   // one writer per unit
+
+  bool latest(uint32_t unit, GP02FleetEntry &out) const;
+  size_t within(const GP02BoundingBox &box, std::vector<GP02FleetEntry> &out) const;
+
+  size_t size() const { return count; }
+  uint64_t published() const;
+
+  static int32_t toE7(const RawDegrees &deg);
+
+private:
+  // slots start on their own cache line so that workers on different cores do not share lines
+  struct alignas(64) Slot
+  {
+    GP02SeqLock<GP02FleetEntry> entry;
+  };
+
+  size_t count;
+  std::unique_ptr<Slot[]> slots;
+};
+
+class GP02FleetServer
+{
+public:
+  explicit GP02FleetServer(unsigned workers = 0, size_t maxUnits = 1024);   // 0 = one per core
+  ~GP02FleetServer();
+
+  // add units before start(); each returns the unit number or -1
+  int open(const char *path, unsigned long baud, uint8_t terminator = GP02Epoch::None);
+  int attach(int fd, unsigned long baud = 0, uint8_t terminator = GP02Epoch::None);
+
+  bool start();
+  void stop();
+
+  GP02FleetStore &store()        { return fixes; }
+  size_t units() const           { return unitCount; }
+  unsigned workerCount() const   { return (unsigned)workers.size(); }
+
+  // totals over all units; only meaningful once stop() has returned
+  uint64_t bytesRead() const;
+  uint32_t failedChecksum() const;
+
+private:
+  struct Unit
+  {
+    GP02 gps;
+    int port;                    // index in the owning worker's hub
+  };
+
+  struct Worker
+  {
+    GP02FleetServer *server;
+    GP02SerialHub hub;
+    std::vector<uint32_t> units; // unit numbers, indexed by hub port
+    std::thread thread;
+  };
+
+  GP02FleetStore fixes;
+  std::vector<std::unique_ptr<Unit> > unitTable;
+  std::vector<std::unique_ptr<Worker> > workers;
+  size_t unitCount;
+  std::atomic<bool> running;
+
+  int add(int fd, const char *path, unsigned long baud, uint8_t terminator);
+  void run(Worker &w);
+  static void onSentence(void *context, GP02SerialPort &port, const char *sentence);
+};
+
+#endif // def(GP02Fleet_h)
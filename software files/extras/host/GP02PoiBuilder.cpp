@@ -0,0 +1,95 @@
+/*
+GP02PoiBuilder - builds the blob searched by GP02PoiIndex.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+*/
+
+#include "GP02PoiBuilder.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @brief Arranges the points into tree order. Called by blob() when points were added.
+ */
+void GP02PoiBuilder::build()
+{
+  arrange(0, points.size(), 0);
+  built = true;
+}
+
+// must pick the same median and axis as GP02PoiIndex::searchNearest()
+void GP02PoiBuilder::arrange(size_t lo, size_t hi, unsigned axis)
+{
+  while (hi - lo > 1)
+  {
+    size_t mid = lo + (hi - lo) / 2;
+    std::nth_element(points.begin() + lo, points.begin() + mid, points.begin() + hi,
+      [axis](const GP02PoiPoint &a, const GP02PoiPoint &b)
+      { return axis == 0 ? a.x < b.x : axis == 1 ? a.y < b.y : a.z < b.z; });
+    unsigned next = axis == 2 ? 0 : axis + 1;
+    arrange(lo, mid, next);
+    lo = mid + 1;
+    axis = next;
+  }
+}
+
+/**
+ * @brief Returns the header and the points in tree order, ready for GP02PoiIndex::attach().
+ */
+const std::vector<uint8_t> &GP02PoiBuilder::blob()
+{
+  if (!built)
+    build();
+  GP02PoiHeader h;
+  memset(&h, 0, sizeof(h));
+  h.magic = _GPS_POI_MAGIC;
+  h.version = _GPS_POI_VERSION;
+  h.pointSize = sizeof(GP02PoiPoint);
+  h.count = (uint32_t)points.size();
+
+  bytes.resize(sizeof(h) + points.size() * sizeof(GP02PoiPoint));
+  memcpy(bytes.data(), &h, sizeof(h));
+  if (!points.empty())
+    memcpy(bytes.data() + sizeof(h), points.data(), points.size() * sizeof(GP02PoiPoint));
+  return bytes;
+}
+
+/**
+ * @brief Writes the blob to a file, e.g. for mmap() on the host.
+ */
+bool GP02PoiBuilder::writeBlob(const char *path)
+{
+  const std::vector<uint8_t> &b = blob();
+  FILE *f = fopen(path, "wb");
+  if (f == NULL)
+    return false;
+  bool ok = fwrite(b.data(), 1, b.size(), f) == b.size();
+  return fclose(f) == 0 && ok;
+}
+
+/**
+ * @brief Writes the blob as an aligned const array for targets with memory-mapped flash.
+ *
+ * @param path The header file to create.
+ * @param name The identifier of the array; NAME_size holds its length.
+ */
+bool GP02PoiBuilder::writeHeader(const char *path, const char *name)
+{
+  const std::vector<uint8_t> &b = blob();
+  FILE *f = fopen(path, "w");
+  if (f == NULL)
+    return false;
+  fprintf(f, "// generated by gp02poi: %zu points for GP02PoiIndex::attach(%s, %s_size)\n", points.size(), name, name);
+  fprintf(f, "#include <stddef.h>\n#include <stdint.h>\n\n");
+  fprintf(f, "static const size_t %s_size = %zu;\n", name, b.size());
+  fprintf(f, "alignas(4) static const uint8_t %s[] = {", name);
+  for (size_t i = 0; i < b.size(); ++i)
+    fprintf(f, "%s0x%02x,", i % 16 ? " " : "\n  ", b[i]);
+  fprintf(f, "\n};\n");
+  return fclose(f) == 0;
+}
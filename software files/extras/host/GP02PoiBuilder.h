@@ -0,0 +1,48 @@
+#ifndef GP02PoiBuilder_h
+#define GP02PoiBuilder_h
+
+/*
+GP02PoiBuilder - builds the blob searched by GP02PoiIndex.
+
+Points are collected, arranged into an implicit k-d tree (median of each range in its middle,
+split axis cycling x, y, z with depth, exactly as GP02PoiIndex walks it) and written out as a
+file to memory-map on the host, or as a C array to compile into firmware:
+
+   GP02PoiBuilder b;
+   b.add(41.0082, 28.9784, 1);
+   ...
+   b.writeBlob("depots.poi");
+   b.writeHeader("depots.h", "depots");
+
+Building sorts in place with nth_element, O(n log n) time and no memory beyond the points.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "GP02PoiIndex.h"
+
+class GP02PoiBuilder
+{
+public:
+  GP02PoiBuilder() : built(false) {}
+
+  void reserve(size_t n)         { points.reserve(n); }
+  void add(double lat, double lng, uint32_t id) { points.push_back(GP02PoiIndex::point(lat, lng, id)); built = false; }
+  size_t size() const            { return points.size(); }
+
+  void build();
+  const std::vector<uint8_t> &blob();
+  bool writeBlob(const char *path);
+  bool writeHeader(const char *path, const char *name);
+
+private:
+  std::vector<GP02PoiPoint> points;
+  std::vector<uint8_t> bytes;
+  bool built;
+
+  void arrange(size_t lo, size_t hi, unsigned axis);
+};
+
+#endif // def(GP02PoiBuilder_h)
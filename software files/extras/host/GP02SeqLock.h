@@ -0,0 +1,92 @@
+#ifndef GP02SeqLock_h
+#define GP02SeqLock_h
+
+/*
+GP02SeqLock - single-writer, multi-reader sequence lock for small trivially copyable values.
+
+The writer never blocks and readers never write shared memory, so any number of reader
+threads (or processes, when the object lives in shared memory) can poll a value that one
+thread keeps updating:
+
+   GP02SeqLock<GP02Fix> latest;
+   latest.store(fix);                 // writer thread
+   GP02Fix copy;
+   if (latest.load(copy)) ...         // any reader
+
+The sequence number is odd while a store is in progress. The payload is kept in relaxed
+atomic words rather than a plain T, so a reader that races with the writer copies torn but
+well-defined data, notices the sequence change and retries; there is no data race in the
+C++ memory model sense. Lock-free 64-bit atomics also make the layout usable across
+processes.
+*/
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+template <typename T>
+class GP02SeqLock
+{
+public:
+  static_assert(std::is_trivially_copyable<T>::value, "GP02SeqLock needs a trivially copyable type");
+
+  GP02SeqLock() : seq(0)
+  {
+    for (size_t i = 0; i < Words; ++i)
+      words[i].store(0, std::memory_order_relaxed);
+  }
+
+  // only one thread may store at a time
+  void store(const T &value)
+  {
+    uint64_t buf[Words] = {};
+    memcpy(buf, &value, sizeof(T));
+    uint32_t s = seq.load(std::memory_order_relaxed);
+    seq.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < Words; ++i)
+      words[i].store(buf[i], std::memory_order_relaxed);
+    seq.store(s + 2, std::memory_order_release);
+  }
+
+  // one attempt; false if a store was in progress or nothing has been stored yet
+  bool tryLoad(T &out) const
+  {
+    uint32_t s = seq.load(std::memory_order_acquire);
+    if (s == 0 || (s & 1))
+      return false;
+    uint64_t buf[Words];
+    for (size_t i = 0; i < Words; ++i)
+      buf[i] = words[i].load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (seq.load(std::memory_order_relaxed) != s)
+      return false;
+    memcpy(&out, buf, sizeof(T));
+    return true;
+  }
+
+  // retries until a consistent copy is read; false if nothing has been stored yet
+  bool load(T &out) const
+  {
+    for (;;)
+    {
+      if (tryLoad(out))
+        return true;
+      if (seq.load(std::memory_order_relaxed) == 0)
+        return false;
+    }
+  }
+
+  // number of completed stores
+  uint32_t version() const { return seq.load(std::memory_order_acquire) / 2; }
+
+private:
+  static const size_t Words = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+  std::atomic<uint32_t> seq;
+  std::atomic<uint64_t> words[Words];
+};
+
+#endif // def(GP02SeqLock_h)
@@ -0,0 +1,336 @@
+/*
+GP02Serial - Linux termios/epoll backend feeding GP02 parsers.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+*/
+
+#include "GP02Serial.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define _GP02_SERIAL_MAX_EVENTS 64
+
+static speed_t baudConstant(unsigned long baud)
+{
+  switch (baud)
+  {
+  case 4800: return B4800;
+  case 9600: return B9600;
+  case 19200: return B19200;
+  case 38400: return B38400;
+  case 57600: return B57600;
+  case 115200: return B115200;
+  case 230400: return B230400;
+  case 460800: return B460800;
+  case 921600: return B921600;
+  default: return B0;
+  }
+}
+
+GP02SerialHub::GP02SerialHub()
+  :  epfd(epoll_create1(EPOLL_CLOEXEC))
+  ,  sentenceHandler(NULL)
+  ,  handlerContext(NULL)
+{
+}
+
+GP02SerialHub::~GP02SerialHub()
+{
+  for (size_t i = 0; i < ports.size(); ++i)
+    close((int)i);
+  if (epfd >= 0)
+    ::close(epfd);
+}
+
+/**
+ * @brief Returns the current CLOCK_REALTIME time in nanoseconds.
+ */
+int64_t GP02SerialHub::now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * @brief Puts a terminal into raw, non-blocking 8N1 mode at the given baud rate.
+ *
+ * Canonical processing, echo, signals, flow control and CR/LF translation are disabled so
+ * that NMEA bytes reach the parser untouched. VMIN and VTIME are zero because readiness is
+ * signalled by epoll rather than by blocking reads.
+ *
+ * @param fd An open terminal descriptor.
+ * @param baud The line rate, or 0 to keep the current rate (pseudo-terminals).
+ * @return True on success.
+ */
+bool GP02SerialHub::configure(int fd, unsigned long baud)
+{
+  struct termios tio;
+  if (tcgetattr(fd, &tio) < 0)
+    return false;
+
+  cfmakeraw(&tio);
+  tio.c_cflag |= CLOCAL | CREAD;
+  tio.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+  tio.c_iflag &= ~(IXON | IXOFF | IXANY);
+  tio.c_cc[VMIN] = 0;
+  tio.c_cc[VTIME] = 0;
+
+  if (baud != 0)
+  {
+    speed_t speed = baudConstant(baud);
+    if (speed == B0 || cfsetispeed(&tio, speed) < 0 || cfsetospeed(&tio, speed) < 0)
+      return false;
+  }
+
+  if (tcsetattr(fd, TCSANOW, &tio) < 0)
+    return false;
+  tcflush(fd, TCIFLUSH);
+
+  int flags = fcntl(fd, F_GETFL);
+  return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+/**
+ * @brief Opens a serial device and adds it to the hub.
+ *
+ * @param path The device, e.g. "/dev/ttyS1" or the slave side of a pseudo-terminal.
+ * @param baud The line rate of the receiver.
+ * @param gps The parser that receives this port's bytes.
+ * @return The port index, or -1 if the device could not be opened or configured.
+ */
+int GP02SerialHub::open(const char *path, unsigned long baud, GP02 &gps)
+{
+  int fd = ::open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0)
+    return -1;
+  if (!configure(fd, baud))
+  {
+    ::close(fd);
+    return -1;
+  }
+  int index = attach(fd, gps, baud, true);
+  if (index < 0)
+    ::close(fd);
+  return index;
+}
+
+/**
+ * @brief Adds an already open descriptor to the hub.
+ *
+ * Terminals are expected to be configured already (see configure()); sockets get kernel
+ * receive timestamps enabled. The descriptor is switched to non-blocking mode.
+ *
+ * @param fd The descriptor to read from.
+ * @param gps The parser that receives this port's bytes.
+ * @param baud The line rate, used to estimate first-byte times; 0 if unknown.
+ * @param takeOwnership If true the hub closes fd when the port is closed.
+ * @return The port index, or -1 on failure.
+ */
+int GP02SerialHub::attach(int fd, GP02 &gps, unsigned long baud, bool takeOwnership)
+{
+  if (epfd < 0 || fd < 0)
+    return -1;
+
+  std::unique_ptr<GP02SerialPort> p(new GP02SerialPort());
+  p->parser = &gps;
+  p->handle = fd;
+  p->slot = (int)ports.size();
+  p->owned = takeOwnership;
+  p->baudRate = baud;
+  p->lastRxTime = p->firstByteTime = 0;
+  p->bytes = 0;
+  p->readCount = 0;
+  p->sentenceId[0] = '\0';
+  p->sentenceOffset = sizeof(p->sentenceId);
+
+  struct stat st;
+  p->socket = fstat(fd, &st) == 0 && S_ISSOCK(st.st_mode);
+  if (p->socket)
+  {
+    int on = 1;
+    p->socket = setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) == 0;
+  }
+
+  int flags = fcntl(fd, F_GETFL);
+  if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+    return -1;
+
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.u32 = (uint32_t)p->slot;
+  if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+    return -1;
+
+  ports.push_back(std::move(p));
+  return ports.back()->slot;
+}
+
+/**
+ * @brief Removes a port from the hub, closing its descriptor if the hub owns it.
+ *
+ * @param index The port index returned by open() or attach().
+ */
+void GP02SerialHub::close(int index)
+{
+  GP02SerialPort *p = port(index);
+  if (p == NULL || p->handle < 0)
+    return;
+  epoll_ctl(epfd, EPOLL_CTL_DEL, p->handle, NULL);
+  if (p->owned)
+    ::close(p->handle);
+  p->handle = -1;
+}
+
+/**
+ * @brief Waits for input on any port and drains every port that is ready.
+ *
+ * @param timeoutMs The maximum time to wait in milliseconds, or -1 to wait indefinitely.
+ * @return The number of valid sentences parsed, or -1 if epoll_wait failed.
+ */
+int GP02SerialHub::poll(int timeoutMs)
+{
+  struct epoll_event events[_GP02_SERIAL_MAX_EVENTS];
+  int n = epoll_wait(epfd, events, _GP02_SERIAL_MAX_EVENTS, timeoutMs);
+  if (n < 0)
+    return errno == EINTR ? 0 : -1;
+
+  int sentences = 0;
+  for (int i = 0; i < n; ++i)
+  {
+    GP02SerialPort *p = port((int)events[i].data.u32);
+    if (p != NULL && p->handle >= 0)
+      sentences += drain(*p);
+  }
+  return sentences;
+}
+
+/**
+ * @brief Reads a socket port with recvmsg() to pick up its kernel receive timestamp.
+ */
+ssize_t GP02SerialHub::readSocket(GP02SerialPort &p, char *buf, size_t size)
+{
+  struct iovec iov = { buf, size };
+  char control[CMSG_SPACE(sizeof(struct timespec))];
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+
+  ssize_t r = recvmsg(p.handle, &msg, 0);
+  if (r > 0)
+    for (struct cmsghdr *c = CMSG_FIRSTHDR(&msg); c != NULL; c = CMSG_NXTHDR(&msg, c))
+      if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS)
+      {
+        struct timespec ts;
+        memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+        p.lastRxTime = (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+      }
+  return r;
+}
+
+/**
+ * @brief Reads a ready port until it would block and feeds the parser.
+ *
+ * @return The number of valid sentences parsed.
+ */
+int GP02SerialHub::drain(GP02SerialPort &p)
+{
+  char buf[_GP02_SERIAL_READ_SIZE];
+  int sentences = 0;
+
+  for (;;)
+  {
+    ssize_t r = p.socket ? readSocket(p, buf, sizeof(buf)) : read(p.handle, buf, sizeof(buf));
+    if (r < 0 && errno == EINTR)
+      continue;
+    if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      break;
+    if (r <= 0)
+    {
+      // EOF or a hang-up (e.g. the pseudo-terminal master went away)
+      close(p.slot);
+      break;
+    }
+
+    if (!p.socket)
+      p.lastRxTime = now();
+    // at 8N1 every byte occupies ten bit times on the wire
+    p.firstByteTime = p.baudRate ? p.lastRxTime - (int64_t)(r - 1) * 10000000000LL / (int64_t)p.baudRate : p.lastRxTime;
+    p.bytes += (uint64_t)r;
+    ++p.readCount;
+    sentences += (int)feed(p, buf, (size_t)r);
+
+    if ((size_t)r < sizeof(buf))
+      break;
+  }
+  return sentences;
+}
+
+/**
+ * @brief Hands a block of received bytes to the port's parser.
+ *
+ * Without a sentence handler the block goes to GP02::encode() in one call. With a handler the
+ * block is cut after every line end, where sentences complete, and each piece is still encoded
+ * in one call; the handler runs, with the sentence identifier, when a piece completes a
+ * sentence. Only the few bytes after the last '$' of a piece are looked at for the identifier.
+ */
+size_t GP02SerialHub::feed(GP02SerialPort &p, const char *data, size_t length)
+{
+  if (sentenceHandler == NULL)
+    return p.parser->encode(data, length);
+
+  size_t sentences = 0;
+  const char *end = data + length;
+  while (data < end && p.handle >= 0)
+  {
+    const char *next = data;
+    while (next < end && *next != '\r' && *next != '\n')
+      ++next;
+    if (next < end)
+      ++next;
+
+    // the identifier of the sentence this piece ends in
+    const char *id = (const char *)memrchr(data, '$', (size_t)(next - data));
+    if (id != NULL)
+    {
+      p.sentenceOffset = 0;
+      p.sentenceId[0] = '\0';
+      ++id;
+    }
+    else
+      id = data;
+    for (; id < next && p.sentenceOffset < sizeof(p.sentenceId) - 1; ++id)
+    {
+      if (*id == ',' || *id == '*')
+        p.sentenceOffset = sizeof(p.sentenceId) - 1;
+      else
+      {
+        p.sentenceId[p.sentenceOffset++] = *id;
+        p.sentenceId[p.sentenceOffset] = '\0';
+      }
+    }
+
+    for (size_t n = p.parser->encode(data, (size_t)(next - data)); n > 0 && p.handle >= 0; --n)
+    {
+      ++sentences;
+      sentenceHandler(handlerContext, p, p.sentenceId);
+    }
+    data = next;
+  }
+  return sentences;
+}
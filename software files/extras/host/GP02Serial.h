@@ -0,0 +1,102 @@
+#ifndef GP02Serial_h
+#define GP02Serial_h
+
+/*
+GP02Serial - Linux termios/epoll backend feeding GP02 parsers.
+
+One GP02SerialHub multiplexes any number of receivers in a single thread. Each port is put
+in raw, non-blocking 8N1 mode, drained with large reads whenever epoll reports it readable,
+and handed to its GP02 object in bulk. Ports can be opened by path (/dev/ttyS*, /dev/ttyUSB*)
+or attached as already open descriptors, which makes the hub testable with a pseudo-terminal
+pair and no hardware:
+
+   int master = posix_openpt(O_RDWR | O_NOCTTY); grantpt(master); unlockpt(master);
+   hub.open(ptsname(master), 9600, gps);
+   write(master, nmea, len);
+   hub.poll(100);
+
+Receive timestamps: tty drivers do not timestamp bytes, so the hub stamps each read with
+CLOCK_REALTIME right after it completes and estimates when the first byte of the read was on
+the wire from the configured baud rate. Descriptors that are sockets (e.g. a ser2net TCP
+bridge) use the kernel's SO_TIMESTAMPNS receive time instead.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include "GP02.h"
+
+#define _GP02_SERIAL_READ_SIZE 4096
+
+class GP02SerialPort
+{
+public:
+  GP02 &gps()                    { return *parser; }
+  int fd() const                 { return handle; }
+  int index() const              { return slot; }
+  unsigned long baud() const     { return baudRate; }
+
+  // CLOCK_REALTIME nanoseconds: last byte of the most recent read, and estimated first byte
+  int64_t rxTime() const         { return lastRxTime; }
+  int64_t rxFirstByteTime() const { return firstByteTime; }
+  bool kernelTimestamps() const  { return socket; }
+
+  // the sentence currently being received, e.g. "GNRMC" (only tracked when a handler is set)
+  const char *sentence() const   { return sentenceId; }
+
+  uint64_t bytesRead() const     { return bytes; }
+  uint32_t reads() const         { return readCount; }
+  bool isOpen() const            { return handle >= 0; }
+
+private:
+  friend class GP02SerialHub;
+  GP02 *parser;
+  int handle;
+  int slot;
+  bool owned, socket;
+  unsigned long baudRate;
+  int64_t lastRxTime, firstByteTime;
+  uint64_t bytes;
+  uint32_t readCount;
+  char sentenceId[6];
+  uint8_t sentenceOffset;
+};
+
+// called once per sentence that passed its checksum
+typedef void (*GP02SentenceHandler)(void *context, GP02SerialPort &port, const char *sentence);
+
+class GP02SerialHub
+{
+public:
+  GP02SerialHub();
+  ~GP02SerialHub();
+
+  int open(const char *path, unsigned long baud, GP02 &gps);
+  int attach(int fd, GP02 &gps, unsigned long baud = 0, bool takeOwnership = false);
+  void close(int port);
+
+  int poll(int timeoutMs);       // wait once and drain every ready port; returns valid sentences
+
+  void onSentence(GP02SentenceHandler handler, void *context) { sentenceHandler = handler; handlerContext = context; }
+
+  GP02SerialPort *port(int index) { return index >= 0 && (size_t)index < ports.size() ? ports[index].get() : NULL; }
+  size_t portCount() const        { return ports.size(); }
+  int epollFd() const             { return epfd; }
+
+  static bool configure(int fd, unsigned long baud);
+  static int64_t now();
+
+private:
+  int epfd;
+  std::vector<std::unique_ptr<GP02SerialPort> > ports;
+  GP02SentenceHandler sentenceHandler;
+  void *handlerContext;
+
+  int drain(GP02SerialPort &p);
+  size_t feed(GP02SerialPort &p, const char *data, size_t length);
+  ssize_t readSocket(GP02SerialPort &p, char *buf, size_t size);
+};
+
+#endif // def(GP02Serial_h)
@@ -0,0 +1,243 @@
+/*
+GP02Shm - publishes GP02 fixes into a POSIX shared-memory ring for multi-process consumers.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+*/
+
+#include "GP02Shm.h"
+
+#include <fcntl.h>
+#include <new>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "GP02Shm needs lock-free 64-bit atomics");
+
+// slots start on a cache line boundary after the header
+static size_t slotOffset()
+{
+  return (sizeof(GP02ShmHeader) + 63) & ~(size_t)63;
+}
+
+static size_t mappingSize(uint32_t capacity)
+{
+  return slotOffset() + (size_t)capacity * sizeof(GP02SeqLock<GP02ShmRecord>);
+}
+
+/**
+ * @brief Creates (or replaces) a shared-memory ring.
+ *
+ * An existing object of the same name is unlinked first; readers that still map it see
+ * isLive() turn false and should reopen.
+ *
+ * @param name The POSIX shared-memory name, e.g. "/gp02".
+ * @param capacity The number of records kept; rounded up to a power of two.
+ */
+GP02ShmWriter::GP02ShmWriter(const char *shmName, uint32_t capacity)
+  :  base(MAP_FAILED)
+  ,  length(0)
+  ,  header(NULL)
+  ,  slots(NULL)
+{
+  snprintf(name, sizeof(name), "%s", shmName);
+  uint32_t cap = 2;
+  while (cap < capacity && cap < 0x80000000UL)
+    cap <<= 1;
+
+  shm_unlink(name);
+  int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0644);
+  if (fd < 0)
+    return;
+  length = mappingSize(cap);
+  if (ftruncate(fd, (off_t)length) == 0)
+    base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED)
+  {
+    shm_unlink(name);
+    return;
+  }
+
+  GP02ShmHeader *h = static_cast<GP02ShmHeader *>(base);
+  h->layout = _GP02_SHM_LAYOUT;
+  h->recordSize = sizeof(GP02ShmRecord);
+  h->capacity = cap;
+  new (&h->live) std::atomic<uint32_t>(1);
+  new (&h->head) std::atomic<uint64_t>(0);
+  slots = reinterpret_cast<GP02SeqLock<GP02ShmRecord> *>(static_cast<char *>(base) + slotOffset());
+  for (uint32_t i = 0; i < cap; ++i)
+    new (&slots[i]) GP02SeqLock<GP02ShmRecord>();
+
+  // readers check the magic number last, so it is written last
+  std::atomic_thread_fence(std::memory_order_release);
+  h->magic = _GP02_SHM_MAGIC;
+  header = h;
+}
+
+/**
+ * @brief Marks the ring dead for current readers and removes its name.
+ */
+GP02ShmWriter::~GP02ShmWriter()
+{
+  if (header == NULL)
+    return;
+  header->live.store(0, std::memory_order_release);
+  munmap(base, length);
+  shm_unlink(name);
+}
+
+/**
+ * @brief Appends a fix to the ring, overwriting the oldest record when it is full.
+ *
+ * @param fix The fix, typically GP02::epoch.value().
+ * @param rxTime The receive time in CLOCK_REALTIME nanoseconds, or 0.
+ * @param source A publisher defined tag, e.g. the serial port index.
+ * @return The sequence number of the new record.
+ */
+uint64_t GP02ShmWriter::publish(const GP02Fix &fix, int64_t rxTime, uint32_t source)
+{
+  if (header == NULL)
+    return 0;
+  GP02ShmRecord r;
+  r.sequence = header->head.load(std::memory_order_relaxed);
+  r.rxTime = rxTime;
+  r.source = source;
+  r.fix = fix;
+  slots[r.sequence & (header->capacity - 1)].store(r);
+  header->head.store(r.sequence + 1, std::memory_order_release);
+  return r.sequence;
+}
+
+/**
+ * @brief Maps an existing ring read-only.
+ *
+ * isOpen() is false if the ring does not exist, is still being created, or was built with a
+ * different record layout.
+ *
+ * @param name The POSIX shared-memory name used by the writer.
+ */
+GP02ShmReader::GP02ShmReader(const char *name)
+  :  base(MAP_FAILED)
+  ,  length(0)
+  ,  header(NULL)
+  ,  slots(NULL)
+{
+  int fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+  if (fd < 0)
+    return;
+  struct stat st;
+  if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(GP02ShmHeader))
+  {
+    length = (size_t)st.st_size;
+    base = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (base == MAP_FAILED)
+    return;
+
+  const GP02ShmHeader *h = static_cast<const GP02ShmHeader *>(base);
+  bool ok = h->magic == _GP02_SHM_MAGIC;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  ok = ok && h->layout == _GP02_SHM_LAYOUT && h->recordSize == sizeof(GP02ShmRecord)
+       && h->capacity >= 2 && (h->capacity & (h->capacity - 1)) == 0 && length >= mappingSize(h->capacity);
+  if (!ok)
+  {
+    munmap(const_cast<void *>(base), length);
+    base = MAP_FAILED;
+    return;
+  }
+  header = h;
+  slots = reinterpret_cast<const GP02SeqLock<GP02ShmRecord> *>(static_cast<const char *>(base) + slotOffset());
+}
+
+GP02ShmReader::~GP02ShmReader()
+{
+  if (base != MAP_FAILED)
+    munmap(const_cast<void *>(base), length);
+}
+
+/**
+ * @brief Copies the record with the given sequence number.
+ *
+ * @return False if the reader is not open, or the record has not been published yet, has
+ * already been overwritten or is being overwritten right now.
+ */
+bool GP02ShmReader::at(uint64_t sequence, GP02ShmRecord &out) const
+{
+  if (header == NULL)
+    return false;
+  uint64_t h = head();
+  if (sequence >= h || h - sequence > header->capacity)
+    return false;
+  // a failed or mismatching copy means the writer has lapped this slot
+  return slots[sequence & (header->capacity - 1)].tryLoad(out) && out.sequence == sequence;
+}
+
+/**
+ * @brief Copies the most recent record.
+ *
+ * @return False if nothing has been published yet.
+ */
+bool GP02ShmReader::latest(GP02ShmRecord &out) const
+{
+  if (header == NULL)
+    return false;
+  for (;;)
+  {
+    uint64_t h = head();
+    if (h == 0)
+      return false;
+    if (at(h - 1, out))
+      return true;
+  }
+}
+
+/**
+ * @brief Copies the record at a cursor and advances it, for following the ring in order.
+ *
+ * Start with cursor 0 for the oldest retained record or head() for new ones only. When the
+ * reader has fallen more than capacity() records behind, the cursor jumps to the oldest
+ * record still retained. A record that cannot be copied in _GP02_SHM_RETRIES attempts is
+ * skipped and counted as lost: its slot is stuck mid-store because the writer died in
+ * publish(), and waiting for it would never end.
+ *
+ * @param cursor The next sequence number to read; advanced past the returned record.
+ * @param out Receives the record.
+ * @param lost If not NULL, incremented by the number of records skipped.
+ * @return False if no record at or after the cursor has been published yet.
+ */
+bool GP02ShmReader::next(uint64_t &cursor, GP02ShmRecord &out, uint64_t *lost) const
+{
+  if (header == NULL)
+    return false;
+  for (unsigned attempts = 0; ; )
+  {
+    uint64_t h = head();
+    if (cursor >= h)
+      return false;
+    if (h - cursor > header->capacity)
+    {
+      if (lost)
+        *lost += h - header->capacity - cursor;
+      cursor = h - header->capacity;
+      attempts = 0;
+    }
+    if (at(cursor, out))
+    {
+      ++cursor;
+      return true;
+    }
+    if (++attempts >= _GP02_SHM_RETRIES)
+    {
+      if (lost)
+        ++*lost;
+      ++cursor;
+      attempts = 0;
+    }
+  }
+}
@@ -0,0 +1,105 @@
+#ifndef GP02Shm_h
+#define GP02Shm_h
+
+/*
+GP02Shm - publishes GP02 fixes into a POSIX shared-memory ring for multi-process consumers.
+
+One process owns the receiver and a GP02ShmWriter; any number of other processes (logger,
+navigation, telemetry) map the ring read-only with a GP02ShmReader. Every record carries a
+sequence number and sits in its own GP02SeqLock, so readers copy the latest or any still
+retained historical fix straight out of the mapping with no syscall, no lock and no
+cooperation from the writer:
+
+   GP02ShmWriter ring("/gp02", 256);             // owner of the serial port
+   ring.publish(gps.epoch.value(), rxTime);
+
+   GP02ShmReader ring("/gp02");                  // any other process
+   GP02ShmRecord r;
+   if (ring.latest(r)) ...
+   for (uint64_t cursor = 0; ring.next(cursor, r); ) ...
+
+Records are overwritten after capacity newer ones; next() skips ahead and reports how many
+were lost when a reader falls behind, and also skips a record whose slot stays mid-store,
+which is what a writer that died during publish() leaves behind. The layout is versioned and checked on open, so readers
+built from a different GP02Fix layout refuse to attach. Readers rely on 64-bit atomic loads
+from a read-only mapping, which is fine on x86-64 and AArch64.
+
+See gp02shm.cpp for a publisher that feeds the ring from serial ports and a reader.
+*/
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "GP02.h"
+#include "GP02SeqLock.h"
+
+#define _GP02_SHM_MAGIC 0x47503032UL // "GP02"
+#define _GP02_SHM_LAYOUT 1
+#define _GP02_SHM_RETRIES 4096 // failed copies of one slot before next() counts its record as lost
+
+struct GP02ShmRecord
+{
+  uint64_t sequence;             // 0 for the first fix ever published to this ring
+  int64_t rxTime;                // CLOCK_REALTIME ns, as GP02SerialPort::rxTime()
+  uint32_t source;               // publisher defined, e.g. the serial port index
+  GP02Fix fix;
+};
+
+struct GP02ShmHeader
+{
+  uint32_t magic;
+  uint32_t layout;
+  uint32_t recordSize;           // sizeof(GP02ShmRecord) as built by the writer
+  uint32_t capacity;             // records in the ring, a power of two
+  std::atomic<uint32_t> live;    // cleared when the writer goes away
+  std::atomic<uint64_t> head;    // sequence number of the next record
+};
+
+class GP02ShmWriter
+{
+public:
+  GP02ShmWriter(const char *name, uint32_t capacity = 256);
+  ~GP02ShmWriter();
+
+  bool isOpen() const            { return header != NULL; }
+  uint64_t publish(const GP02Fix &fix, int64_t rxTime = 0, uint32_t source = 0);
+  uint64_t published() const     { return header ? header->head.load(std::memory_order_relaxed) : 0; }
+
+  GP02ShmWriter(const GP02ShmWriter &) = delete;
+  GP02ShmWriter &operator=(const GP02ShmWriter &) = delete;
+
+private:
+  char name[64];
+  void *base;
+  size_t length;
+  GP02ShmHeader *header;
+  GP02SeqLock<GP02ShmRecord> *slots;
+};
+
+class GP02ShmReader
+{
+public:
+  explicit GP02ShmReader(const char *name);
+  ~GP02ShmReader();
+
+  bool isOpen() const            { return header != NULL; }
+  bool isLive() const            { return header && header->live.load(std::memory_order_acquire); }
+  uint32_t capacity() const      { return header ? header->capacity : 0; }
+  uint64_t head() const          { return header ? header->head.load(std::memory_order_acquire) : 0; }
+
+  bool latest(GP02ShmRecord &out) const;
+  bool at(uint64_t sequence, GP02ShmRecord &out) const;
+  bool next(uint64_t &cursor, GP02ShmRecord &out, uint64_t *lost = NULL) const;
+
+  GP02ShmReader(const GP02ShmReader &) = delete;
+  GP02ShmReader &operator=(const GP02ShmReader &) = delete;
+
+private:
+  const void *base;
+  size_t length;
+  const GP02ShmHeader *header;
+  const GP02SeqLock<GP02ShmRecord> *slots;
+};
+
+#endif // def(GP02Shm_h)
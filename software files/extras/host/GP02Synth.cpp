@@ -0,0 +1,446 @@
+/*
+GP02Synth - host-side synthetic NMEA stream generator for GP02 load testing.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+*/
+
+#include "GP02Synth.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define _SYNTH_EARTH_MEAN_RADIUS 6371009.0 // same sphere as GP02::distanceBetween
+#define _SYNTH_MPS_PER_KNOT 0.51444444
+#define _SYNTH_CENTIS_PER_DAY 8640000UL
+
+static const double kRad = M_PI / 180.0;
+
+// days since 1970-01-01 for a proleptic Gregorian date
+static int32_t daysFromCivil(int32_t y, unsigned m, unsigned d)
+{
+  y -= m <= 2;
+  const int32_t era = (y >= 0 ? y : y - 399) / 400;
+  const unsigned yoe = (unsigned)(y - era * 400);
+  const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + (int32_t)doe - 719468;
+}
+
+static void civilFromDays(int32_t z, int32_t &y, unsigned &m, unsigned &d)
+{
+  z += 719468;
+  const int32_t era = (z >= 0 ? z : z - 146096) / 146097;
+  const unsigned doe = (unsigned)(z - era * 146097);
+  const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const unsigned mp = (5 * doy + 2) / 153;
+  d = doy - (153 * mp + 2) / 5 + 1;
+  m = mp < 10 ? mp + 3 : mp - 9;
+  y = (int32_t)yoe + era * 400 + (m <= 2);
+}
+
+/**
+ * @brief Constructs a generator with the given configuration.
+ *
+ * The generator starts at the configured UTC date and time. If no waypoints are added
+ * before the first epoch, a small default circuit is used as trajectory.
+ *
+ * @param config The rates, talkers and error injection probabilities to use.
+ */
+GP02Synth::GP02Synth(const GP02SynthConfig &config)
+  :  cfg(config)
+  ,  rng(config.seed)
+  ,  epochCount(0)
+  ,  leg(0)
+  ,  lat(0), lng(0), course(0), knots(0), altitude(0)
+  ,  wanderNorth(0), wanderEast(0)
+  ,  dwellLeft(0)
+{
+  if (cfg.rateHz == 0)
+    cfg.rateHz = 1;
+  unsigned yy = cfg.startDate % 100;
+  startDays = daysFromCivil(yy >= 80 ? 1900 + yy : 2000 + yy, (cfg.startDate / 100) % 100, cfg.startDate / 10000);
+  startCentis = (cfg.startTime / 10000) * 360000UL + ((cfg.startTime / 100) % 100) * 6000UL + (cfg.startTime % 100) * 100UL;
+  memset(&truth, 0, sizeof(truth));
+}
+
+/**
+ * @brief Loads the trajectory from a text file.
+ *
+ * Each non-empty line that does not start with '#' holds "lat,lng,knots,altitude[,dwell]", where
+ * knots is the speed used to travel towards that waypoint and dwell the seconds spent standing
+ * still once it is reached. The route is followed in a loop.
+ *
+ * @param path The file to read.
+ * @return True if at least one waypoint was read.
+ */
+bool GP02Synth::loadRoute(const char *path)
+{
+  FILE *f = fopen(path, "r");
+  if (f == NULL)
+    return false;
+
+  char line[256];
+  while (fgets(line, sizeof(line), f))
+  {
+    GP02SynthWaypoint wp = { 0, 0, 0, 0, 0 };
+    if (line[0] == '#')
+      continue;
+    if (sscanf(line, "%lf,%lf,%lf,%lf,%lf", &wp.lat, &wp.lng, &wp.knots, &wp.altitude, &wp.dwell) >= 2)
+      route.push_back(wp);
+  }
+  fclose(f);
+  return !route.empty();
+}
+
+/**
+ * @brief Computes the NMEA checksum of a sentence body.
+ *
+ * @param body The characters between '$' and '*'.
+ * @return The XOR of all characters of the body.
+ */
+uint8_t GP02Synth::checksum(const char *body)
+{
+  uint8_t parity = 0;
+  while (*body)
+    parity ^= (uint8_t)*body++;
+  return parity;
+}
+
+/**
+ * @brief Frames a sentence body as a complete NMEA sentence.
+ *
+ * @param body The characters between '$' and '*'.
+ * @return The sentence including '$', checksum and CR/LF.
+ */
+std::string GP02Synth::sentence(const char *body)
+{
+  char tail[8];
+  snprintf(tail, sizeof(tail), "*%02X\r\n", checksum(body));
+  return std::string("$") + body + tail;
+}
+
+bool GP02Synth::chance(double p)
+{
+  return p > 0 && std::uniform_real_distribution<double>(0.0, 1.0)(rng) < p;
+}
+
+const char *GP02Synth::talker() const
+{
+  switch (cfg.constellations)
+  {
+  case GP02SynthConfig::GPS: return "GP";
+  case GP02SynthConfig::BDS: return "BD";
+  case GP02SynthConfig::GLONASS: return "GL";
+  default: return "GN";
+  }
+}
+
+/**
+ * @brief Moves the simulated receiver along the route by one epoch interval.
+ *
+ * Positions move along great circles at the speed of the waypoint being approached; when a
+ * waypoint is passed the remaining distance continues on the next leg.
+ */
+void GP02Synth::advance()
+{
+  if (route.empty())
+  {
+    const GP02SynthWaypoint circuit[] = {
+      { 41.00820, 28.97840, 20, 40, 0 }, { 41.01820, 28.97840, 35, 55, 0 },
+      { 41.01820, 28.99840, 10, 60, 0 }, { 41.00820, 28.99840, 0.5, 42, 0 } };
+    route.assign(circuit, circuit + 4);
+  }
+  if (epochCount == 0)
+  {
+    lat = route[0].lat;
+    lng = route[0].lng;
+    altitude = route[0].altitude;
+    leg = route.size() > 1 ? 1 : 0;
+    knots = route.size() > 1 ? route[leg].knots : 0;
+    dwellLeft = 0;
+    return;
+  }
+  if (dwellLeft > 0)
+  {
+    dwellLeft -= epochInterval();
+    if (dwellLeft <= 0)
+      knots = route[leg].knots;
+    return;
+  }
+
+  double remaining = knots * _SYNTH_MPS_PER_KNOT * epochInterval();
+  for (size_t guard = 0; remaining > 0 && route.size() > 1 && guard < route.size(); ++guard)
+  {
+    const GP02SynthWaypoint &wp = route[leg];
+    double p1 = lat * kRad, p2 = wp.lat * kRad, dl = (wp.lng - lng) * kRad;
+    double a = sin((p2 - p1) / 2) * sin((p2 - p1) / 2) + cos(p1) * cos(p2) * sin(dl / 2) * sin(dl / 2);
+    double dist = 2 * atan2(sqrt(a), sqrt(1 - a)) * _SYNTH_EARTH_MEAN_RADIUS;
+    double brg = atan2(sin(dl) * cos(p2), cos(p1) * sin(p2) - sin(p1) * cos(p2) * cos(dl));
+    course = fmod(brg / kRad + 360.0, 360.0);
+
+    if (dist > remaining)
+    {
+      double d = remaining / _SYNTH_EARTH_MEAN_RADIUS;
+      double nlat = asin(sin(p1) * cos(d) + cos(p1) * sin(d) * cos(brg));
+      double nlng = lng * kRad + atan2(sin(brg) * sin(d) * cos(p1), cos(d) - sin(p1) * sin(nlat));
+      altitude += (wp.altitude - altitude) * remaining / dist;
+      lat = nlat / kRad;
+      lng = fmod(nlng / kRad + 540.0, 360.0) - 180.0;
+      return;
+    }
+
+    remaining -= dist;
+    lat = wp.lat;
+    lng = wp.lng;
+    altitude = wp.altitude;
+    leg = (leg + 1) % route.size();
+    knots = route[leg].knots;
+    if (wp.dwell > 0)
+    {
+      dwellLeft = wp.dwell;
+      knots = 0;
+      return;
+    }
+  }
+}
+
+/**
+ * @brief Builds the deterministic satellite constellation for the current epoch.
+ *
+ * Satellite elevation, azimuth and signal strength drift slowly with time so that GSV and GSA
+ * content changes over a run while staying reproducible.
+ *
+ * @param constellation A single GP02SynthConfig::Constellation bit.
+ * @param sats Receives the satellites in view.
+ */
+void GP02Synth::satellites(uint8_t constellation, std::vector<Satellite> &sats)
+{
+  uint32_t minutes = (uint32_t)(epochCount / cfg.rateHz / 60);
+  uint8_t base = constellation == GP02SynthConfig::GLONASS ? 65 : 1;
+  uint8_t count = 7 + (uint8_t)((minutes + constellation) % 5);
+
+  sats.clear();
+  for (uint8_t i = 0; i < count; ++i)
+  {
+    Satellite s;
+    s.id = base + i * 3 + constellation;
+    s.elevation = (uint8_t)((s.id * 37 + minutes) % 80 + 5);
+    s.azimuth = (uint16_t)((s.id * 97 + minutes * 2) % 360);
+    s.snr = (uint8_t)(22 + (s.id * 13 + minutes) % 26);
+    s.used = s.snr >= 28;
+    sats.push_back(s);
+  }
+}
+
+/**
+ * @brief Frames a sentence body, applies error injection and appends it to the output.
+ *
+ * @param out The stream being generated.
+ * @param body The sentence body between '$' and '*'.
+ */
+void GP02Synth::emit(std::string &out, const std::string &body)
+{
+  bool damaged = false;
+  std::string b = body;
+
+  if (chance(cfg.oversizeField))
+  {
+    size_t comma = b.find(',', 6);
+    size_t end = comma == std::string::npos ? std::string::npos : b.find(',', comma + 1);
+    if (comma != std::string::npos)
+    {
+      std::string digits(30 + rng() % 40, '7');
+      b.replace(comma + 1, end == std::string::npos ? std::string::npos : end - comma - 1, digits);
+      damaged = true;
+    }
+  }
+
+  std::string s = sentence(b.c_str());
+  if (chance(cfg.badChecksum))
+  {
+    char &digit = s[s.size() - 3];
+    digit = digit == '0' ? '1' : '0';
+    damaged = true;
+  }
+
+  if (chance(cfg.noise))
+  {
+    for (unsigned n = 1 + rng() % 20; n > 0; --n)
+      out += (char)(rng() % 256);
+    damaged = true;
+  }
+
+  if (cfg.dropByte > 0)
+  {
+    for (size_t i = 0; i < s.size(); ++i)
+      if (chance(cfg.dropByte))
+        damaged = true;
+      else
+        out += s[i];
+  }
+  else
+  {
+    out += s;
+  }
+
+  truth.sentences++;
+  if (damaged)
+    truth.damaged++;
+  if (body.compare(2, 3, "RMC") == 0)
+    truth.rmcIntact = !damaged;
+  else if (body.compare(2, 3, "GGA") == 0)
+    truth.ggaIntact = !damaged;
+}
+
+/**
+ * @brief Applies the configured position error to a reported position.
+ *
+ * The error is a first-order Gauss-Markov process per axis, so consecutive epochs of one
+ * receiver are correlated the way real multipath and atmospheric errors are, while two
+ * generators with different seeds wander independently.
+ *
+ * @param hdop The HDOP reported for the epoch; the error scales with it.
+ * @param lat Latitude in degrees, moved by the error.
+ * @param lng Longitude in degrees, moved by the error.
+ */
+void GP02Synth::wander(double hdop, double &lat, double &lng)
+{
+  std::normal_distribution<double> normal(0, 1);
+  if (epochCount == 0)
+  {
+    wanderNorth = normal(rng);
+    wanderEast = normal(rng);
+  }
+  else
+  {
+    double a = exp(-epochInterval() / 30.0), b = sqrt(1 - a * a);
+    wanderNorth = a * wanderNorth + b * normal(rng);
+    wanderEast = a * wanderEast + b * normal(rng);
+  }
+  double meters = cfg.positionError * hdop;
+  lat += wanderNorth * meters / (_SYNTH_EARTH_MEAN_RADIUS * kRad);
+  lng += wanderEast * meters / (_SYNTH_EARTH_MEAN_RADIUS * kRad * cos(lat * kRad));
+}
+
+/**
+ * @brief Generates the next receiver epoch.
+ *
+ * The epoch is emitted in the order the GP-02 uses: GGA, GSA (one per constellation), GSV
+ * (per talker), RMC and VTG. Error injection is applied per sentence as configured.
+ *
+ * @param out Receives the bytes of the epoch, appended to any existing content.
+ * @return The ground truth of the generated epoch.
+ */
+GP02SynthTruth GP02Synth::next(std::string &out)
+{
+  advance();
+
+  memset(&truth, 0, sizeof(truth));
+  uint64_t elapsed = startCentis + (uint64_t)epochCount * 100 / cfg.rateHz;
+  uint32_t centis = (uint32_t)(elapsed % _SYNTH_CENTIS_PER_DAY);
+  int32_t y; unsigned mo, d;
+  civilFromDays(startDays + (int32_t)(elapsed / _SYNTH_CENTIS_PER_DAY), y, mo, d);
+  uint32_t hh = centis / 360000UL, mm = (centis / 6000UL) % 60, ss = (centis / 100) % 60, cc = centis % 100;
+  truth.date = d * 10000 + mo * 100 + (uint32_t)(y % 100);
+  truth.time = hh * 1000000UL + mm * 10000UL + ss * 100UL + cc;
+  truth.lat = lat;
+  truth.lng = lng;
+  truth.knots = knots;
+  truth.course = course;
+  truth.altitude = altitude;
+
+  static const uint8_t order[] = { GP02SynthConfig::GPS, GP02SynthConfig::GLONASS, GP02SynthConfig::BDS };
+  std::vector<Satellite> sats[3];
+  unsigned used = 0;
+  for (int c = 0; c < 3; ++c)
+    if (cfg.constellations & order[c])
+    {
+      satellites(order[c], sats[c]);
+      for (size_t i = 0; i < sats[c].size(); ++i)
+      {
+        used += sats[c][i].used;
+        truth.inView++;
+      }
+    }
+  truth.satellites = (uint8_t)used;
+  truth.hdop = floor((0.6 + 6.0 / (used ? used : 1)) * 10 + 0.5) / 10;
+  double pdop = truth.hdop * 1.6, vdop = truth.hdop * 1.3;
+
+  double rlat = lat, rlng = lng;
+  if (cfg.positionError > 0)
+    wander(truth.hdop, rlat, rlng);
+
+  // round in units of 1e-5 minutes so that 59.999995' never prints as 60.00000'
+  char when[16], latstr[24], lngstr[24], body[128];
+  snprintf(when, sizeof(when), "%02u%02u%02u.%03u", (unsigned)hh, (unsigned)mm, (unsigned)ss, (unsigned)cc * 10);
+  long long alat = llround(fabs(rlat) * 6000000.0), alng = llround(fabs(rlng) * 6000000.0);
+  snprintf(latstr, sizeof(latstr), "%02lld%02lld.%05lld,%c", alat / 6000000, alat % 6000000 / 100000, alat % 100000, rlat < 0 ? 'S' : 'N');
+  snprintf(lngstr, sizeof(lngstr), "%03lld%02lld.%05lld,%c", alng / 6000000, alng % 6000000 / 100000, alng % 100000, rlng < 0 ? 'W' : 'E');
+
+  snprintf(body, sizeof(body), "%sGGA,%s,%s,%s,1,%02u,%.1f,%.1f,M,0.0,M,,",
+    talker(), when, latstr, lngstr, used, truth.hdop, altitude);
+  emit(out, body);
+
+  if (cfg.gsa)
+  {
+    static const char sysid[] = { '1', '2', '4' };
+    for (int c = 0; c < 3; ++c)
+      if (cfg.constellations & order[c])
+      {
+        std::string gsa = std::string(talker()) + "GSA,A,3";
+        unsigned slots = 0;
+        for (size_t i = 0; i < sats[c].size() && slots < 12; ++i)
+          if (sats[c][i].used)
+          {
+            char id[8];
+            snprintf(id, sizeof(id), ",%02u", sats[c][i].id);
+            gsa += id;
+            ++slots;
+          }
+        for (; slots < 12; ++slots)
+          gsa += ',';
+        snprintf(body, sizeof(body), ",%.1f,%.1f,%.1f,%c", pdop, truth.hdop, vdop, sysid[c]);
+        emit(out, gsa + body);
+      }
+  }
+
+  if (cfg.gsv)
+  {
+    static const char *talkers[] = { "GP", "GL", "BD" };
+    for (int c = 0; c < 3; ++c)
+    {
+      size_t n = sats[c].size();
+      size_t total = (n + 3) / 4;
+      for (size_t m = 0; m < total; ++m)
+      {
+        snprintf(body, sizeof(body), "%sGSV,%u,%u,%02u", talkers[c], (unsigned)total, (unsigned)m + 1, (unsigned)n);
+        std::string gsv = body;
+        for (size_t i = m * 4; i < n && i < m * 4 + 4; ++i)
+        {
+          snprintf(body, sizeof(body), ",%02u,%02u,%03u,%02u", sats[c][i].id, sats[c][i].elevation, sats[c][i].azimuth, sats[c][i].snr);
+          gsv += body;
+        }
+        emit(out, gsv);
+      }
+    }
+  }
+
+  snprintf(body, sizeof(body), "%sRMC,%s,A,%s,%s,%.2f,%.2f,%06u,,,A",
+    talker(), when, latstr, lngstr, knots, course, (unsigned)truth.date);
+  emit(out, body);
+
+  if (cfg.vtg)
+  {
+    snprintf(body, sizeof(body), "%sVTG,%.2f,T,,M,%.2f,N,%.2f,K,A",
+      talker(), course, knots, knots * 1.852);
+    emit(out, body);
+  }
+
+  ++epochCount;
+  return truth;
+}
@@ -0,0 +1,110 @@
+#ifndef GP02Synth_h
+#define GP02Synth_h
+
+/*
+GP02Synth - host-side synthetic NMEA stream generator for GP02 load testing.
+
+Produces GP-02 style RMC/GGA/GSA/GSV/VTG epochs from BD/GP/GL/GN talkers along a
+scripted trajectory, with optional error injection (corrupted checksums, dropped
+bytes, oversize fields, line noise). Every epoch comes with its ground truth so that
+parsers and serial backends can be checked and benchmarked against known values.
+
+This file is not part of the Arduino build; see gp02synth.cpp for a command line front end.
+*/
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <random>
+#include <string>
+#include <vector>
+
+struct GP02SynthWaypoint
+{
+   double lat, lng;        // signed decimal degrees
+   double knots;           // speed used to travel towards this waypoint
+   double altitude;        // meters
+   double dwell;           // seconds stopped on arrival at this waypoint
+};
+
+struct GP02SynthConfig
+{
+   enum Constellation { GPS = 0x01, BDS = 0x02, GLONASS = 0x04 };
+
+   uint16_t rateHz;        // epochs per second (GP-02 supports 1..10)
+   uint8_t constellations; // Constellation bits; more than one selects the GN talker
+   bool gsa, gsv, vtg;     // optional sentences besides RMC and GGA
+   uint32_t startDate;     // ddmmyy
+   uint32_t startTime;     // hhmmss
+   uint32_t seed;
+
+   // error injection, as probabilities in [0, 1]
+   double badChecksum;     // per sentence: checksum digit altered
+   double oversizeField;   // per sentence: one field replaced by a long run of digits (checksum kept valid)
+   double dropByte;        // per byte: byte silently removed
+   double noise;           // per sentence: random bytes inserted before it
+
+   // reported positions wander around the true one by this many meters (1-sigma, per axis)
+   // per unit of HDOP, with a 30 s correlation time; 0 reports the exact trajectory
+   double positionError;
+
+   GP02SynthConfig()
+     : rateHz(1), constellations(GPS | BDS), gsa(true), gsv(true), vtg(true)
+     , startDate(181026), startTime(120000), seed(1)
+     , badChecksum(0), oversizeField(0), dropByte(0), noise(0), positionError(0)
+   {}
+};
+
+struct GP02SynthTruth
+{
+   uint32_t date;          // ddmmyy
+   uint32_t time;          // hhmmsscc, as GP02Time::value()
+   double lat, lng;        // true position; the sentences carry it plus the position error
+   double knots, course, altitude, hdop;
+   uint8_t satellites;     // used in fix
+   uint8_t inView;         // sum over all GSV talkers
+   uint16_t sentences;     // sentences emitted for this epoch
+   uint16_t damaged;       // sentences altered by error injection
+   bool rmcIntact, ggaIntact;
+};
+
+class GP02Synth
+{
+public:
+  GP02Synth(const GP02SynthConfig &config);
+
+  void addWaypoint(const GP02SynthWaypoint &wp) { route.push_back(wp); }
+  bool loadRoute(const char *path);
+
+  // appends the bytes of the next epoch to out; returns the epoch's ground truth
+  GP02SynthTruth next(std::string &out);
+
+  double epochInterval() const { return 1.0 / cfg.rateHz; }
+  uint32_t epochs() const { return epochCount; }
+
+  static std::string sentence(const char *body);
+  static uint8_t checksum(const char *body);
+
+private:
+  struct Satellite { uint8_t id; uint8_t elevation; uint16_t azimuth; uint8_t snr; bool used; };
+
+  GP02SynthConfig cfg;
+  std::vector<GP02SynthWaypoint> route;
+  std::mt19937 rng;
+  uint32_t epochCount;
+  size_t leg;
+  double lat, lng, course, knots, altitude;
+  double wanderNorth, wanderEast; // position error state, unit variance
+  double dwellLeft;       // seconds still to wait at the waypoint just reached
+  int32_t startDays;      // days since 1970-01-01
+  uint32_t startCentis;   // hundredths of a second since midnight
+  GP02SynthTruth truth;
+
+  void advance();
+  void wander(double hdop, double &lat, double &lng);
+  void satellites(uint8_t constellation, std::vector<Satellite> &sats);
+  void emit(std::string &out, const std::string &body);
+  const char *talker() const;
+  bool chance(double p);
+};
+
+#endif // def(GP02Synth_h)
@@ -0,0 +1,95 @@
+/*
+gp02await - coroutine example: one coroutine per receiver, all serviced by a single thread.
+
+Build (host):
+   g++ -std=c++20 -O2 -I. -I../../src gp02await.cpp GP02Await.cpp GP02Serial.cpp ../../src/GP02.cpp -o gp02await
+
+Usage:
+   gp02await DEVICE[@BAUD]...
+*/
+
+#include "GP02Await.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <memory>
+
+using namespace std::chrono_literals;
+
+static volatile sig_atomic_t stop = 0;
+
+static void onSignal(int)
+{
+  stop = 1;
+}
+
+static GP02Task track(GP02AsyncReceiver &rx)
+{
+  for (;;)
+  {
+    std::optional<GP02Fix> fix = co_await rx.nextFix(2s);
+    if (!fix)
+    {
+      printf("%d: no fix within 2 s\n", rx.index());
+      if (!rx.isOpen())
+        co_return;
+      continue;
+    }
+    printf("%d: %08u %c%u.%09u %c%u.%09u sats=%u\n", rx.index(), (unsigned)fix->time,
+      fix->lat.negative ? '-' : '+', fix->lat.deg, (unsigned)fix->lat.billionths,
+      fix->lng.negative ? '-' : '+', fix->lng.deg, (unsigned)fix->lng.billionths, (unsigned)fix->satellites);
+  }
+}
+
+static GP02Task sky(GP02AsyncReceiver &rx)
+{
+  while (rx.isOpen())
+  {
+    bool seen = co_await rx.nextSentence("GSV", 5s);
+    if (seen)
+      printf("%d: GSV received\n", rx.index());
+    else
+      printf("%d: no GSV within 5 s\n", rx.index());
+    co_await rx.nextFix(10s);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 2)
+  {
+    fprintf(stderr, "usage: gp02await DEVICE[@BAUD]...\n");
+    return 2;
+  }
+
+  GP02SerialHub hub;
+  GP02EventLoop loop(hub);
+  std::vector<std::unique_ptr<GP02AsyncReceiver> > receivers;
+  for (int i = 1; i < argc; ++i)
+  {
+    char path[256];
+    snprintf(path, sizeof(path), "%s", argv[i]);
+    char *at = strchr(path, '@');
+    unsigned long baud = at ? strtoul(at + 1, NULL, 10) : 9600;
+    if (at)
+      *at = '\0';
+    receivers.emplace_back(new GP02AsyncReceiver(loop, path, baud, GP02Epoch::VTG));
+    if (!receivers.back()->isOpen())
+    {
+      perror(path);
+      return 1;
+    }
+    track(*receivers.back());
+    sky(*receivers.back());
+  }
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+  while (!stop)
+    if (loop.runOnce(500) < 0)
+      break;
+  return 0;
+}
@@ -0,0 +1,368 @@
+/*
+gp02check - regression checks for corner cases the synthetic streams do not reach.
+
+Every check feeds hand-written sentences (or fixes) through the library and compares the
+result with what the sentence text says. One line is printed per check; the exit status is
+the number of checks that failed, so the tool can run from a script.
+
+Build (host):
+   g++ -std=c++17 -O2 -I. -I../../src gp02check.cpp ../../src/GP02Format.cpp ../../src/GP02Power.cpp ../../src/GP02Trip.cpp ../../src/GP02Fusion.cpp ../../src/GP02PoiIndex.cpp GP02PoiBuilder.cpp ../../src/GP02.cpp -o gp02check
+
+Example:
+   gp02check
+*/
+
+#include "GP02Format.h"
+#include "GP02Fusion.h"
+#include "GP02PoiBuilder.h"
+#include "GP02Power.h"
+#include "GP02Trip.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+
+static int failures = 0;
+
+static void check(bool ok, const char *name, const char *detail = "")
+{
+  printf("%-4s %s%s%s\n", ok ? "ok" : "FAIL", name, *detail ? ": " : "", detail);
+  if (!ok)
+    ++failures;
+}
+
+// frames a sentence body with '$', the checksum and CR LF
+static std::string sentence(const char *body)
+{
+  uint8_t parity = 0;
+  for (const char *p = body; *p; ++p)
+    parity ^= (uint8_t)*p;
+  char tail[8];
+  snprintf(tail, sizeof(tail), "*%02X\r\n", parity);
+  return std::string("$") + body + tail;
+}
+
+static void feed(GP02 &gps, const std::string &s)
+{
+  gps.encode(s.data(), s.size());
+}
+
+// one GP-02 burst in receiver order: GGA, GSA, GSV, RMC, VTG; the VTG speed differs from the
+// RMC speed so that a VTG folded into the wrong epoch shows up in the fix
+static std::string burst(unsigned second, bool dop)
+{
+  char gga[96], gsa[96], rmc[96], vtg[64];
+  snprintf(gga, sizeof(gga), "GNGGA,1200%02u.00,4100.49200,N,02858.70400,E,1,08,1.2,40.0,M,0.0,M,,", second);
+  snprintf(gsa, sizeof(gsa), dop ? "GNGSA,A,3,01,03,07,11,,,,,,,,,2.1,1.2,1.7,1" : "GNGSA,A,1,,,,,,,,,,,,,,,,1");
+  snprintf(rmc, sizeof(rmc), "GNRMC,1200%02u.00,A,4100.49200,N,02858.70400,E,%u.00,90.00,181026,,,A", second, second);
+  snprintf(vtg, sizeof(vtg), "GNVTG,270.00,T,,M,%u.50,N,,K,A", second + 50);
+  return sentence(gga) + sentence(gsa) + sentence("GPGSV,1,1,04,01,40,083,46,03,20,120,40,07,66,300,44,11,05,010,30") +
+    sentence(rmc) + sentence(vtg);
+}
+
+static void epochTerminator()
+{
+  GP02 gps;
+  gps.enableEpochs(GP02Epoch::RMC);
+  const uint8_t closed = GP02Epoch::GGA | GP02Epoch::GSA | GP02Epoch::GSV | GP02Epoch::RMC;
+  unsigned epochs = 0, mixed = 0;
+  char detail[96] = "";
+  for (unsigned s = 0; s < 5; ++s)
+  {
+    feed(gps, burst(s, true));
+    if (!gps.epoch.isUpdated())
+      continue;
+    const GP02Fix &f = gps.epoch.value();
+    ++epochs;
+    // RMC carries the speed of its own second; a VTG of the previous burst would say s + 49.50
+    if (f.sentences != closed || f.speed != (int32_t)s * 100 || f.course != 9000)
+    {
+      if (!mixed)
+        snprintf(detail, sizeof(detail), "epoch %u: sentences 0x%02x speed %ld course %ld", s, f.sentences, (long)f.speed, (long)f.course);
+      ++mixed;
+    }
+  }
+  if (!*detail)
+    snprintf(detail, sizeof(detail), "%u epochs", epochs);
+  check(epochs == 5 && mixed == 0, "RMC-terminated bursts keep the trailing VTG out of the next epoch", detail);
+}
+
+static void epochDop()
+{
+  GP02 gps;
+  gps.enableEpochs(GP02Epoch::VTG);
+  feed(gps, burst(0, true));
+  const GP02Fix &a = gps.epoch.value();
+  bool first = a.has(GP02Fix::HasDOP) && a.pdop == 210 && a.vdop == 170 && a.fixType == 3;
+  // the next GSA reports no fix and leaves every DOP term empty
+  feed(gps, burst(1, false));
+  const GP02Fix &b = gps.epoch.value();
+  char detail[96];
+  snprintf(detail, sizeof(detail), "HasDOP %d pdop %ld vdop %ld fix type %u", b.has(GP02Fix::HasDOP), (long)b.pdop,
+    (long)b.vdop, b.fixType);
+  check(first && !b.has(GP02Fix::HasDOP) && b.pdop == 0 && b.vdop == 0 && b.fixType == 1,
+    "empty GSA DOP terms are not carried over from the previous sentence", detail);
+}
+
+struct TraceCount
+{
+  unsigned starts, commits, fails, unpaired;
+  bool open;
+};
+
+static void countTrace(void *context, GP02 &, uint8_t event, uint8_t)
+{
+  TraceCount &t = *static_cast<TraceCount *>(context);
+  if (event == GP02::TraceStart)
+  {
+    t.unpaired += t.open;
+    t.open = true;
+    ++t.starts;
+  }
+  else if (event == GP02::TraceCommit || event == GP02::TraceFail)
+  {
+    t.unpaired += !t.open;
+    t.open = false;
+    ++(event == GP02::TraceCommit ? t.commits : t.fails);
+  }
+}
+
+static void framingTrace()
+{
+  GP02 gps;
+  gps.enableStrictFraming();
+  TraceCount t = { 0, 0, 0, 0, false };
+  gps.onTrace(countTrace, &t);
+  const std::string gga = sentence("GPGGA,120000.00,4100.49200,N,02858.70400,E,1,08,1.2,40.0,M,0.0,M,,");
+  feed(gps, gga);
+  feed(gps, sentence("GPGGA,120000.00,4100.4920000000000000,N,02858.70400,E,1,08,1.2,40.0,M,0.0,M,,")); // oversize term
+  feed(gps, "$GPGGA,1200"); // cut short by the next '$'
+  feed(gps, gga);
+  feed(gps, sentence("GPTXT,0123456789,0123456789,0123456789,0123456789,0123456789,0123456789,0123456789")); // too long
+  feed(gps, gga);
+  char detail[96];
+  snprintf(detail, sizeof(detail), "%u starts, %u commits, %u fails, %u unpaired, %u framing errors", t.starts, t.commits,
+    t.fails, t.unpaired + t.open, (unsigned)gps.framingErrors());
+  check(t.starts == 6 && t.commits == 3 && t.fails == 3 && t.unpaired == 0 && !t.open && gps.framingErrors() == 3,
+    "strict framing ends every traced sentence with a commit or failure", detail);
+}
+
+// one RMC and GGA of the given date at 12:00:00, as an epoch
+static const GP02Fix &dated(GP02 &gps, const char *ddmmyy)
+{
+  char rmc[96];
+  snprintf(rmc, sizeof(rmc), "GPRMC,120000.00,A,4100.49200,N,02858.70400,E,0.00,0.00,%s,,,A", ddmmyy);
+  gps.enableEpochs(GP02Epoch::RMC);
+  feed(gps, sentence("GPGGA,120000.00,4100.49200,N,02858.70400,E,1,08,1.2,40.0,M,0.0,M,,") + sentence(rmc));
+  return gps.epoch.value();
+}
+
+// the calendar fields, the formatted date and both Unix times of one fix must name the same day
+static void dateAgrees(const char *name, const char *ddmmyy, const char *expect, uint32_t unixDay)
+{
+  GP02 gps;
+  const GP02Fix &f = dated(gps, ddmmyy);
+  char text[16], fields[16], detail[128];
+  GP02Format::date(text, sizeof(text), f.date);
+  snprintf(fields, sizeof(fields), "%04u-%02u-%02u", gps.date.year(), gps.date.month(), gps.date.day());
+  uint64_t noon = (uint64_t)unixDay * 1000 + 12 * 3600000UL;
+  snprintf(detail, sizeof(detail), "fields %s, text %s, unix %lu, fix %llu ms", fields, text,
+    (unsigned long)gps.date.unixTime(), (unsigned long long)f.unixMillis);
+  check(!strcmp(text, expect) && !strcmp(fields, expect) && gps.date.unixTime() == unixDay && f.unixMillis == noon, name, detail);
+}
+
+static void rollover()
+{
+  dateAgrees("dates before 2024 are kept without a rollover floor", "150323", "2023-03-15", 1678838400UL);
+  // a receiver that missed the April 2019 rollover reports 2019-04-07 as 1999-08-22
+  GP02Date::setRolloverFloor(GP02Date::daysFromCivil(2019, 1, 1));
+  dateAgrees("a rollover floor moves every view of the date forward by 1024 weeks", "220899", "2019-04-07", 1554595200UL);
+  GP02Date::setRolloverFloor(0);
+}
+
+static void good(GP02 &gps)
+{
+  feed(gps, sentence("GPGGA,120000.00,4100.49200,N,02858.70400,E,1,08,1.2,40.0,M,0.0,M,,") +
+    sentence("GPRMC,120000.00,A,4100.49200,N,02858.70400,E,0.00,0.00,181026,,,A"));
+}
+
+static void powerWake()
+{
+  GP02 gps;
+  GP02Power power(NULL, NULL);
+  usleep(2000);
+  good(gps);
+  usleep(2000);
+  bool tracked = power.update(gps) == GP02Power::Tracking;
+  power.standby(60);
+  uint16_t sleep = power.sleepSeconds();
+
+  // woken early while the fix from before standby is still younger than maxAgeMs
+  power.wake();
+  bool stale = power.update(gps) == GP02Power::Acquiring && power.stats().acquisitions == 1;
+  usleep(2000);
+  good(gps);
+  usleep(2000);
+  bool fresh = power.update(gps) == GP02Power::Tracking && power.stats().acquisitions == 2;
+  char detail[96];
+  snprintf(detail, sizeof(detail), "acquisitions %u, last time to fix %lu ms, sleep %u s after %u s",
+    power.stats().acquisitions, (unsigned long)power.stats().lastTtff, power.sleepSeconds(), sleep);
+  check(tracked && stale && fresh && power.stats().lastTtff >= 2, "a fix from before standby does not end the acquisition after wake()", detail);
+}
+
+static void powerQuality()
+{
+  GP02 gps;
+  GP02Power power(NULL, NULL);
+  usleep(2000);
+  good(gps);
+  usleep(2000);
+  bool tracked = power.update(gps) == GP02Power::Tracking;
+  bool flags = gps.location.isUpdated() && gps.hdop.isUpdated() && gps.satellites.isUpdated();
+  // still a fix, but HDOP 4.0 is above the policy's 2.5
+  feed(gps, sentence("GPGGA,120001.00,4100.49200,N,02858.70400,E,1,08,4.0,40.0,M,0.0,M,,"));
+  bool dropped = power.update(gps) == GP02Power::Acquiring;
+  char detail[64];
+  snprintf(detail, sizeof(detail), "tracked %d, flags kept %d, back to acquiring %d", tracked, flags, dropped);
+  check(tracked && flags && dropped, "tracking checks fix quality and leaves isUpdated() to the sketch", detail);
+}
+
+// GP02PoiIndex::point() as computed where double is a 32-bit float
+static GP02PoiPoint floatPoint(double lat, double lng)
+{
+  float phi = (float)lat * (float)(PI / 180), lambda = (float)lng * (float)(PI / 180);
+  GP02PoiPoint p;
+  p.x = (int32_t)lroundf(cosf(phi) * cosf(lambda) * (float)_GPS_POI_SCALE);
+  p.y = (int32_t)lroundf(cosf(phi) * sinf(lambda) * (float)_GPS_POI_SCALE);
+  p.z = (int32_t)lroundf(sinf(phi) * (float)_GPS_POI_SCALE);
+  p.id = 0;
+  return p;
+}
+
+// around random sites, one point at half and one at one and a half _GPS_POI_MIN_METERS; float
+// queries at the site must find exactly the inner one in range and nearest
+static void poiMinRadius()
+{
+  const unsigned sites = 2000;
+  const double r = _GPS_POI_MIN_METERS, toDeg = 180 / PI / _GPS_EARTH_MEAN_RADIUS;
+  std::vector<double> lat(sites), lng(sites);
+  GP02PoiBuilder b;
+  srand(1);
+  for (unsigned i = 0; i < sites; ++i)
+  {
+    lat[i] = rand() / (double)RAND_MAX * 170 - 85;
+    lng[i] = rand() / (double)RAND_MAX * 360 - 180;
+    double bearing = rand() / (double)RAND_MAX * 2 * PI, east = toDeg / cos(lat[i] * PI / 180);
+    b.add(lat[i] + 0.5 * r * cos(bearing) * toDeg, lng[i] + 0.5 * r * sin(bearing) * east, 2 * i);
+    b.add(lat[i] - 1.5 * r * cos(bearing) * toDeg, lng[i] - 1.5 * r * sin(bearing) * east, 2 * i + 1);
+  }
+  GP02PoiIndex index;
+  index.attach(b.blob().data(), b.blob().size());
+  unsigned wrong = 0;
+  for (unsigned i = 0; i < sites; ++i)
+  {
+    GP02Poi hit[4];
+    GP02PoiPoint at = floatPoint(lat[i], lng[i]);
+    size_t in = index.within(at, r, hit, 4);
+    bool ok = in == 1 && hit[0].id == 2 * i;
+    ok = ok && index.nearest(at, hit, 2) == 2 && hit[0].id == 2 * i && hit[1].id == 2 * i + 1;
+    wrong += !ok;
+  }
+  char detail[64];
+  snprintf(detail, sizeof(detail), "%u of %u float queries wrong at %d m", wrong, sites, _GPS_POI_MIN_METERS);
+  check(index.size() == 2 * sites && wrong == 0, "POI searches resolve _GPS_POI_MIN_METERS from float coordinates", detail);
+}
+
+// a GGA and RMC of the given UTC time, closed as an epoch by the RMC
+static std::string at(const char *hhmmss)
+{
+  char gga[96], rmc[96];
+  snprintf(gga, sizeof(gga), "GPGGA,%s.00,4100.49200,N,02858.70400,E,1,08,1.2,40.0,M,0.0,M,,", hhmmss);
+  snprintf(rmc, sizeof(rmc), "GPRMC,%s.00,A,4100.49200,N,02858.70400,E,0.00,0.00,181026,,,A", hhmmss);
+  return sentence(gga) + sentence(rmc);
+}
+
+static void fusionStepBack()
+{
+  GP02 a, b;
+  a.enableEpochs(GP02Epoch::RMC);
+  b.enableEpochs(GP02Epoch::RMC);
+  GP02Fusion fusion;
+  fusion.add(a);
+  fusion.add(b);
+  // both receivers reacquire with their clock an hour behind
+  const char *times[] = { "120000", "120001", "120002", "110000", "110001", "110002" };
+  unsigned published = 0;
+  for (size_t i = 0; i < sizeof(times) / sizeof(times[0]); ++i)
+  {
+    feed(a, at(times[i]));
+    feed(b, at(times[i]));
+    if (fusion.update())
+      ++published;
+  }
+  const GP02FusionStats &s = fusion.stats();
+  uint32_t last = fusion.value().time;
+  char detail[96];
+  snprintf(detail, sizeof(detail), "%u published, %lu late, %lu resyncs, last %06lu", published, (unsigned long)s.late,
+    (unsigned long)s.resyncs, (unsigned long)(last / 100));
+  check(published == 6 && s.late == 0 && s.resyncs == 1 && last == 11000200UL,
+    "a UTC step back restarts fusion instead of dropping every epoch as late", detail);
+}
+
+// a fix of the given second of 12:00, north of 41 N 29 E by the given nanodegrees
+static GP02Fix tripFix(unsigned second, uint32_t north)
+{
+  GP02Fix f;
+  f.fields = GP02Fix::HasTime | GP02Fix::HasLocation | GP02Fix::HasSpeed;
+  f.time = 12000000UL + (second / 60) * 10000UL + (second % 60) * 100UL;
+  f.lat.deg = 41;
+  f.lat.billionths = north;
+  f.lng.deg = 29;
+  f.speed = 1944; // 10 m/s
+  return f;
+}
+
+// 60 s north at 10 m/s, about 90 nanodegrees of latitude per second
+static GP02Trip &drive(GP02Trip &trip)
+{
+  for (unsigned s = 1; s <= 60; ++s)
+    trip.add(tripFix(s, s * 89932));
+  return trip;
+}
+
+static void tripRelocation()
+{
+  GP02Trip clean, relocated;
+  clean.add(tripFix(0, 0));
+  drive(clean);
+  // the first fix is a degree off, so every real fix looks like a glitch from it
+  GP02Fix bad = tripFix(0, 0);
+  bad.lat.deg = 40;
+  relocated.add(bad);
+  drive(relocated);
+  char detail[128];
+  snprintf(detail, sizeof(detail), "%.1f m of %.1f m, %lu fixes, %u glitches, %u relocations", relocated.meters(),
+    clean.meters(), (unsigned long)relocated.fixes(), relocated.glitches(), relocated.relocations());
+  check(relocated.relocations() == 1 && relocated.glitches() < 3 && relocated.meters() > clean.meters() - 25 &&
+    relocated.meters() <= clean.meters() && clean.relocations() == 0,
+    "agreeing glitches after a bad first fix re-anchor the trip", detail);
+}
+
+int main()
+{
+  epochTerminator();
+  epochDop();
+  framingTrace();
+  rollover();
+  powerWake();
+  powerQuality();
+  tripRelocation();
+  fusionStepBack();
+  poiMinRadius();
+  printf("%d failed\n", failures);
+  return failures;
+}
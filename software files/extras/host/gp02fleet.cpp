@@ -0,0 +1,315 @@
+/*
+gp02fleet - GP02FleetServer benchmark fed by synthetic GP02Synth streams over pipes.
+
+Every unit gets its own pipe and its own pre-rendered GP02Synth stream (a small loop around
+a distinct position). Feeder threads write the streams as fast as the pipes accept them, or
+paced at --rate epochs per second, while reader threads hammer the store with latest() and
+bounding-box queries. Each worker count listed with -w is run in turn so that scaling across
+cores shows in one table.
+
+Build (host):
+   g++ -std=c++17 -O2 -pthread -I. -I../../src gp02fleet.cpp GP02Fleet.cpp GP02Serial.cpp GP02Synth.cpp ../../src/GP02.cpp -o gp02fleet
+
+Examples:
+   gp02fleet -u 64 -w 1,2,4,8 -r 4 -d 5
+   gp02fleet -u 48 -w 2 --rate 10          (real-time load: 48 receivers at 10 Hz)
+*/
+
+#include "GP02Fleet.h"
+#include "GP02Synth.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <random>
+#include <string>
+
+struct Stream
+{
+  std::string bytes;
+  std::vector<size_t> epochEnd;  // offset just past each epoch
+  int writeFd, readFd;
+  size_t offset;
+  size_t epoch;
+};
+
+static double now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void usage()
+{
+  fprintf(stderr,
+    "usage: gp02fleet [options]\n"
+    "  -u, --units N       receivers (default 64)\n"
+    "  -w, --workers LIST  comma separated worker counts to run (default 1,2,4)\n"
+    "  -r, --readers N     query threads (default 4)\n"
+    "  -f, --feeders N     stream writer threads (default 2)\n"
+    "  -d, --duration S    seconds per run (default 5)\n"
+    "  -e, --epochs N      epochs rendered per unit stream, replayed in a loop (default 200)\n"
+    "      --rate HZ       pace every unit at HZ epochs per second (default: as fast as possible)\n"
+    "      --bbox N        one bounding-box query per N latest() queries (default 100)\n");
+}
+
+static void render(Stream &s, uint32_t unit, size_t epochs)
+{
+  GP02SynthConfig cfg;
+  cfg.rateHz = 10;
+  cfg.seed = unit + 1;
+  GP02Synth synth(cfg);
+
+  // every unit circles its own cell of a 0.05 degree grid
+  double lat = 40.5 + (unit % 32) * 0.05, lng = 28.5 + (unit / 32) * 0.05;
+  GP02SynthWaypoint a = { lat, lng, 20, 40, 0 }, b = { lat + 0.01, lng, 20, 40, 0 }, c = { lat + 0.01, lng + 0.01, 20, 40, 0 };
+  synth.addWaypoint(a);
+  synth.addWaypoint(b);
+  synth.addWaypoint(c);
+
+  for (size_t e = 0; e < epochs; ++e)
+  {
+    synth.next(s.bytes);
+    s.epochEnd.push_back(s.bytes.size());
+  }
+  s.offset = s.epoch = 0;
+}
+
+// writes whatever the pipe accepts; in paced mode only up to the end of the due epoch
+static void feed(Stream &s, size_t limit)
+{
+  while (s.offset < limit)
+  {
+    ssize_t w = write(s.writeFd, s.bytes.data() + s.offset, limit - s.offset);
+    if (w < 0 && errno == EINTR)
+      continue;
+    if (w <= 0)
+      return;
+    s.offset += (size_t)w;
+  }
+  if (s.offset == s.bytes.size())
+    s.offset = s.epoch = 0;
+}
+
+static void feeder(std::vector<Stream> &streams, size_t first, size_t step, double rate, const std::atomic<bool> &stop)
+{
+  std::vector<size_t> mine;
+  std::vector<struct pollfd> fds;
+  for (size_t i = first; i < streams.size(); i += step)
+  {
+    mine.push_back(i);
+    struct pollfd p = { streams[i].writeFd, POLLOUT, 0 };
+    fds.push_back(p);
+  }
+
+  double start = now();
+  uint64_t due = 0;
+  while (!stop.load(std::memory_order_relaxed))
+  {
+    if (rate > 0)
+    {
+      // one epoch per unit per tick
+      double tick = start + due / rate;
+      while (now() < tick)
+      {
+        if (stop.load(std::memory_order_relaxed))
+          return;
+        struct timespec ts = { 0, 200000 };
+        nanosleep(&ts, NULL);
+      }
+      ++due;
+      for (size_t k = 0; k < mine.size(); ++k)
+      {
+        Stream &s = streams[mine[k]];
+        feed(s, s.epochEnd[s.epoch]);
+        s.epoch = (s.epoch + 1) % s.epochEnd.size();
+      }
+      continue;
+    }
+
+    if (poll(fds.data(), fds.size(), 50) <= 0)
+      continue;
+    for (size_t k = 0; k < mine.size(); ++k)
+      if (fds[k].revents & POLLOUT)
+      {
+        Stream &s = streams[mine[k]];
+        feed(s, s.bytes.size());
+      }
+  }
+}
+
+struct ReaderStats
+{
+  uint64_t latest, bbox, found, torn;
+};
+
+static void reader(const GP02FleetStore &store, size_t units, unsigned bboxEvery, uint32_t seed,
+  const std::atomic<bool> &stop, ReaderStats &stats)
+{
+  std::mt19937 rng(seed);
+  std::vector<GP02FleetEntry> hits;
+  GP02FleetEntry e;
+  memset(&stats, 0, sizeof(stats));
+
+  while (!stop.load(std::memory_order_relaxed))
+  {
+    uint32_t unit = rng() % units;
+    if (store.latest(unit, e))
+    {
+      // a torn copy would show another unit's number or a position outside the unit's cell
+      int32_t cellLat = (int32_t)((40.5 + (unit % 32) * 0.05) * 1e7), cellLng = (int32_t)((28.5 + (unit / 32) * 0.05) * 1e7);
+      if (e.unit != unit || e.latE7 < cellLat - 10000 || e.latE7 > cellLat + 110000
+          || e.lngE7 < cellLng - 10000 || e.lngE7 > cellLng + 110000)
+        ++stats.torn;
+    }
+    ++stats.latest;
+
+    if (bboxEvery && stats.latest % bboxEvery == 0)
+    {
+      double lat = 40.5 + (rng() % 32) * 0.05, lng = 28.5 + (rng() % 4) * 0.05;
+      hits.clear();
+      stats.found += store.within(GP02BoundingBox(lat, lng, lat + 0.15, lng + 0.15), hits);
+      ++stats.bbox;
+    }
+  }
+}
+
+static bool runOnce(std::vector<Stream> &streams, unsigned workers, unsigned readers, unsigned feeders,
+  double seconds, double rate, unsigned bboxEvery)
+{
+  GP02FleetServer server(workers, streams.size());
+  for (size_t i = 0; i < streams.size(); ++i)
+  {
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) < 0)
+    {
+      perror("pipe2");
+      return false;
+    }
+    fcntl(fds[1], F_SETFL, O_NONBLOCK);
+    streams[i].readFd = fds[0];
+    streams[i].writeFd = fds[1];
+    streams[i].offset = streams[i].epoch = 0;
+    if (server.attach(fds[0]) < 0)
+    {
+      fprintf(stderr, "gp02fleet: cannot attach unit %zu\n", i);
+      return false;
+    }
+  }
+
+  std::atomic<bool> stop(false);
+  std::vector<std::thread> feederThreads, readerThreads;
+  std::vector<ReaderStats> stats(readers);
+  server.start();
+  double start = now();
+  for (unsigned i = 0; i < feeders; ++i)
+    feederThreads.push_back(std::thread(feeder, std::ref(streams), i, feeders, rate, std::cref(stop)));
+  for (unsigned i = 0; i < readers; ++i)
+    readerThreads.push_back(std::thread(reader, std::cref(server.store()), streams.size(), bboxEvery, i + 1,
+      std::cref(stop), std::ref(stats[i])));
+
+  struct timespec ts = { (time_t)seconds, (long)((seconds - (time_t)seconds) * 1e9) };
+  nanosleep(&ts, NULL);
+  stop = true;
+  for (size_t i = 0; i < feederThreads.size(); ++i)
+    feederThreads[i].join();
+  for (size_t i = 0; i < readerThreads.size(); ++i)
+    readerThreads[i].join();
+  double elapsed = now() - start;
+  server.stop();
+
+  ReaderStats total = { 0, 0, 0, 0 };
+  for (size_t i = 0; i < stats.size(); ++i)
+  {
+    total.latest += stats[i].latest;
+    total.bbox += stats[i].bbox;
+    total.found += stats[i].found;
+    total.torn += stats[i].torn;
+  }
+
+  printf("%7u %12.0f %8.1f %12.0f %10.0f %9.1f %6llu %6u\n", server.workerCount(),
+    server.store().published() / elapsed, server.bytesRead() / elapsed / 1e6,
+    total.latest / elapsed, total.bbox / elapsed, total.bbox ? (double)total.found / total.bbox : 0.0,
+    (unsigned long long)total.torn, server.failedChecksum());
+
+  for (size_t i = 0; i < streams.size(); ++i)
+  {
+    close(streams[i].writeFd);
+    close(streams[i].readFd);
+  }
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  enum { OPT_RATE = 256, OPT_BBOX };
+  static const struct option options[] = {
+    { "units", required_argument, NULL, 'u' },
+    { "workers", required_argument, NULL, 'w' },
+    { "readers", required_argument, NULL, 'r' },
+    { "feeders", required_argument, NULL, 'f' },
+    { "duration", required_argument, NULL, 'd' },
+    { "epochs", required_argument, NULL, 'e' },
+    { "rate", required_argument, NULL, OPT_RATE },
+    { "bbox", required_argument, NULL, OPT_BBOX },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 } };
+
+  size_t units = 64, epochs = 200;
+  const char *workerList = "1,2,4";
+  unsigned readers = 4, feeders = 2, bboxEvery = 100;
+  double seconds = 5, rate = 0;
+
+  int opt;
+  while ((opt = getopt_long(argc, argv, "u:w:r:f:d:e:h", options, NULL)) != -1)
+  {
+    switch (opt)
+    {
+    case 'u': units = strtoul(optarg, NULL, 10); break;
+    case 'w': workerList = optarg; break;
+    case 'r': readers = (unsigned)atoi(optarg); break;
+    case 'f': feeders = (unsigned)atoi(optarg); break;
+    case 'd': seconds = atof(optarg); break;
+    case 'e': epochs = strtoul(optarg, NULL, 10); break;
+    case OPT_RATE: rate = atof(optarg); break;
+    case OPT_BBOX: bboxEvery = (unsigned)atoi(optarg); break;
+    default: usage(); return opt == 'h' ? 0 : 2;
+    }
+  }
+  if (units == 0 || epochs == 0 || feeders == 0 || seconds <= 0)
+  {
+    usage();
+    return 2;
+  }
+
+  std::vector<Stream> streams(units);
+  size_t bytes = 0;
+  for (size_t i = 0; i < units; ++i)
+  {
+    render(streams[i], (uint32_t)i, epochs);
+    bytes += streams[i].bytes.size();
+  }
+  printf("%zu units, %zu epochs and %.1f MB rendered, %u readers, %u feeders, %s\n",
+    units, epochs, bytes / 1e6, readers, feeders, rate > 0 ? "paced" : "flood");
+  printf("workers     epochs/s     MB/s    latest/s     bbox/s  hits/box   torn  fails\n");
+
+  for (const char *p = workerList; *p; )
+  {
+    unsigned w = (unsigned)strtoul(p, (char **)&p, 10);
+    if (w && !runOnce(streams, w, readers, feeders, seconds, rate, bboxEvery))
+      return 1;
+    if (*p == ',')
+      ++p;
+    else if (*p)
+      break;
+  }
+  return 0;
+}
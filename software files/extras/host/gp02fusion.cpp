@@ -0,0 +1,349 @@
+/*
+gp02fusion - replays two or more GP-02 streams through GP02Fusion.
+
+Without file arguments, two GP02Synth receivers drive the same route: receiver 0 tracks
+GPS+BDS, receiver 1 GPS+GLONASS (the J4 setting), each with its own seed and a wandering
+position error that scales with its HDOP. Their epochs are interleaved the way two serial
+ports would deliver them, and every fused epoch is compared against the ground truth,
+together with each receiver on its own and an unweighted mean of the two. --outage drops
+receiver 1's output for a range of epochs, --glitch throws its position off by a few hundred
+meters now and then (a multipath jump), which the spread gate should reject.
+
+With file arguments, recorded captures are replayed epoch by epoch, one receiver per file;
+without ground truth the report covers the epoch counts and the spread between receivers.
+
+Either way the cost of every update() call is timed; calls that fuse an epoch are reported
+separately. --csv writes one line per fused epoch.
+
+Build (host):
+   g++ -std=c++17 -O2 -I. -I../../src gp02fusion.cpp GP02Synth.cpp ../../src/GP02Fusion.cpp ../../src/GP02.cpp -o gp02fusion
+
+Examples:
+   gp02fusion -n 3600 --position-error 2.5
+   gp02fusion -n 3600 -r 5 --outage 1000,1500 --glitch 0.01
+   gp02fusion --csv fused.csv bds.nmea glonass.nmea
+*/
+
+#include "GP02Fusion.h"
+#include "GP02Synth.h"
+
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+struct Timing
+{
+  std::vector<uint32_t> idle, fusing;   // ns per update() call
+
+  bool update(GP02Fusion &fusion)
+  {
+    Clock::time_point t = Clock::now();
+    bool fused = fusion.update();
+    uint32_t ns = (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t).count();
+    (fused ? fusing : idle).push_back(ns);
+    return fused;
+  }
+};
+
+// horizontal errors in meters of one position source
+struct Errors
+{
+  const char *name;
+  std::vector<double> meters;
+};
+
+static double percentile(std::vector<double> v, double q)
+{
+  if (v.empty())
+    return 0;
+  std::sort(v.begin(), v.end());
+  return v[(size_t)(q * (v.size() - 1) + 0.5)];
+}
+
+static uint32_t percentile(std::vector<uint32_t> v, double q)
+{
+  if (v.empty())
+    return 0;
+  std::sort(v.begin(), v.end());
+  return v[(size_t)(q * (v.size() - 1) + 0.5)];
+}
+
+static double toDegrees(const RawDegrees &d)
+{
+  return GP02Fusion::nanodegrees(d) / 1e9;
+}
+
+static void writeCsv(FILE *csv, const GP02FusedFix &f)
+{
+  if (csv)
+    fprintf(csv, "%08u,%.9f,%.9f,%.2f,%.2f,%.2f,%u,%u,%u,%.1f\n", (unsigned)f.time, toDegrees(f.lat), toDegrees(f.lng),
+      f.speed / 100.0, f.course / 100.0, f.hdop / 100.0, (unsigned)f.satellites, f.receivers, f.rejected, f.spread / 10.0);
+}
+
+static void report(const GP02Fusion &fusion, const Timing &timing, const std::vector<double> &spread)
+{
+  const GP02FusionStats &s = fusion.stats();
+  printf("\n%u epochs fused, %u from two or more receivers; %u empty, %u late fixes, %u unusable, %u outliers rejected, %u resyncs\n",
+    (unsigned)s.epochs, (unsigned)s.combined, (unsigned)s.empty, (unsigned)s.late, (unsigned)s.unusable, (unsigned)s.outliers,
+    (unsigned)s.resyncs);
+  printf("spread between receivers  p50 %.1f m  p95 %.1f m  max %.1f m\n",
+    percentile(spread, 0.5), percentile(spread, 0.95), spread.empty() ? 0 : *std::max_element(spread.begin(), spread.end()));
+  printf("update() cost             calls    p50    p99    max (ns)\n");
+  printf("  collecting         %10zu %6u %6u %6u\n", timing.idle.size(), percentile(timing.idle, 0.5),
+    percentile(timing.idle, 0.99), timing.idle.empty() ? 0 : *std::max_element(timing.idle.begin(), timing.idle.end()));
+  printf("  fusing an epoch    %10zu %6u %6u %6u\n", timing.fusing.size(), percentile(timing.fusing, 0.5),
+    percentile(timing.fusing, 0.99), timing.fusing.empty() ? 0 : *std::max_element(timing.fusing.begin(), timing.fusing.end()));
+}
+
+static int replay(std::vector<const char *> paths, GP02Fusion &fusion, FILE *csv)
+{
+  size_t n = paths.size();
+  std::vector<std::string> data(n);
+  std::vector<size_t> pos(n, 0);
+  std::vector<GP02> gps(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    FILE *f = fopen(paths[i], "rb");
+    if (f == NULL)
+    {
+      perror(paths[i]);
+      return 1;
+    }
+    char buf[65536];
+    size_t got;
+    while ((got = fread(buf, 1, sizeof(buf), f)) > 0)
+      data[i].append(buf, got);
+    fclose(f);
+    gps[i].enableEpochs();
+    fusion.add(gps[i]);
+  }
+
+  Timing timing;
+  std::vector<double> spread;
+  for (bool more = true; more; )
+  {
+    more = false;
+    // one receiver epoch per file in turn, as if the ports had been read in one loop() pass
+    for (size_t i = 0; i < n; ++i)
+    {
+      while (pos[i] < data[i].size() && !gps[i].epoch.isUpdated())
+        gps[i].encode(data[i][pos[i]++]);
+      more |= pos[i] < data[i].size();
+      if (timing.update(fusion))
+      {
+        const GP02FusedFix &f = fusion.value();
+        if (f.contributors() > 1)
+          spread.push_back(f.spread / 10.0);
+        writeCsv(csv, f);
+      }
+    }
+  }
+  report(fusion, timing, spread);
+  return 0;
+}
+
+static void usage()
+{
+  fprintf(stderr,
+    "usage: gp02fusion [options] [CAPTURE...]\n"
+    "  -n, --epochs N          synthetic epochs (default 3600)\n"
+    "  -r, --rate HZ           synthetic epoch rate (default 1)\n"
+    "  -s, --seed N            random seed (default 1)\n"
+    "      --position-error M  meters of error per unit of HDOP (default 2.5)\n"
+    "      --outage A,B        receiver 1 silent from epoch A to B\n"
+    "      --glitch P          per epoch: receiver 1 jumps 200-500 m\n"
+    "      --max-spread M      GP02FusionPolicy::maxSpreadMeters (default 50)\n"
+    "      --csv FILE          one line per fused epoch\n");
+}
+
+int main(int argc, char **argv)
+{
+  enum { OPT_POSERR = 256, OPT_OUTAGE, OPT_GLITCH, OPT_SPREAD, OPT_CSV };
+  static const struct option options[] = {
+    { "epochs", required_argument, NULL, 'n' },
+    { "rate", required_argument, NULL, 'r' },
+    { "seed", required_argument, NULL, 's' },
+    { "position-error", required_argument, NULL, OPT_POSERR },
+    { "outage", required_argument, NULL, OPT_OUTAGE },
+    { "glitch", required_argument, NULL, OPT_GLITCH },
+    { "max-spread", required_argument, NULL, OPT_SPREAD },
+    { "csv", required_argument, NULL, OPT_CSV },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 } };
+
+  unsigned long epochs = 3600, outageFrom = 0, outageTo = 0;
+  uint16_t rate = 1;
+  uint32_t seed = 1;
+  double positionError = 2.5, glitch = 0;
+  GP02FusionPolicy policy;
+  const char *csvPath = NULL;
+
+  int opt;
+  while ((opt = getopt_long(argc, argv, "n:r:s:h", options, NULL)) != -1)
+  {
+    switch (opt)
+    {
+    case 'n': epochs = strtoul(optarg, NULL, 10); break;
+    case 'r': rate = (uint16_t)atoi(optarg); break;
+    case 's': seed = (uint32_t)strtoul(optarg, NULL, 10); break;
+    case OPT_POSERR: positionError = atof(optarg); break;
+    case OPT_OUTAGE:
+      if (sscanf(optarg, "%lu,%lu", &outageFrom, &outageTo) != 2)
+      {
+        usage();
+        return 2;
+      }
+      break;
+    case OPT_GLITCH: glitch = atof(optarg); break;
+    case OPT_SPREAD: policy.maxSpreadMeters = (uint16_t)atoi(optarg); break;
+    case OPT_CSV: csvPath = optarg; break;
+    default: usage(); return opt == 'h' ? 0 : 2;
+    }
+  }
+
+  FILE *csv = NULL;
+  if (csvPath)
+  {
+    csv = fopen(csvPath, "w");
+    if (csv == NULL)
+    {
+      perror(csvPath);
+      return 1;
+    }
+    fprintf(csv, "time,lat,lng,knots,course,hdop,satellites,receivers,rejected,spread\n");
+  }
+
+  GP02Fusion fusion(policy);
+  if (optind < argc)
+  {
+    int rc = replay(std::vector<const char *>(argv + optind, argv + argc), fusion, csv);
+    if (csv)
+      fclose(csv);
+    return rc;
+  }
+  if (epochs == 0 || rate == 0)
+  {
+    usage();
+    return 2;
+  }
+
+  GP02SynthConfig cfg[2];
+  cfg[0].constellations = GP02SynthConfig::GPS | GP02SynthConfig::BDS;
+  cfg[1].constellations = GP02SynthConfig::GPS | GP02SynthConfig::GLONASS;
+  for (int i = 0; i < 2; ++i)
+  {
+    cfg[i].rateHz = rate;
+    cfg[i].seed = seed * 2 + i;
+    cfg[i].positionError = positionError;
+  }
+  GP02Synth synth0(cfg[0]), synth1(cfg[1]);
+  GP02 gps[2];
+  for (int i = 0; i < 2; ++i)
+  {
+    gps[i].enableEpochs(GP02Epoch::VTG);
+    fusion.add(gps[i]);
+  }
+
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> u(0, 1);
+  Errors errors[4] = { { "receiver 0 (GPS+BDS)", {} }, { "receiver 1 (GPS+GLONASS)", {} },
+                       { "unweighted mean", {} }, { "GP02Fusion", {} } };
+  std::vector<double> spread;
+  Timing timing;
+  unsigned glitches = 0;
+  // an epoch may be fused only when the next one arrives, so truths are kept by UTC time
+  std::map<uint32_t, GP02SynthTruth> truths;
+
+  for (unsigned long e = 0; e < epochs; ++e)
+  {
+    std::string bytes[2];
+    GP02SynthTruth truth = synth0.next(bytes[0]);
+    synth1.next(bytes[1]);
+    truths[truth.time] = truth;
+    if (truths.size() > 8)
+      truths.erase(truths.begin());
+    bool silent = e >= outageFrom && e < outageTo;
+
+    // a multipath jump: shift receiver 1's position and restore the checksums
+    if (!silent && glitch > 0 && u(rng) < glitch)
+    {
+      GP02 probe;
+      probe.encode(bytes[1].data(), bytes[1].size());
+      double jump = (200 + 300 * u(rng)) * (u(rng) < 0.5 ? -1 : 1);
+      double lat = probe.location.lat() + jump / 111195.0;
+      std::string out;
+      for (size_t p = 0; p < bytes[1].size(); )
+      {
+        size_t end = bytes[1].find('\n', p) + 1;
+        std::string line = bytes[1].substr(p, end - p);
+        p = end;
+        size_t star = line.find('*');
+        std::string body = line.substr(1, star - 1);
+        if (body.compare(2, 3, "GGA") == 0 || body.compare(2, 3, "RMC") == 0)
+        {
+          // latitude is the field after the time (GGA) or after time and status (RMC)
+          size_t field = body.compare(2, 3, "GGA") == 0 ? 2 : 3, at = 0;
+          for (size_t f = 0; f < field; ++f)
+            at = body.find(',', at) + 1;
+          size_t comma = body.find(',', at);
+          double a = fabs(lat);
+          char text[24];
+          snprintf(text, sizeof(text), "%02d%08.5f", (int)a, (a - (int)a) * 60);
+          body.replace(at, comma - at, text);
+        }
+        out += GP02Synth::sentence(body.c_str());
+      }
+      bytes[1] = out;
+      ++glitches;
+    }
+
+    for (int i = 0; i < 2; ++i)
+    {
+      if (i == 1 && silent)
+        continue;
+      gps[i].encode(bytes[i].data(), bytes[i].size());
+      double lat = gps[i].location.lat(), lng = gps[i].location.lng();
+      errors[i].meters.push_back(GP02::distanceBetween(truth.lat, truth.lng, lat, lng));
+      if (timing.update(fusion))
+      {
+        const GP02FusedFix &f = fusion.value();
+        const GP02SynthTruth &t = truths[f.time];
+        errors[3].meters.push_back(GP02::distanceBetween(t.lat, t.lng, toDegrees(f.lat), toDegrees(f.lng)));
+        if (f.contributors() > 1)
+          spread.push_back(f.spread / 10.0);
+        writeCsv(csv, f);
+      }
+    }
+    if (!silent)
+      errors[2].meters.push_back(GP02::distanceBetween(truth.lat, truth.lng,
+        (gps[0].location.lat() + gps[1].location.lat()) / 2, (gps[0].location.lng() + gps[1].location.lng()) / 2));
+  }
+  if (csv)
+    fclose(csv);
+
+  printf("%lu epochs at %u Hz, %.1f m error per unit of HDOP, receiver 1 silent for %lu epochs, %u glitches\n\n",
+    epochs, (unsigned)rate, positionError, outageTo > outageFrom ? outageTo - outageFrom : 0, glitches);
+  printf("horizontal error             epochs    rms    p50    p95    max (m)\n");
+  for (int i = 0; i < 4; ++i)
+  {
+    const std::vector<double> &m = errors[i].meters;
+    double sum2 = 0;
+    for (size_t k = 0; k < m.size(); ++k)
+      sum2 += m[k] * m[k];
+    printf("%-26s %8zu %6.2f %6.2f %6.2f %6.2f\n", errors[i].name, m.size(), m.empty() ? 0 : sqrt(sum2 / m.size()),
+      percentile(m, 0.5), percentile(m, 0.95), m.empty() ? 0 : *std::max_element(m.begin(), m.end()));
+  }
+  report(fusion, timing, spread);
+  return 0;
+}
@@ -0,0 +1,277 @@
+/*
+gp02fuzz - damages GP02Synth streams and checks what GP02 commits, with and without strict framing.
+
+A clean stream is rendered first; every sentence in it is intact by definition. The stream is
+then damaged byte by byte (drops, bit flips, inserted random bytes) and sentence by sentence
+(cut short, line noise in front), and fed to one parser per framing mode. The GP02::onTrace()
+hook records where each committed sentence started and ended, so every commit can be checked
+against the clean sentences:
+
+   false commits    committed text that is not a well-formed sentence of the clean stream
+     merged         ... spanning a line end, i.e. fragments of two sentences
+     malformed      ... a clean sentence with a valid checksum but an oversize term or
+                        length (gp02synth --oversize), committed with truncated values
+     damaged        ... within one sentence, damaged in a way the XOR checksum cannot see
+                        (e.g. two equal bytes dropped)
+
+Per-byte cost is timed around every encode() call and reported as percentiles, so the
+tail (the byte that completes a sentence, or a long run of garbage) is visible. A second pass
+feeds pure random bytes to show what a line carrying nothing but noise costs.
+
+Build (host):
+   g++ -std=c++17 -O2 -I. -I../../src gp02fuzz.cpp GP02Synth.cpp ../../src/GP02.cpp -o gp02fuzz
+
+Examples:
+   gp02fuzz -n 20000
+   gp02fuzz -n 5000 --drop 0.01 --flip 0.005 --insert 0.005 --cut 0.05 -s 7
+*/
+
+#include "GP02.h"
+#include "GP02Synth.h"
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+struct Damage
+{
+  double drop, flip, insert;     // per byte
+  double cut, noise;             // per sentence
+};
+
+struct Result
+{
+  uint64_t commits, falseCommits, merged, malformed, damaged;
+  uint32_t failedChecksum, framingErrors;
+  std::vector<uint32_t> cost;    // ns per encode() call
+  double nsPerByte;
+};
+
+struct Probe
+{
+  const std::string *stream;
+  const std::unordered_set<std::string> *intact, *malformed;
+  uint32_t start;
+  Result *result;
+};
+
+static void onTrace(void *context, GP02 &gps, uint8_t event, uint8_t)
+{
+  Probe &p = *static_cast<Probe *>(context);
+  if (event == GP02::TraceStart)
+    p.start = gps.charsProcessed() - 1;
+  else if (event == GP02::TraceCommit)
+  {
+    ++p.result->commits;
+    // from '$' up to, not including, the terminator that closed the checksum term
+    uint32_t end = gps.charsProcessed() - 1;
+    std::string text = p.stream->substr(p.start, end - p.start);
+    if (p.intact->count(text) == 0)
+    {
+      ++p.result->falseCommits;
+      if (text.find_first_of("\r\n") != std::string::npos)
+        ++p.result->merged;
+      else if (p.malformed->count(text))
+        ++p.result->malformed;
+      else
+        ++p.result->damaged;
+    }
+  }
+}
+
+static void damage(const std::string &clean, std::string &out, const Damage &d, std::mt19937 &rng)
+{
+  std::uniform_real_distribution<double> u(0, 1);
+  bool cutting = false;
+  for (size_t i = 0; i < clean.size(); ++i)
+  {
+    char c = clean[i];
+    if (c == '$')
+    {
+      cutting = u(rng) < d.cut;
+      if (u(rng) < d.noise)
+        for (int n = 1 + rng() % 20; n > 0; --n)
+          out += (char)(rng() & 0xFF);
+    }
+    // a cut sentence loses everything from a random point up to the next sentence
+    if (cutting && c != '$' && u(rng) < 0.1)
+    {
+      while (i + 1 < clean.size() && clean[i + 1] != '$')
+        ++i;
+      cutting = false;
+      continue;
+    }
+    if (u(rng) < d.drop)
+      continue;
+    if (u(rng) < d.flip)
+      c ^= (char)(1 << (rng() % 8));
+    out += c;
+    if (u(rng) < d.insert)
+      out += (char)(rng() & 0xFF);
+  }
+}
+
+static uint32_t percentile(const std::vector<uint32_t> &sorted, double q)
+{
+  return sorted.empty() ? 0 : sorted[(size_t)(q * (sorted.size() - 1))];
+}
+
+static void run(const std::string &stream, const std::unordered_set<std::string> &intact,
+  const std::unordered_set<std::string> &malformed, bool strict, Result &r)
+{
+  r = Result();
+  GP02 gps;
+  Probe probe = { &stream, &intact, &malformed, 0, &r };
+  gps.onTrace(onTrace, &probe);
+  if (strict)
+    gps.enableStrictFraming();
+
+  typedef std::chrono::steady_clock Clock;
+  r.cost.reserve(stream.size());
+  for (size_t i = 0; i < stream.size(); ++i)
+  {
+    Clock::time_point t = Clock::now();
+    gps.encode(stream[i]);
+    r.cost.push_back((uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t).count());
+  }
+  std::sort(r.cost.begin(), r.cost.end());
+  r.failedChecksum = gps.failedChecksum();
+  r.framingErrors = gps.framingErrors();
+
+  // throughput without the per-byte clock reads
+  GP02 plain;
+  if (strict)
+    plain.enableStrictFraming();
+  Clock::time_point t = Clock::now();
+  plain.encode(stream.data(), stream.size());
+  r.nsPerByte = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t).count() / (double)stream.size();
+}
+
+static void print(const char *name, const Result &r)
+{
+  printf("%-16s %8llu %6llu %6llu %9llu %7llu %8u %8u %7.1f %6u %6u %7u %7u\n", name,
+    (unsigned long long)r.commits, (unsigned long long)r.falseCommits, (unsigned long long)r.merged,
+    (unsigned long long)r.malformed, (unsigned long long)r.damaged, r.failedChecksum, r.framingErrors, r.nsPerByte,
+    percentile(r.cost, 0.5), percentile(r.cost, 0.99), percentile(r.cost, 0.9999), r.cost.empty() ? 0 : r.cost.back());
+}
+
+static void usage()
+{
+  fprintf(stderr,
+    "usage: gp02fuzz [options]\n"
+    "  -n, --epochs N      epochs rendered (default 10000)\n"
+    "  -s, --seed N        random seed (default 1)\n"
+    "      --drop P        per byte: byte removed (default 0.002)\n"
+    "      --flip P        per byte: one bit flipped (default 0.001)\n"
+    "      --insert P      per byte: random byte inserted after it (default 0.001)\n"
+    "      --cut P         per sentence: rest of the sentence lost (default 0.02)\n"
+    "      --noise P       per sentence: 1-20 random bytes in front (default 0.02)\n"
+    "      --oversize P    per sentence: checksum-valid oversize field from gp02synth (default 0.01)\n");
+}
+
+int main(int argc, char **argv)
+{
+  enum { OPT_DROP = 256, OPT_FLIP, OPT_INSERT, OPT_CUT, OPT_NOISE, OPT_OVERSIZE };
+  static const struct option options[] = {
+    { "epochs", required_argument, NULL, 'n' },
+    { "seed", required_argument, NULL, 's' },
+    { "drop", required_argument, NULL, OPT_DROP },
+    { "flip", required_argument, NULL, OPT_FLIP },
+    { "insert", required_argument, NULL, OPT_INSERT },
+    { "cut", required_argument, NULL, OPT_CUT },
+    { "noise", required_argument, NULL, OPT_NOISE },
+    { "oversize", required_argument, NULL, OPT_OVERSIZE },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 } };
+
+  unsigned long epochs = 10000;
+  uint32_t seed = 1;
+  Damage d = { 0.002, 0.001, 0.001, 0.02, 0.02 };
+  double oversize = 0.01;
+
+  int opt;
+  while ((opt = getopt_long(argc, argv, "n:s:h", options, NULL)) != -1)
+  {
+    switch (opt)
+    {
+    case 'n': epochs = strtoul(optarg, NULL, 10); break;
+    case 's': seed = (uint32_t)strtoul(optarg, NULL, 10); break;
+    case OPT_DROP: d.drop = atof(optarg); break;
+    case OPT_FLIP: d.flip = atof(optarg); break;
+    case OPT_INSERT: d.insert = atof(optarg); break;
+    case OPT_CUT: d.cut = atof(optarg); break;
+    case OPT_NOISE: d.noise = atof(optarg); break;
+    case OPT_OVERSIZE: oversize = atof(optarg); break;
+    default: usage(); return opt == 'h' ? 0 : 2;
+    }
+  }
+  if (epochs == 0)
+  {
+    usage();
+    return 2;
+  }
+
+  // oversize fields keep a valid checksum, so only framing can reject them
+  GP02SynthConfig cfg;
+  cfg.seed = seed;
+  cfg.oversizeField = oversize;
+  GP02Synth synth(cfg);
+  std::string clean;
+  for (unsigned long e = 0; e < epochs; ++e)
+    synth.next(clean);
+
+  std::unordered_set<std::string> intact, malformed;
+  for (size_t pos = 0; (pos = clean.find('$', pos)) != std::string::npos; )
+  {
+    size_t end = clean.find('\r', pos);
+    std::string s = clean.substr(pos, end - pos);
+    size_t longest = 0, term = 0;
+    for (size_t i = 1; i < s.size(); ++i, ++term)
+      if (s[i] == ',' || s[i] == '*')
+        term = (size_t)-1;
+      else if (term + 1 > longest)
+        longest = term + 1;
+    if (s.size() + 2 > _GPS_MAX_SENTENCE_LENGTH || longest >= _GPS_MAX_FIELD_SIZE)
+      malformed.insert(s);
+    else
+      intact.insert(s);
+    pos = end;
+  }
+
+  std::mt19937 rng(seed);
+  std::string damaged;
+  damage(clean, damaged, d, rng);
+
+  std::string garbage(damaged.size(), '\0');
+  for (size_t i = 0; i < garbage.size(); ++i)
+    garbage[i] = (char)(rng() & 0xFF);
+
+  printf("%lu epochs, %zu clean bytes, %zu after damage, %zu well-formed and %zu malformed distinct sentences\n\n",
+    epochs, clean.size(), damaged.size(), intact.size(), malformed.size());
+  printf("                  commits  false merged malformed damaged checksum  framing ns/byte  -- ns per encode() --\n");
+  printf("stream / mode                                                 failed   errors            p50    p99 p99.99     max\n");
+
+  Result r;
+  run(damaged, intact, malformed, false, r);
+  print("damaged/default", r);
+  run(damaged, intact, malformed, true, r);
+  print("damaged/strict", r);
+  uint64_t strictFramingMisses = r.merged + r.malformed;
+  run(garbage, intact, malformed, false, r);
+  print("garbage/default", r);
+  run(garbage, intact, malformed, true, r);
+  print("garbage/strict", r);
+  strictFramingMisses += r.merged + r.malformed;
+
+  printf("\nper-byte times include two clock reads; 'damaged' false commits are checksum collisions that no framing check can see\n");
+  // strict framing must never let a structural error through
+  return strictFramingMisses == 0 ? 0 : 1;
+}
@@ -0,0 +1,524 @@
+/*
+gp02latency - measures how stale a fix is by the time the application reads it.
+
+Every sentence is broken down into the stages between the receiver's UTC epoch and the
+consumer seeing the committed value:
+
+   epoch>burst    UTC epoch to the first byte of the epoch's burst on the wire
+   burst>$        first byte of the burst to this sentence's '$' (sentences queued ahead of it)
+   $>commit       '$' on the wire to the checksum commit (transmission, driver, parsing)
+   commit>read    commit to the consumer loop picking the value up
+   epoch>read     the whole chain
+
+and min/median/p90/p99/max, mean and jitter (standard deviation) are printed per sentence type.
+
+Replay mode paces a capture (e.g. gp02synth -o capture.nmea) through a pseudo-terminal at each
+baud rate given with -b: every epoch's burst starts at its UTC time relative to the first epoch
+and its bytes leave at ten bit times each, delivered in --tick sized groups the way a UART
+FIFO hands them to the driver. Live mode (-l) reads a real receiver and takes the epoch from
+the host's CLOCK_REALTIME, so the host clock should be disciplined (NTP, PPS).
+
+Wire times are estimated from the baud rate and the time each read completed, as
+GP02SerialPort does; '$' and commit come from the GP02::onTrace() hook.
+
+Build (host):
+   g++ -std=c++17 -O2 -pthread -I. -I../../src gp02latency.cpp GP02Serial.cpp ../../src/GP02.cpp -o gp02latency
+
+Examples:
+   gp02synth -r 10 -n 200 -o capture.nmea
+   gp02latency -b 9600,38400,115200 capture.nmea
+   gp02latency --consumer-hz 50 --csv sentences.csv capture.nmea
+   gp02latency -l /dev/ttyUSB0@115200 -d 60
+*/
+
+#include "GP02Serial.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define NS_PER_MS 1000000LL
+#define NS_PER_DAY (86400LL * 1000 * NS_PER_MS)
+
+enum Stage { EpochToBurst, BurstToStart, StartToCommit, CommitToRead, EpochToRead, StageCount };
+static const char *stageNames[StageCount] = { "epoch>burst", "burst>$", "$>commit", "commit>read", "epoch>read" };
+
+// GP02Epoch::Sentence bits, plus "other" for everything the parser does not decode
+enum { TypeGGA, TypeRMC, TypeGSA, TypeGSV, TypeVTG, TypeOther, TypeCount };
+static const char *typeNames[TypeCount] = { "GGA", "RMC", "GSA", "GSV", "VTG", "other" };
+
+static volatile sig_atomic_t stop = 0;
+
+static void onSignal(int)
+{
+  stop = 1;
+}
+
+static int typeIndex(uint8_t sentence)
+{
+  for (int i = 0; i < TypeOther; ++i)
+    if (sentence == 1 << i)
+      return i;
+  return TypeOther;
+}
+
+struct Sentence
+{
+  int type;
+  int64_t epoch, burst, start, commit, read;   // CLOCK_REALTIME ns
+};
+
+struct Probe
+{
+  GP02SerialPort *port;
+  int64_t anchor;                // epoch(ms of day) = anchor + ms * 1e6, before day wrap
+  int64_t start;                 // wire time of the current sentence's '$'
+  uint32_t epochMs;
+  bool haveEpoch;
+  int64_t burst;
+  std::vector<Sentence> pending; // committed, not yet seen by the consumer
+  std::vector<Sentence> done;
+  uint32_t failed[TypeCount];
+};
+
+// CLOCK_REALTIME time at which the byte that raised the trace event was on the wire
+static int64_t wireTime(const GP02SerialPort &port, uint32_t charsProcessed)
+{
+  uint32_t behind = (uint32_t)port.bytesRead() - charsProcessed;
+  if (port.baud() == 0)
+    return port.rxTime();
+  return port.rxTime() - (int64_t)behind * 10000000000LL / (int64_t)port.baud();
+}
+
+static void onTrace(void *context, GP02 &gps, uint8_t event, uint8_t sentence)
+{
+  Probe &p = *static_cast<Probe *>(context);
+  if (event == GP02::TraceStart)
+    p.start = wireTime(*p.port, gps.charsProcessed());
+  else if (event == GP02::TraceFail)
+    ++p.failed[typeIndex(sentence)];
+  else if (event == GP02::TraceCommit)
+  {
+    int64_t commit = GP02SerialHub::now();
+    if (!gps.time.isValid())
+      return;
+    // sentences without a time field belong to the epoch of the last time seen
+    uint32_t ms = gps.time.millisOfDay();
+    if (!p.haveEpoch || ms != p.epochMs)
+    {
+      p.haveEpoch = true;
+      p.epochMs = ms;
+      p.burst = p.start;
+    }
+    Sentence s;
+    s.type = typeIndex(sentence);
+    s.epoch = p.anchor + ms * NS_PER_MS;
+    // take the day that puts the epoch nearest to the commit
+    while (s.epoch > commit + NS_PER_DAY / 2)
+      s.epoch -= NS_PER_DAY;
+    while (s.epoch < commit - NS_PER_DAY / 2)
+      s.epoch += NS_PER_DAY;
+    s.burst = p.burst;
+    s.start = p.start;
+    s.commit = commit;
+    s.read = 0;
+    p.pending.push_back(s);
+  }
+}
+
+static void consume(Probe &p, int64_t now)
+{
+  for (size_t i = 0; i < p.pending.size(); ++i)
+  {
+    p.pending[i].read = now;
+    p.done.push_back(p.pending[i]);
+  }
+  p.pending.clear();
+}
+
+// Reads the probe's port until the replay ends, the duration expires or a signal arrives. With
+// consumerHz the application is modelled as a loop that looks at the parser at a fixed rate;
+// otherwise it looks right after every poll.
+static void service(GP02SerialHub &hub, Probe &p, double consumerHz, double seconds, const std::atomic<bool> &finished)
+{
+  int64_t start = GP02SerialHub::now();
+  int64_t tick = (int64_t)(consumerHz > 0 ? 1e9 / consumerHz : 0);
+  int64_t nextTick = start + tick;
+  int64_t end = seconds > 0 ? start + (int64_t)(seconds * 1e9) : 0;
+
+  while (!stop && p.port->isOpen())
+  {
+    int64_t now = GP02SerialHub::now();
+    if (end && now >= end)
+      break;
+    int timeout = 100;
+    if (tick)
+      timeout = nextTick > now ? (int)((nextTick - now + NS_PER_MS - 1) / NS_PER_MS) : 0;
+    if (hub.poll(timeout) < 0)
+      break;
+
+    now = GP02SerialHub::now();
+    if (!tick)
+      consume(p, now);
+    else if (now >= nextTick)
+    {
+      consume(p, now);
+      while (nextTick <= now)
+        nextTick += tick;
+    }
+    // the writer has finished and everything it wrote has been read
+    if (finished.load() && hub.poll(0) == 0 && p.pending.empty())
+      break;
+  }
+  consume(p, GP02SerialHub::now());
+}
+
+static int64_t percentile(const std::vector<int64_t> &sorted, double q)
+{
+  size_t i = (size_t)(q * (sorted.size() - 1) + 0.5);
+  return sorted[i];
+}
+
+static void report(const Probe &p, const char *title)
+{
+  size_t failed = 0;
+  for (int t = 0; t < TypeCount; ++t)
+    failed += p.failed[t];
+  printf("%s: %zu sentences, %zu failed checksum\n", title, p.done.size(), failed);
+  printf("type  stage            n     min     p50     p90     p99     max    mean  jitter   (ms)\n");
+
+  for (int t = 0; t < TypeCount; ++t)
+    for (int s = 0; s < StageCount; ++s)
+    {
+      std::vector<int64_t> v;
+      for (size_t i = 0; i < p.done.size(); ++i)
+      {
+        const Sentence &x = p.done[i];
+        if (x.type != t)
+          continue;
+        int64_t d = 0;
+        switch (s)
+        {
+        case EpochToBurst: d = x.burst - x.epoch; break;
+        case BurstToStart: d = x.start - x.burst; break;
+        case StartToCommit: d = x.commit - x.start; break;
+        case CommitToRead: d = x.read - x.commit; break;
+        case EpochToRead: d = x.read - x.epoch; break;
+        }
+        v.push_back(d);
+      }
+      if (v.empty())
+        break;
+      std::sort(v.begin(), v.end());
+      double mean = 0, var = 0;
+      for (size_t i = 0; i < v.size(); ++i)
+        mean += v[i];
+      mean /= v.size();
+      for (size_t i = 0; i < v.size(); ++i)
+        var += (v[i] - mean) * (v[i] - mean);
+      double sd = sqrt(var / v.size());
+      printf("%-5s %-12s %6zu %7.3f %7.3f %7.3f %7.3f %7.3f %7.3f %7.3f\n", s == 0 ? typeNames[t] : "",
+        stageNames[s], v.size(), v.front() / 1e6, percentile(v, 0.5) / 1e6, percentile(v, 0.9) / 1e6,
+        percentile(v, 0.99) / 1e6, v.back() / 1e6, mean / 1e6, sd / 1e6);
+    }
+  printf("\n");
+}
+
+static void writeCsv(FILE *csv, const Probe &p, unsigned long baud)
+{
+  for (size_t i = 0; i < p.done.size(); ++i)
+  {
+    const Sentence &x = p.done[i];
+    fprintf(csv, "%lu,%s,%lld,%lld,%lld,%lld,%lld\n", baud, typeNames[x.type], (long long)x.epoch,
+      (long long)(x.burst - x.epoch), (long long)(x.start - x.epoch), (long long)(x.commit - x.epoch),
+      (long long)(x.read - x.epoch));
+  }
+}
+
+// A capture split into lines, each tagged with the UTC millisecond of day of its epoch.
+struct Capture
+{
+  std::vector<std::string> lines;
+  std::vector<int64_t> epochMs;  // monotonic across midnight
+};
+
+static bool loadCapture(const char *path, Capture &cap)
+{
+  FILE *f = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+  if (f == NULL)
+    return false;
+  std::string line;
+  int64_t ms = -1, dayOffset = 0, last = -1;
+  for (int c; (c = fgetc(f)) != EOF; )
+  {
+    line += (char)c;
+    if (c != '\n')
+      continue;
+    // GGA and RMC carry the epoch time in their first field
+    if (line.size() > 14 && line[0] == '$' && (line.compare(3, 4, "GGA,") == 0 || line.compare(3, 4, "RMC,") == 0)
+        && line[7] != ',')
+    {
+      uint32_t t = GP02Time::millisFromPacked((uint32_t)GP02::parseDecimal(line.c_str() + 7));
+      if (last >= 0 && t + dayOffset < last - NS_PER_DAY / NS_PER_MS / 2)
+        dayOffset += NS_PER_DAY / NS_PER_MS;
+      ms = last = t + dayOffset;
+      // lines read before the first time belong to the first epoch
+      for (size_t i = 0; i < cap.epochMs.size(); ++i)
+        if (cap.epochMs[i] < 0)
+          cap.epochMs[i] = ms;
+    }
+    cap.lines.push_back(line);
+    cap.epochMs.push_back(ms);
+    line.clear();
+  }
+  if (f != stdin)
+    fclose(f);
+  return ms >= 0;
+}
+
+static void sleepUntil(int64_t t)
+{
+  struct timespec ts = { (time_t)(t / 1000000000LL), (long)(t % 1000000000LL) };
+  while (clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &ts, NULL) == EINTR && !stop)
+    ;
+}
+
+// Writes the capture to the master side of a pseudo-terminal as a receiver at the given baud
+// rate would: each burst starts at its epoch time (or when the line is free again) and bytes
+// arrive in groups, each written when the last byte of the group has left the wire.
+static void replay(int master, const Capture &cap, unsigned long baud, int64_t t0, int64_t tickNs,
+  std::atomic<bool> &finished, std::atomic<uint64_t> &lateBursts)
+{
+  double byteNs = 1e10 / baud;
+  int64_t ms0 = cap.epochMs[0], epochMs = -1, wire = t0;
+  std::string group;
+  int64_t groupDue = 0;
+
+  for (size_t i = 0; i < cap.lines.size() && !stop; ++i)
+  {
+    if (cap.epochMs[i] != epochMs)
+    {
+      epochMs = cap.epochMs[i];
+      int64_t epochStart = t0 + (epochMs - ms0) * NS_PER_MS;
+      if (wire > epochStart)
+        ++lateBursts;
+      else
+        wire = epochStart;
+    }
+    const std::string &line = cap.lines[i];
+    for (size_t k = 0; k < line.size(); ++k)
+    {
+      wire += (int64_t)byteNs;
+      if (!group.empty() && wire > groupDue)
+      {
+        sleepUntil(groupDue);
+        if (write(master, group.data(), group.size()) < 0)
+          break;
+        group.clear();
+      }
+      if (group.empty())
+        groupDue = wire - (int64_t)byteNs + tickNs;
+      group += line[k];
+    }
+    // a burst ends with the line going idle, so its tail is not held back for a full tick
+    bool lastOfEpoch = i + 1 == cap.lines.size() || cap.epochMs[i + 1] != epochMs;
+    if (lastOfEpoch && !group.empty())
+    {
+      sleepUntil(wire);
+      if (write(master, group.data(), group.size()) < 0)
+        break;
+      group.clear();
+    }
+  }
+  finished = true;
+}
+
+static bool runReplay(const Capture &cap, unsigned long baud, int64_t tickNs, double consumerHz, FILE *csv)
+{
+  int master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+  if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0)
+  {
+    perror("posix_openpt");
+    return false;
+  }
+
+  GP02 gps;
+  GP02SerialHub hub;
+  int port = hub.open(ptsname(master), baud, gps);
+  if (port < 0)
+  {
+    perror(ptsname(master));
+    close(master);
+    return false;
+  }
+
+  Probe p = Probe();
+  p.port = hub.port(port);
+  // give the reader a moment to block in epoll before the first burst
+  int64_t t0 = GP02SerialHub::now() + 100 * NS_PER_MS;
+  p.anchor = t0 - cap.epochMs[0] * NS_PER_MS;
+  gps.onTrace(onTrace, &p);
+
+  std::atomic<bool> finished(false);
+  std::atomic<uint64_t> late(0);
+  std::thread writer(replay, master, std::cref(cap), baud, t0, tickNs, std::ref(finished), std::ref(late));
+  service(hub, p, consumerHz, 0, finished);
+  writer.join();
+  close(master);
+
+  char title[64];
+  snprintf(title, sizeof(title), "%lu baud", baud);
+  report(p, title);
+  if (late)
+    fprintf(stderr, "gp02latency: %llu bursts at %lu baud started late because the previous one was still on the wire\n",
+      (unsigned long long)late.load(), baud);
+  if (csv)
+    writeCsv(csv, p, baud);
+  return true;
+}
+
+static bool runLive(const char *device, double seconds, double consumerHz, FILE *csv)
+{
+  char path[256];
+  unsigned long baud = 9600;
+  snprintf(path, sizeof(path), "%s", device);
+  char *at = strchr(path, '@');
+  if (at != NULL)
+  {
+    *at = '\0';
+    baud = strtoul(at + 1, NULL, 10);
+  }
+
+  GP02 gps;
+  GP02SerialHub hub;
+  int port = hub.open(path, baud, gps);
+  if (port < 0)
+  {
+    perror(path);
+    return false;
+  }
+
+  Probe p = Probe();
+  p.port = hub.port(port);
+  // UTC midnight; onTrace() moves epochs to the nearest day
+  int64_t now = GP02SerialHub::now();
+  p.anchor = now - now % NS_PER_DAY;
+  gps.onTrace(onTrace, &p);
+
+  std::atomic<bool> finished(false);
+  service(hub, p, consumerHz, seconds, finished);
+
+  char title[300];
+  snprintf(title, sizeof(title), "%s at %lu baud", path, baud);
+  report(p, title);
+  if (csv)
+    writeCsv(csv, p, baud);
+  return true;
+}
+
+static void usage()
+{
+  fprintf(stderr,
+    "usage: gp02latency [options] CAPTURE         (\"-\" reads standard input)\n"
+    "       gp02latency -l DEVICE[@BAUD] [options]\n"
+    "  -b, --baud LIST         replay: comma separated baud rates (default 9600,115200)\n"
+    "  -t, --tick US           replay: UART-to-driver delivery granularity (default 1000)\n"
+    "  -l, --live DEVICE       read a real receiver; epochs are taken from CLOCK_REALTIME\n"
+    "  -d, --duration S        live: seconds to measure (default 30)\n"
+    "      --consumer-hz HZ    model the application as a loop reading at HZ (default: after every read)\n"
+    "      --csv FILE          also write one row per sentence (ns since its epoch)\n");
+}
+
+int main(int argc, char **argv)
+{
+  enum { OPT_CONSUMER = 256, OPT_CSV };
+  static const struct option options[] = {
+    { "baud", required_argument, NULL, 'b' },
+    { "tick", required_argument, NULL, 't' },
+    { "live", required_argument, NULL, 'l' },
+    { "duration", required_argument, NULL, 'd' },
+    { "consumer-hz", required_argument, NULL, OPT_CONSUMER },
+    { "csv", required_argument, NULL, OPT_CSV },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 } };
+
+  const char *bauds = "9600,115200", *live = NULL, *csvPath = NULL;
+  double tickUs = 1000, seconds = 30, consumerHz = 0;
+
+  int opt;
+  while ((opt = getopt_long(argc, argv, "b:t:l:d:h", options, NULL)) != -1)
+  {
+    switch (opt)
+    {
+    case 'b': bauds = optarg; break;
+    case 't': tickUs = atof(optarg); break;
+    case 'l': live = optarg; break;
+    case 'd': seconds = atof(optarg); break;
+    case OPT_CONSUMER: consumerHz = atof(optarg); break;
+    case OPT_CSV: csvPath = optarg; break;
+    default: usage(); return opt == 'h' ? 0 : 2;
+    }
+  }
+  if ((live == NULL) == (optind >= argc) || tickUs <= 0)
+  {
+    usage();
+    return 2;
+  }
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  FILE *csv = NULL;
+  if (csvPath)
+  {
+    csv = fopen(csvPath, "w");
+    if (csv == NULL)
+    {
+      perror(csvPath);
+      return 1;
+    }
+    fprintf(csv, "baud,type,epoch_ns,burst_ns,start_ns,commit_ns,read_ns\n");
+  }
+
+  int rc = 0;
+  if (live)
+    rc = runLive(live, seconds, consumerHz, csv) ? 0 : 1;
+  else
+  {
+    Capture cap;
+    if (!loadCapture(argv[optind], cap))
+    {
+      fprintf(stderr, "gp02latency: %s: no GGA or RMC time found\n", argv[optind]);
+      return 1;
+    }
+    for (const char *p = bauds; *p && !stop; )
+    {
+      unsigned long baud = strtoul(p, (char **)&p, 10);
+      if (baud && !runReplay(cap, baud, (int64_t)(tickUs * 1000), consumerHz, csv))
+      {
+        rc = 1;
+        break;
+      }
+      if (*p == ',')
+        ++p;
+      else if (*p)
+        break;
+    }
+  }
+  if (csv)
+    fclose(csv);
+  return rc;
+}
@@ -0,0 +1,88 @@
+/*
+gp02mon - prints one line per receiver epoch for any number of GP-02 serial ports.
+
+Build (host):
+   g++ -std=c++17 -O2 -I. -I../../src gp02mon.cpp GP02Serial.cpp ../../src/GP02.cpp -o gp02mon
+
+Usage:
+   gp02mon /dev/ttyS1 /dev/ttyUSB0@115200 ...
+   gp02synth --pty -r 10 --baud 115200 &   gp02mon /dev/pts/N@115200
+*/
+
+#include "GP02Serial.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static volatile sig_atomic_t stop = 0;
+
+static void onSignal(int)
+{
+  stop = 1;
+}
+
+static void onSentence(void *, GP02SerialPort &port, const char *)
+{
+  GP02Epoch &epoch = port.gps().epoch;
+  if (!epoch.isUpdated())
+    return;
+
+  const GP02Fix &fix = epoch.value();
+  printf("%d %06u %08u %c%u.%09u %c%u.%09u q=%c sats=%u/%u hdop=%d.%02d kn=%d.%02d rx=%lld\n",
+    port.index(), (unsigned)fix.date, (unsigned)fix.time,
+    fix.lat.negative ? '-' : '+', fix.lat.deg, (unsigned)fix.lat.billionths,
+    fix.lng.negative ? '-' : '+', fix.lng.deg, (unsigned)fix.lng.billionths,
+    (char)fix.fixQuality, (unsigned)fix.satellites, fix.satellitesInView,
+    (int)(fix.hdop / 100), (int)(fix.hdop % 100), (int)(fix.speed / 100), (int)(fix.speed % 100),
+    (long long)port.rxFirstByteTime());
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 2)
+  {
+    fprintf(stderr, "usage: gp02mon DEVICE[@BAUD]...\n");
+    return 2;
+  }
+
+  GP02SerialHub hub;
+  GP02 *gps = new GP02[argc - 1];
+  for (int i = 1; i < argc; ++i)
+  {
+    char path[256];
+    unsigned long baud = 9600;
+    snprintf(path, sizeof(path), "%s", argv[i]);
+    char *at = strchr(path, '@');
+    if (at != NULL)
+    {
+      *at = '\0';
+      baud = strtoul(at + 1, NULL, 10);
+    }
+
+    gps[i - 1].enableEpochs(GP02Epoch::VTG);
+    if (hub.open(path, baud, gps[i - 1]) < 0)
+    {
+      perror(path);
+      return 1;
+    }
+  }
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+  hub.onSentence(onSentence, NULL);
+  while (!stop)
+  {
+    if (hub.poll(1000) < 0)
+      break;
+    fflush(stdout);
+  }
+
+  for (size_t i = 0; i < hub.portCount(); ++i)
+    fprintf(stderr, "port %u: %llu bytes in %u reads, %u sentences passed, %u failed\n", (unsigned)i,
+      (unsigned long long)hub.port((int)i)->bytesRead(), hub.port((int)i)->reads(),
+      gps[i].passedChecksum(), gps[i].failedChecksum());
+  delete[] gps;
+  return 0;
+}
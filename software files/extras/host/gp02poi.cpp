@@ -0,0 +1,291 @@
+/*
+gp02poi - builds, queries and benchmarks GP02PoiIndex point-of-interest blobs.
+
+   gp02poi build [-o BLOB] [--header FILE.h --name NAME] CSV    (lines of "id,lat,lng")
+   gp02poi query [-k N] [-r METERS] BLOB LAT LNG
+   gp02poi bench [-n POINTS] [-q QUERIES] [-k N] [-r METERS] [--box LAT0,LNG0,LAT1,LNG1]
+
+query memory-maps the blob, exactly as a long-running service would. bench scatters random
+points over the box (default: the whole globe), reports build time, blob bytes per point and
+the latency of nearest-1, nearest-k and radius queries, and checks a sample of the answers
+against a linear GP02::distanceBetween() scan, whose latency it reports as well.
+
+Build (host):
+   g++ -std=c++17 -O2 -I. -I../../src gp02poi.cpp GP02PoiBuilder.cpp ../../src/GP02PoiIndex.cpp ../../src/GP02.cpp -o gp02poi
+
+Example:
+   gp02poi bench -n 1000000 -q 200000
+   gp02poi build -o depots.poi depots.csv && gp02poi query -k 3 depots.poi 41.0082 28.9784
+*/
+
+#include "GP02PoiBuilder.h"
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <random>
+#include <vector>
+
+static double now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void usage()
+{
+  fprintf(stderr,
+    "usage: gp02poi build [-o BLOB] [--header FILE.h --name NAME] CSV\n"
+    "       gp02poi query [-k N] [-r METERS] BLOB LAT LNG\n"
+    "       gp02poi bench [-n POINTS] [-q QUERIES] [-k N] [-r METERS] [--box LAT0,LNG0,LAT1,LNG1]\n"
+    "  -o, --output BLOB    build: blob to write (default poi.bin)\n"
+    "      --header FILE.h  build: also write the blob as a C array named --name (default poi)\n"
+    "  -k N                 nearest points wanted (default 1 for query, 8 for bench)\n"
+    "  -r METERS            query: radius search instead of nearest; bench: radius (default 1000)\n"
+    "  -n N                 bench: points (default 1000000)\n"
+    "  -q N                 bench: queries per kind (default 100000)\n"
+    "      --box BOX        bench: scatter points and queries over this box\n");
+}
+
+static int build(const char *csvPath, const char *blobPath, const char *headerPath, const char *name)
+{
+  FILE *f = strcmp(csvPath, "-") == 0 ? stdin : fopen(csvPath, "r");
+  if (f == NULL)
+  {
+    perror(csvPath);
+    return 1;
+  }
+  GP02PoiBuilder b;
+  char line[256];
+  unsigned long lineNo = 0, skipped = 0;
+  while (fgets(line, sizeof(line), f))
+  {
+    ++lineNo;
+    unsigned long id;
+    double lat, lng;
+    if (line[0] == '#' || sscanf(line, "%lu,%lf,%lf", &id, &lat, &lng) != 3 || fabs(lat) > 90 || fabs(lng) > 180)
+    {
+      ++skipped;
+      continue;
+    }
+    b.add(lat, lng, (uint32_t)id);
+  }
+  if (f != stdin)
+    fclose(f);
+
+  double start = now();
+  b.build();
+  double elapsed = now() - start;
+  if (!b.writeBlob(blobPath) || (headerPath && !b.writeHeader(headerPath, name)))
+  {
+    perror(blobPath);
+    return 1;
+  }
+  fprintf(stderr, "gp02poi: %zu points (%lu lines skipped) built in %.3f s, %zu bytes\n",
+    b.size(), skipped, elapsed, b.blob().size());
+  return 0;
+}
+
+// a read-only mapping of a blob file
+struct Mapping
+{
+  void *base;
+  size_t length;
+
+  Mapping() : base(MAP_FAILED), length(0) {}
+  ~Mapping() { if (base != MAP_FAILED) munmap(base, length); }
+
+  bool open(const char *path)
+  {
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+      return false;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+      length = (size_t)st.st_size;
+      base = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    return base != MAP_FAILED;
+  }
+};
+
+static int query(const char *blobPath, double lat, double lng, size_t k, double radius)
+{
+  Mapping m;
+  GP02PoiIndex index;
+  if (!m.open(blobPath) || !index.attach(m.base, m.length))
+  {
+    fprintf(stderr, "gp02poi: %s is not a GP02PoiIndex blob\n", blobPath);
+    return 1;
+  }
+
+  std::vector<GP02Poi> hits(radius >= 0 ? 1024 : k);
+  size_t n = radius >= 0 ? index.within(lat, lng, radius, hits.data(), hits.size()) : index.nearest(lat, lng, hits.data(), k);
+  if (n > hits.size())
+  {
+    fprintf(stderr, "gp02poi: %zu points in range, showing %zu\n", n, hits.size());
+    n = hits.size();
+  }
+  printf("id,lat,lng,meters\n");
+  for (size_t i = 0; i < n; ++i)
+  {
+    double plat, plng;
+    index.location(hits[i].slot, plat, plng);
+    printf("%u,%.7f,%.7f,%.2f\n", (unsigned)hits[i].id, plat, plng, hits[i].meters);
+  }
+  return 0;
+}
+
+struct Box
+{
+  double lat0, lng0, lat1, lng1;
+};
+
+// uniform over the sphere inside the box, so that global tests do not crowd the poles
+static void randomPosition(std::mt19937_64 &rng, const Box &box, double &lat, double &lng)
+{
+  std::uniform_real_distribution<double> u(0, 1);
+  double z0 = sin(box.lat0 * M_PI / 180), z1 = sin(box.lat1 * M_PI / 180);
+  lat = asin(z0 + (z1 - z0) * u(rng)) * 180 / M_PI;
+  lng = box.lng0 + (box.lng1 - box.lng0) * u(rng);
+}
+
+static int bench(size_t count, size_t queries, size_t k, double radius, const Box &box)
+{
+  std::mt19937_64 rng(1);
+  std::vector<double> lats(count), lngs(count);
+  GP02PoiBuilder b;
+  b.reserve(count);
+  for (size_t i = 0; i < count; ++i)
+  {
+    randomPosition(rng, box, lats[i], lngs[i]);
+    b.add(lats[i], lngs[i], (uint32_t)i);
+  }
+
+  double start = now();
+  b.build();
+  double buildTime = now() - start;
+  const std::vector<uint8_t> &blob = b.blob();
+  GP02PoiIndex index;
+  index.attach(blob.data(), blob.size());
+  printf("%zu points: built in %.3f s, %zu bytes (%.1f bytes per point)\n",
+    count, buildTime, blob.size(), (double)blob.size() / count);
+
+  std::vector<double> qlat(queries), qlng(queries);
+  for (size_t i = 0; i < queries; ++i)
+    randomPosition(rng, box, qlat[i], qlng[i]);
+
+  std::vector<GP02Poi> hits(k > 256 ? k : 256);
+  uint64_t check = 0, found = 0;
+  printf("query                     per query\n");
+
+  start = now();
+  for (size_t i = 0; i < queries; ++i)
+    check += index.nearest(qlat[i], qlng[i], hits.data(), 1) ? hits[0].id : 0;
+  printf("nearest-1            %10.2f us\n", (now() - start) * 1e6 / queries);
+
+  start = now();
+  for (size_t i = 0; i < queries; ++i)
+    check += index.nearest(qlat[i], qlng[i], hits.data(), k);
+  printf("nearest-%-3zu          %10.2f us\n", k, (now() - start) * 1e6 / queries);
+
+  start = now();
+  for (size_t i = 0; i < queries; ++i)
+    found += index.within(qlat[i], qlng[i], radius, hits.data(), hits.size());
+  printf("within %-8.0f m     %10.2f us   (%.2f points per query)\n", radius, (now() - start) * 1e6 / queries,
+    (double)found / queries);
+
+  // the linear scan the index replaces, on a sample of the queries
+  size_t sample = queries < 200 ? queries : 200;
+  unsigned mismatches = 0;
+  double worstError = 0;
+  start = now();
+  for (size_t i = 0; i < sample; ++i)
+  {
+    double best = INFINITY;
+    for (size_t p = 0; p < count; ++p)
+    {
+      double d = GP02::distanceBetween(qlat[i], qlng[i], lats[p], lngs[p]);
+      if (d < best)
+        best = d;
+    }
+    index.nearest(qlat[i], qlng[i], hits.data(), 1);
+    double error = fabs(hits[0].meters - best);
+    // another point at practically the same distance is as good an answer
+    if (error > 0.05 + best * 1e-6)
+      ++mismatches;
+    if (error > worstError)
+      worstError = error;
+  }
+  printf("linear distanceBetween %8.2f us\n", (now() - start) * 1e6 / sample);
+  printf("%zu nearest answers checked against the linear scan: %u wrong, worst distance difference %.3f m (checksum %llu)\n",
+    sample, mismatches, worstError, (unsigned long long)check);
+  return mismatches ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+  enum { OPT_HEADER = 256, OPT_NAME, OPT_BOX };
+  static const struct option options[] = {
+    { "output", required_argument, NULL, 'o' },
+    { "header", required_argument, NULL, OPT_HEADER },
+    { "name", required_argument, NULL, OPT_NAME },
+    { "box", required_argument, NULL, OPT_BOX },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 } };
+
+  if (argc < 2)
+  {
+    usage();
+    return 2;
+  }
+  const char *command = argv[1];
+  const char *output = "poi.bin", *header = NULL, *name = "poi";
+  size_t k = 0, count = 1000000, queries = 100000;
+  double radius = -1;
+  Box box = { -90, -180, 90, 180 };
+
+  int opt;
+  optind = 2;
+  while ((opt = getopt_long(argc, argv, "o:k:r:n:q:h", options, NULL)) != -1)
+  {
+    switch (opt)
+    {
+    case 'o': output = optarg; break;
+    case 'k': k = strtoul(optarg, NULL, 10); break;
+    case 'r': radius = atof(optarg); break;
+    case 'n': count = strtoul(optarg, NULL, 10); break;
+    case 'q': queries = strtoul(optarg, NULL, 10); break;
+    case OPT_HEADER: header = optarg; break;
+    case OPT_NAME: name = optarg; break;
+    case OPT_BOX:
+      if (sscanf(optarg, "%lf,%lf,%lf,%lf", &box.lat0, &box.lng0, &box.lat1, &box.lng1) != 4)
+      {
+        usage();
+        return 2;
+      }
+      break;
+    default: usage(); return opt == 'h' ? 0 : 2;
+    }
+  }
+
+  if (strcmp(command, "build") == 0 && optind + 1 == argc)
+    return build(argv[optind], output, header, name);
+  if (strcmp(command, "query") == 0 && optind + 3 == argc)
+    return query(argv[optind], atof(argv[optind + 1]), atof(argv[optind + 2]), k ? k : 1, radius);
+  if (strcmp(command, "bench") == 0 && optind == argc && count > 0 && queries > 0)
+    return bench(count, queries, k ? k : 8, radius >= 0 ? radius : 1000, box);
+  usage();
+  return 2;
+}
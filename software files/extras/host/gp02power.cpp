@@ -0,0 +1,317 @@
+/*
+gp02power - runs GP02Power against a simulated GP-02 to tune a duty-cycle policy.
+
+The simulated receiver obeys the two commands GP02Power sends: $PCAS12,N stops its output
+for N seconds, $PCAS10,0 wakes it early. After every wake-up it reports no fix for a time to
+first fix that depends on how old its ephemeris is (hot, warm or cold start, with +-20%
+jitter) and then streams GP02Synth epochs. With --outage P a wake-up finds the sky blocked
+and never fixes, which exercises the acquisition timeout.
+
+Everything runs in real time, because GP02Power and the GP02 fields use millis(); the default
+policy and receiver timings are therefore scaled down from minutes to seconds. Each state
+change is printed as it happens, followed by the time-to-fix statistics and duty cycle.
+
+Build (host):
+   g++ -std=c++17 -O2 -I. -I../../src gp02power.cpp GP02Synth.cpp ../../src/GP02Power.cpp ../../src/GP02.cpp -o gp02power
+
+Examples:
+   gp02power -d 120
+   gp02power -d 300 --outage 0.2 --ephemeris 40 --max-sleep 60
+*/
+
+#include "GP02Power.h"
+#include "GP02Synth.h"
+
+#include <getopt.h>
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <random>
+#include <string>
+
+static volatile sig_atomic_t stop = 0;
+
+static void onSignal(int)
+{
+  stop = 1;
+}
+
+struct SimConfig
+{
+  double hot, warm, cold;        // seconds to first fix
+  double ephemeris;              // seconds a fix keeps the receiver hot
+  double outage;                 // probability that a wake-up never fixes
+  uint16_t rateHz;
+  uint32_t seed;
+};
+
+class SimReceiver
+{
+public:
+  SimReceiver(const SimConfig &config, const GP02SynthConfig &synthConfig)
+    : cfg(config), synth(synthConfig), rng(config.seed), asleepUntil(0), fixAt(0), lastFix(-1e9), nextEpoch(0),
+      blocked(false), commands(0), badCommands(0), awakeSeconds(0), lastStep(0)
+  {
+    wake(0, 2);
+  }
+
+  // a sentence written by the host to the receiver
+  void receive(const char *sentence, double now)
+  {
+    ++commands;
+    const char *star = strchr(sentence, '*');
+    std::string body(sentence + 1, star ? star - sentence - 1 : 0);
+    if (sentence[0] != '$' || star == NULL || strtoul(star + 1, NULL, 16) != GP02Synth::checksum(body.c_str()))
+    {
+      ++badCommands;
+      return;
+    }
+    if (body.compare(0, 7, "PCAS12,") == 0)
+      asleepUntil = now + atof(body.c_str() + 7);
+    else if (body.compare(0, 7, "PCAS10,") == 0)
+      wake(now, atoi(body.c_str() + 7));
+    else
+      ++badCommands;
+  }
+
+  // appends whatever the receiver has sent up to now
+  void step(double now, std::string &out)
+  {
+    bool asleep = asleepUntil > 0;
+    if (asleep && now >= asleepUntil)
+    {
+      wake(now, 0);
+      asleep = false;
+    }
+    if (!asleep)
+      awakeSeconds += now - lastStep;
+    lastStep = now;
+    if (asleep || now < nextEpoch)
+      return;
+    nextEpoch = now + 1.0 / cfg.rateHz;
+
+    if (blocked || now < fixAt)
+    {
+      // what the receiver prints while it searches: time only, no position
+      unsigned s = (unsigned)now;
+      char gga[64], rmc[64];
+      snprintf(gga, sizeof(gga), "GNGGA,%02u%02u%02u.00,,,,,0,00,99.99,,,,,,", 12 + s / 3600 % 12, s / 60 % 60, s % 60);
+      snprintf(rmc, sizeof(rmc), "GNRMC,%02u%02u%02u.00,V,,,,,,,181026,,,N", 12 + s / 3600 % 12, s / 60 % 60, s % 60);
+      out += GP02Synth::sentence(gga);
+      out += GP02Synth::sentence(rmc);
+      return;
+    }
+    synth.next(out);
+    lastFix = now;
+  }
+
+  double awake() const           { return awakeSeconds; }
+  unsigned commandCount() const  { return commands; }
+  unsigned badCommandCount() const { return badCommands; }
+  const char *lastStart() const  { return startKind; }
+
+private:
+  SimConfig cfg;
+  GP02Synth synth;
+  std::mt19937 rng;
+  double asleepUntil, fixAt, lastFix, nextEpoch;
+  bool blocked;
+  unsigned commands, badCommands;
+  double awakeSeconds, lastStep;
+  const char *startKind;
+
+  // restart 0 is a hot start if the ephemeris is still fresh; 1 forces warm, 2 and 3 cold
+  void wake(double now, int restart)
+  {
+    double age = now - lastFix, ttff = cfg.cold;
+    startKind = "cold";
+    if (restart == 0 && age < cfg.ephemeris)
+    {
+      ttff = cfg.hot;
+      startKind = "hot";
+    }
+    else if (restart <= 1 && age < 4 * cfg.ephemeris)
+    {
+      ttff = cfg.warm;
+      startKind = "warm";
+    }
+    std::uniform_real_distribution<double> jitter(0.8, 1.2), u(0, 1);
+    fixAt = now + ttff * jitter(rng);
+    blocked = u(rng) < cfg.outage;
+    asleepUntil = 0;
+    nextEpoch = now;
+  }
+};
+
+struct Run
+{
+  SimReceiver *receiver;
+  double now;
+};
+
+static void toReceiver(void *context, const char *sentence)
+{
+  Run &run = *static_cast<Run *>(context);
+  printf("%8.2f  -> %.*s\n", run.now, (int)strcspn(sentence, "\r\n"), sentence);
+  run.receiver->receive(sentence, run.now);
+}
+
+static double now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void usage()
+{
+  fprintf(stderr,
+    "usage: gp02power [options]\n"
+    "  -d, --duration S       seconds to run (default 120)\n"
+    "  policy (GP02PowerPolicy, scaled down by default):\n"
+    "      --hdop H           maximum HDOP (default 2.5)\n"
+    "      --sats N           minimum satellites used (default 5)\n"
+    "      --hold S           good fixes kept per wake-up (default 3)\n"
+    "      --acquire S        acquisition timeout (default 20)\n"
+    "      --retry S          standby after a timeout (default 10)\n"
+    "      --sleep S          first standby (default 4)\n"
+    "      --min-sleep S      (default 2)\n"
+    "      --max-sleep S      (default 30)\n"
+    "      --hot-fix MS       hot start threshold (default 2500)\n"
+    "  simulated receiver:\n"
+    "      --ttff H,W,C       hot, warm and cold time to first fix in seconds (default 1,6,15)\n"
+    "      --ephemeris S      seconds a fix keeps the receiver hot (default 20)\n"
+    "      --outage P         probability that a wake-up never fixes (default 0)\n"
+    "      --wake-every S     call wake() this often, like a motion interrupt (default never)\n"
+    "  -r, --rate HZ          epochs per second (default 5)\n"
+    "  -s, --seed N\n");
+}
+
+int main(int argc, char **argv)
+{
+  enum { OPT_HDOP = 256, OPT_SATS, OPT_HOLD, OPT_ACQUIRE, OPT_RETRY, OPT_SLEEP, OPT_MIN_SLEEP, OPT_MAX_SLEEP,
+         OPT_HOT_FIX, OPT_TTFF, OPT_EPHEMERIS, OPT_OUTAGE, OPT_WAKE };
+  static const struct option options[] = {
+    { "duration", required_argument, NULL, 'd' },
+    { "rate", required_argument, NULL, 'r' },
+    { "seed", required_argument, NULL, 's' },
+    { "hdop", required_argument, NULL, OPT_HDOP },
+    { "sats", required_argument, NULL, OPT_SATS },
+    { "hold", required_argument, NULL, OPT_HOLD },
+    { "acquire", required_argument, NULL, OPT_ACQUIRE },
+    { "retry", required_argument, NULL, OPT_RETRY },
+    { "sleep", required_argument, NULL, OPT_SLEEP },
+    { "min-sleep", required_argument, NULL, OPT_MIN_SLEEP },
+    { "max-sleep", required_argument, NULL, OPT_MAX_SLEEP },
+    { "hot-fix", required_argument, NULL, OPT_HOT_FIX },
+    { "ttff", required_argument, NULL, OPT_TTFF },
+    { "ephemeris", required_argument, NULL, OPT_EPHEMERIS },
+    { "outage", required_argument, NULL, OPT_OUTAGE },
+    { "wake-every", required_argument, NULL, OPT_WAKE },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 } };
+
+  GP02PowerPolicy policy;
+  policy.holdSeconds = 3;
+  policy.acquireSeconds = 20;
+  policy.retrySeconds = 10;
+  policy.sleepSeconds = 4;
+  policy.minSleepSeconds = 2;
+  policy.maxSleepSeconds = 30;
+  policy.hotFixMs = 2500;
+  SimConfig sim = { 1, 6, 15, 20, 0, 5, 1 };
+  double seconds = 120, wakeEvery = 0;
+
+  int opt;
+  while ((opt = getopt_long(argc, argv, "d:r:s:h", options, NULL)) != -1)
+  {
+    switch (opt)
+    {
+    case 'd': seconds = atof(optarg); break;
+    case 'r': sim.rateHz = (uint16_t)atoi(optarg); break;
+    case 's': sim.seed = (uint32_t)strtoul(optarg, NULL, 10); break;
+    case OPT_HDOP: policy.maxHdop = (uint16_t)lround(atof(optarg) * 100); break;
+    case OPT_SATS: policy.minSatellites = (uint8_t)atoi(optarg); break;
+    case OPT_HOLD: policy.holdSeconds = (uint16_t)atoi(optarg); break;
+    case OPT_ACQUIRE: policy.acquireSeconds = (uint16_t)atoi(optarg); break;
+    case OPT_RETRY: policy.retrySeconds = (uint16_t)atoi(optarg); break;
+    case OPT_SLEEP: policy.sleepSeconds = (uint16_t)atoi(optarg); break;
+    case OPT_MIN_SLEEP: policy.minSleepSeconds = (uint16_t)atoi(optarg); break;
+    case OPT_MAX_SLEEP: policy.maxSleepSeconds = (uint16_t)atoi(optarg); break;
+    case OPT_HOT_FIX: policy.hotFixMs = (uint16_t)atoi(optarg); break;
+    case OPT_TTFF:
+      if (sscanf(optarg, "%lf,%lf,%lf", &sim.hot, &sim.warm, &sim.cold) != 3)
+      {
+        usage();
+        return 2;
+      }
+      break;
+    case OPT_EPHEMERIS: sim.ephemeris = atof(optarg); break;
+    case OPT_OUTAGE: sim.outage = atof(optarg); break;
+    case OPT_WAKE: wakeEvery = atof(optarg); break;
+    default: usage(); return opt == 'h' ? 0 : 2;
+    }
+  }
+  if (sim.rateHz == 0 || sim.rateHz > 10 || seconds <= 0)
+  {
+    usage();
+    return 2;
+  }
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  GP02SynthConfig synthConfig;
+  synthConfig.rateHz = sim.rateHz;
+  synthConfig.seed = sim.seed;
+  SimReceiver receiver(sim, synthConfig);
+  Run run = { &receiver, 0 };
+  GP02 gps;
+  GP02Power power(toReceiver, &run, policy);
+
+  static const char *stateNames[] = { "acquiring", "tracking", "standby" };
+  GP02Power::State last = power.state();
+  double start = now(), nextWake = wakeEvery;
+  std::string bytes;
+  printf("    time  event\n");
+  while (!stop && (run.now = now() - start) < seconds)
+  {
+    bytes.clear();
+    receiver.step(run.now, bytes);
+    gps.encode(bytes.data(), bytes.size());
+
+    if (wakeEvery > 0 && run.now >= nextWake)
+    {
+      nextWake += wakeEvery;
+      if (power.state() == GP02Power::Standby)
+        printf("%8.2f  wake()\n", run.now);
+      power.wake();
+    }
+    GP02Power::State s = power.update(gps);
+    if (s != last)
+    {
+      printf("%8.2f  %s", run.now, stateNames[s]);
+      if (s == GP02Power::Tracking)
+        printf(" after %.2f s (%s start, HDOP %.2f, %u satellites)", power.stats().lastTtff / 1000.0, receiver.lastStart(),
+          gps.hdop.hdop(), (unsigned)gps.satellites.value());
+      else if (s == GP02Power::Standby)
+        printf(" for %.1f s", power.standbyRemaining() / 1000.0);
+      printf("\n");
+      last = s;
+    }
+
+    struct timespec ts = { 0, 5000000 };
+    nanosleep(&ts, NULL);
+  }
+
+  const GP02PowerStats &st = power.stats();
+  printf("\n%u acquisitions, %u timeouts, time to fix min/mean/max %.2f/%.2f/%.2f s, next sleep %u s\n",
+    st.acquisitions, st.failures, st.minTtff / 1000.0, st.meanTtff() / 1000.0, st.maxTtff / 1000.0, power.sleepSeconds());
+  printf("receiver awake %.1f of %.1f s (scheduler duty cycle %u%%), %u commands, %u rejected\n",
+    receiver.awake(), run.now, st.dutyPercent(), receiver.commandCount(), receiver.badCommandCount());
+  return receiver.badCommandCount() ? 1 : 0;
+}
@@ -0,0 +1,233 @@
+/*
+gp02shm - publishes GP-02 fixes into a shared-memory ring and reads them back.
+
+   gp02shm publish [-n NAME] [-c CAPACITY] DEVICE[@BAUD]...   ("-" reads standard input)
+   gp02shm latest  [-n NAME]
+   gp02shm follow  [-n NAME] [--all]
+   gp02shm bench   [-n NAME] [-d SECONDS]
+
+The publisher owns the serial ports and appends every epoch of every port to the ring; the
+port index is stored as the record's source. Readers need nothing but the ring's name.
+
+Build (host):
+   g++ -std=c++17 -O2 -I. -I../../src gp02shm.cpp GP02Shm.cpp GP02Serial.cpp ../../src/GP02.cpp ../../src/GP02Format.cpp -o gp02shm -lrt
+
+Example:
+   gp02synth --pty -r 10 --baud 115200 &     gp02shm publish /dev/pts/N@115200 &
+   gp02shm follow                            gp02shm bench
+*/
+
+#include "GP02Serial.h"
+#include "GP02Shm.h"
+#include "GP02Format.h"
+
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static volatile sig_atomic_t stop = 0;
+
+static void onSignal(int)
+{
+  stop = 1;
+}
+
+static void usage()
+{
+  fprintf(stderr,
+    "usage: gp02shm publish [-n NAME] [-c CAPACITY] DEVICE[@BAUD]...\n"
+    "       gp02shm latest|follow|bench [-n NAME] [--all] [-d SECONDS]\n"
+    "  -n, --name NAME      shared-memory name (default /gp02)\n"
+    "  -c, --capacity N     records kept in the ring (default 256)\n"
+    "  -d, --duration S     bench: seconds to run (default 3)\n"
+    "      --all            follow: start with the oldest retained record\n");
+}
+
+static double now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void onSentence(void *context, GP02SerialPort &port, const char *)
+{
+  GP02Epoch &epoch = port.gps().epoch;
+  if (epoch.isUpdated())
+    static_cast<GP02ShmWriter *>(context)->publish(epoch.value(), port.rxTime(), (uint32_t)port.index());
+}
+
+static int publish(const char *name, uint32_t capacity, int count, char **devices)
+{
+  GP02ShmWriter ring(name, capacity);
+  if (!ring.isOpen())
+  {
+    perror(name);
+    return 1;
+  }
+
+  GP02SerialHub hub;
+  hub.onSentence(onSentence, &ring);
+  GP02 *gps = new GP02[count];
+  for (int i = 0; i < count; ++i)
+  {
+    char path[256];
+    unsigned long baud = 9600;
+    snprintf(path, sizeof(path), "%s", devices[i]);
+    char *at = strchr(path, '@');
+    if (at != NULL)
+    {
+      *at = '\0';
+      baud = strtoul(at + 1, NULL, 10);
+    }
+    gps[i].enableEpochs();
+    int port = strcmp(path, "-") == 0 ? hub.attach(STDIN_FILENO, gps[i]) : hub.open(path, baud, gps[i]);
+    if (port < 0)
+    {
+      perror(path);
+      delete[] gps;
+      return 1;
+    }
+  }
+
+  while (!stop)
+  {
+    if (hub.poll(500) < 0)
+      break;
+    bool open = false;
+    for (size_t i = 0; i < hub.portCount(); ++i)
+      open = open || hub.port((int)i)->isOpen();
+    if (!open)
+      break;
+  }
+  fprintf(stderr, "gp02shm: %llu fixes published to %s\n", (unsigned long long)ring.published(), name);
+  delete[] gps;
+  return 0;
+}
+
+static void print(const GP02ShmRecord &r)
+{
+  char line[GP02_FORMAT_MAX];
+  GP02Format::csv(line, sizeof(line), r.fix);
+  printf("%llu,%u,%lld,%s\n", (unsigned long long)r.sequence, (unsigned)r.source, (long long)r.rxTime, line);
+}
+
+static int follow(const GP02ShmReader &ring, bool all)
+{
+  uint64_t cursor = all ? 0 : ring.head(), lost = 0;
+  GP02ShmRecord r;
+  printf("sequence,source,rx_ns," _GPS_CSV_HEADER "\n");
+  while (!stop && ring.isLive())
+  {
+    if (!ring.next(cursor, r, &lost))
+    {
+      fflush(stdout);
+      usleep(10000);
+      continue;
+    }
+    print(r);
+  }
+  if (lost)
+    fprintf(stderr, "gp02shm: %llu records overwritten before they were read\n", (unsigned long long)lost);
+  return 0;
+}
+
+static int bench(const GP02ShmReader &ring, double seconds)
+{
+  GP02ShmRecord r;
+  uint64_t reads = 0, misses = 0, sum = 0;
+  double start = now(), end = start + seconds;
+  while (!stop)
+  {
+    for (int i = 0; i < 1024; ++i)
+    {
+      if (ring.latest(r))
+        sum += r.sequence;
+      else
+        ++misses;
+    }
+    reads += 1024;
+    if (now() >= end)
+      break;
+  }
+  double elapsed = now() - start;
+  printf("%llu latest() reads in %.2f s: %.1f M/s, %.1f ns per read, %llu empty (checksum %llu)\n",
+    (unsigned long long)reads, elapsed, reads / elapsed / 1e6, elapsed * 1e9 / reads,
+    (unsigned long long)misses, (unsigned long long)sum);
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  enum { OPT_ALL = 256 };
+  static const struct option options[] = {
+    { "name", required_argument, NULL, 'n' },
+    { "capacity", required_argument, NULL, 'c' },
+    { "duration", required_argument, NULL, 'd' },
+    { "all", no_argument, NULL, OPT_ALL },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 } };
+
+  if (argc < 2)
+  {
+    usage();
+    return 2;
+  }
+  const char *command = argv[1];
+  const char *name = "/gp02";
+  uint32_t capacity = 256;
+  double seconds = 3;
+  bool all = false;
+
+  int opt;
+  optind = 2;
+  while ((opt = getopt_long(argc, argv, "n:c:d:h", options, NULL)) != -1)
+  {
+    switch (opt)
+    {
+    case 'n': name = optarg; break;
+    case 'c': capacity = (uint32_t)strtoul(optarg, NULL, 10); break;
+    case 'd': seconds = atof(optarg); break;
+    case OPT_ALL: all = true; break;
+    default: usage(); return opt == 'h' ? 0 : 2;
+    }
+  }
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  if (strcmp(command, "publish") == 0)
+  {
+    if (optind >= argc)
+    {
+      usage();
+      return 2;
+    }
+    return publish(name, capacity, argc - optind, argv + optind);
+  }
+
+  GP02ShmReader ring(name);
+  if (!ring.isOpen())
+  {
+    fprintf(stderr, "gp02shm: %s does not exist or has a different layout\n", name);
+    return 1;
+  }
+  if (strcmp(command, "latest") == 0)
+  {
+    GP02ShmRecord r;
+    if (!ring.latest(r))
+      return 1;
+    print(r);
+    return 0;
+  }
+  if (strcmp(command, "follow") == 0)
+    return follow(ring, all);
+  if (strcmp(command, "bench") == 0)
+    return bench(ring, seconds);
+  usage();
+  return 2;
+}
@@ -0,0 +1,235 @@
+/*
+gp02synth - command line front end for GP02Synth.
+
+Writes a synthetic GP-02 NMEA stream to a file, to stdout, or to a pseudo-terminal paced at
+the configured baud rate so that serial backends see realistic timing.
+
+Build (host):
+   g++ -std=c++17 -O2 gp02synth.cpp GP02Synth.cpp -o gp02synth
+
+Examples:
+   gp02synth -r 10 -n 36000 -c gps,bds,glonass -o load.nmea
+   gp02synth -r 5 --bad-checksum 0.01 --drop 0.0005 --oversize 0.01 --truth truth.csv -o noisy.nmea
+   gp02synth -r 10 --pty --baud 115200            (prints the slave device to stderr)
+*/
+
+#include "GP02Synth.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static void usage()
+{
+  fprintf(stderr,
+    "usage: gp02synth [options]\n"
+    "  -r, --rate HZ           epochs per second (default 1)\n"
+    "  -n, --epochs N          epochs to generate (default 600, 0 = unlimited)\n"
+    "  -c, --constellations L  comma separated gps,bds,glonass (default gps,bds)\n"
+    "  -s, --seed N            random seed\n"
+    "      --date DDMMYY       start date (default 181026)\n"
+    "      --time HHMMSS       start time (default 120000)\n"
+    "      --route FILE        waypoints, one \"lat,lng,knots,altitude[,dwell]\" per line\n"
+    "      --no-gsa, --no-gsv, --no-vtg\n"
+    "      --bad-checksum P    probability of a corrupted checksum per sentence\n"
+    "      --oversize P        probability of an oversize field per sentence\n"
+    "      --drop P            probability of a dropped byte per byte\n"
+    "      --noise P           probability of line noise before a sentence\n"
+    "      --position-error M  wander the reported position by M meters per unit of HDOP\n"
+    "  -o, --output FILE       output file (default stdout)\n"
+    "      --pty               serve the stream on a pseudo-terminal in real time\n"
+    "      --baud N            pacing for --pty (default 9600)\n"
+    "      --truth FILE        write per-epoch ground truth as CSV\n");
+}
+
+static double now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void sleepUntil(double t)
+{
+  double d = t - now();
+  if (d <= 0)
+    return;
+  struct timespec ts;
+  ts.tv_sec = (time_t)d;
+  ts.tv_nsec = (long)((d - ts.tv_sec) * 1e9);
+  nanosleep(&ts, NULL);
+}
+
+static bool writeAll(int fd, const char *p, size_t n)
+{
+  while (n > 0)
+  {
+    ssize_t w = write(fd, p, n);
+    if (w < 0 && errno == EINTR)
+      continue;
+    if (w <= 0)
+      return false;
+    p += w;
+    n -= (size_t)w;
+  }
+  return true;
+}
+
+static int openPty()
+{
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0)
+  {
+    perror("posix_openpt");
+    exit(1);
+  }
+  fprintf(stderr, "%s\n", ptsname(master));
+  return master;
+}
+
+int main(int argc, char **argv)
+{
+  enum { OPT_DATE = 256, OPT_TIME, OPT_ROUTE, OPT_NOGSA, OPT_NOGSV, OPT_NOVTG, OPT_BADCS,
+         OPT_OVERSIZE, OPT_DROP, OPT_NOISE, OPT_POSERR, OPT_PTY, OPT_BAUD, OPT_TRUTH };
+  static const struct option options[] = {
+    { "rate", required_argument, NULL, 'r' },
+    { "epochs", required_argument, NULL, 'n' },
+    { "constellations", required_argument, NULL, 'c' },
+    { "seed", required_argument, NULL, 's' },
+    { "output", required_argument, NULL, 'o' },
+    { "date", required_argument, NULL, OPT_DATE },
+    { "time", required_argument, NULL, OPT_TIME },
+    { "route", required_argument, NULL, OPT_ROUTE },
+    { "no-gsa", no_argument, NULL, OPT_NOGSA },
+    { "no-gsv", no_argument, NULL, OPT_NOGSV },
+    { "no-vtg", no_argument, NULL, OPT_NOVTG },
+    { "bad-checksum", required_argument, NULL, OPT_BADCS },
+    { "oversize", required_argument, NULL, OPT_OVERSIZE },
+    { "drop", required_argument, NULL, OPT_DROP },
+    { "noise", required_argument, NULL, OPT_NOISE },
+    { "position-error", required_argument, NULL, OPT_POSERR },
+    { "pty", no_argument, NULL, OPT_PTY },
+    { "baud", required_argument, NULL, OPT_BAUD },
+    { "truth", required_argument, NULL, OPT_TRUTH },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 } };
+
+  GP02SynthConfig cfg;
+  unsigned long epochs = 600;
+  const char *output = NULL, *route = NULL, *truthPath = NULL;
+  bool pty = false;
+  unsigned long baud = 9600;
+
+  int opt;
+  while ((opt = getopt_long(argc, argv, "r:n:c:s:o:h", options, NULL)) != -1)
+  {
+    switch (opt)
+    {
+    case 'r': cfg.rateHz = (uint16_t)atoi(optarg); break;
+    case 'n': epochs = strtoul(optarg, NULL, 10); break;
+    case 's': cfg.seed = (uint32_t)strtoul(optarg, NULL, 10); break;
+    case 'o': output = optarg; break;
+    case 'c':
+      cfg.constellations = 0;
+      if (strstr(optarg, "gps")) cfg.constellations |= GP02SynthConfig::GPS;
+      if (strstr(optarg, "bds")) cfg.constellations |= GP02SynthConfig::BDS;
+      if (strstr(optarg, "glonass")) cfg.constellations |= GP02SynthConfig::GLONASS;
+      break;
+    case OPT_DATE: cfg.startDate = (uint32_t)strtoul(optarg, NULL, 10); break;
+    case OPT_TIME: cfg.startTime = (uint32_t)strtoul(optarg, NULL, 10); break;
+    case OPT_ROUTE: route = optarg; break;
+    case OPT_NOGSA: cfg.gsa = false; break;
+    case OPT_NOGSV: cfg.gsv = false; break;
+    case OPT_NOVTG: cfg.vtg = false; break;
+    case OPT_BADCS: cfg.badChecksum = atof(optarg); break;
+    case OPT_OVERSIZE: cfg.oversizeField = atof(optarg); break;
+    case OPT_DROP: cfg.dropByte = atof(optarg); break;
+    case OPT_NOISE: cfg.noise = atof(optarg); break;
+    case OPT_POSERR: cfg.positionError = atof(optarg); break;
+    case OPT_PTY: pty = true; break;
+    case OPT_BAUD: baud = strtoul(optarg, NULL, 10); break;
+    case OPT_TRUTH: truthPath = optarg; break;
+    default: usage(); return opt == 'h' ? 0 : 2;
+    }
+  }
+  if (cfg.rateHz == 0 || cfg.rateHz > 100 || cfg.constellations == 0 || baud == 0)
+  {
+    usage();
+    return 2;
+  }
+
+  GP02Synth synth(cfg);
+  if (route && !synth.loadRoute(route))
+  {
+    fprintf(stderr, "gp02synth: cannot read route %s\n", route);
+    return 1;
+  }
+
+  int fd = STDOUT_FILENO;
+  if (pty)
+    fd = openPty();
+  else if (output && (fd = open(output, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+  {
+    perror(output);
+    return 1;
+  }
+
+  FILE *truth = NULL;
+  if (truthPath)
+  {
+    truth = fopen(truthPath, "w");
+    if (truth == NULL)
+    {
+      perror(truthPath);
+      return 1;
+    }
+    fprintf(truth, "epoch,date,time,lat,lng,knots,course,altitude,hdop,satellites,in_view,sentences,damaged,rmc_intact,gga_intact\n");
+  }
+
+  // at 8N1 every byte occupies ten bit times on the wire
+  double byteTime = 10.0 / baud;
+  double start = now();
+  unsigned long late = 0;
+  std::string out;
+  for (unsigned long e = 0; epochs == 0 || e < epochs; ++e)
+  {
+    out.clear();
+    GP02SynthTruth t = synth.next(out);
+    if (truth)
+      fprintf(truth, "%lu,%06u,%08u,%.9f,%.9f,%.3f,%.3f,%.2f,%.1f,%u,%u,%u,%u,%d,%d\n",
+        e, (unsigned)t.date, (unsigned)t.time, t.lat, t.lng, t.knots, t.course, t.altitude, t.hdop,
+        t.satellites, t.inView, t.sentences, t.damaged, t.rmcIntact, t.ggaIntact);
+
+    if (!pty)
+    {
+      if (!writeAll(fd, out.data(), out.size()))
+        break;
+      continue;
+    }
+
+    // the burst starts at the top of its epoch and leaves the UART at line rate
+    double epochStart = start + e * synth.epochInterval();
+    if (out.size() * byteTime > synth.epochInterval())
+      ++late;
+    sleepUntil(epochStart);
+    const size_t chunk = 16;
+    for (size_t off = 0; off < out.size(); off += chunk)
+    {
+      size_t n = out.size() - off < chunk ? out.size() - off : chunk;
+      sleepUntil(epochStart + off * byteTime);
+      if (!writeAll(fd, out.data() + off, n))
+        return 1;
+    }
+  }
+
+  if (late)
+    fprintf(stderr, "gp02synth: %lu epochs did not fit in one epoch interval at %lu baud\n", late, baud);
+  if (truth)
+    fclose(truth);
+  return 0;
+}
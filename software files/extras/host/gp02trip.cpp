@@ -0,0 +1,213 @@
+/*
+gp02trip - checks GP02Trip against ground truth and against summing distanceBetween().
+
+Without file arguments, a GP02Synth receiver drives a city loop with a traffic-light stop
+and two longer stops per lap, reporting positions that wander by --position-error meters
+per unit of HDOP. Every fix is given to GP02Trip and to the two ways application code used
+to do it: summing GP02::distanceBetween() over successive lat()/lng() doubles, and the same
+with 32-bit floats, which is what double means on AVR. The report compares distance, moving
+time, stops and maximum speed with the ground truth, and times each method per fix.
+
+With a file argument, a capture is replayed and the same figures are printed without truth.
+
+Build (host):
+   g++ -std=c++17 -O2 -I. -I../../src gp02trip.cpp GP02Synth.cpp ../../src/GP02Trip.cpp ../../src/GP02.cpp -o gp02trip
+
+Examples:
+   gp02trip -n 7200
+   gp02trip -n 36000 -r 10 --position-error 3
+   gp02trip capture.nmea
+*/
+
+#include "GP02Trip.h"
+#include "GP02Synth.h"
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <string>
+
+typedef std::chrono::steady_clock Clock;
+
+static uint64_t nanosSince(Clock::time_point t)
+{
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t).count();
+}
+
+// the application code GP02Trip replaces
+struct Naive
+{
+  bool started;
+  double lat, lng, meters;
+  float flat, flng, fmeters;
+  uint64_t nanos, fnanos;
+
+  Naive() : started(false), lat(0), lng(0), meters(0), flat(0), flng(0), fmeters(0), nanos(0), fnanos(0) {}
+
+  void add(double nlat, double nlng)
+  {
+    Clock::time_point t = Clock::now();
+    if (started)
+      meters += GP02::distanceBetween(lat, lng, nlat, nlng);
+    lat = nlat;
+    lng = nlng;
+    nanos += nanosSince(t);
+
+    t = Clock::now();
+    float a = (float)nlat, b = (float)nlng;
+    if (started)
+      fmeters += (float)GP02::distanceBetween(flat, flng, a, b);
+    flat = a;
+    flng = b;
+    fnanos += nanosSince(t);
+    started = true;
+  }
+};
+
+static void report(const GP02Trip &trip, const Naive &naive, uint64_t tripNanos, const GP02SynthTruth *t,
+  double truthMeters, double truthMoving, unsigned truthStops, double truthMaxKnots)
+{
+  unsigned n = trip.fixes() ? trip.fixes() : 1;
+  printf("                              distance m   error   moving s  stops  max kn   ns/fix\n");
+  if (t)
+    printf("ground truth                  %11.1f          %9.0f %6u %7.2f\n", truthMeters, truthMoving, truthStops, truthMaxKnots);
+  double ref = t ? truthMeters : trip.meters();
+  printf("distanceBetween, double       %11.1f %+6.2f%%                           %8.0f\n",
+    naive.meters, ref ? 100 * (naive.meters - ref) / ref : 0, (double)naive.nanos / n);
+  printf("distanceBetween, float        %11.1f %+6.2f%%                           %8.0f\n",
+    naive.fmeters, ref ? 100 * (naive.fmeters - ref) / ref : 0, (double)naive.fnanos / n);
+  printf("GP02Trip                      %11.1f %+6.2f%% %9.0f %6u %7.2f %8.0f\n",
+    trip.meters(), ref ? 100 * (trip.meters() - ref) / ref : 0, trip.movingMs() / 1000.0, trip.stops(),
+    trip.maxSpeed() / 100.0, (double)tripNanos / n);
+  printf("\nGP02Trip: %.0f s elapsed, %.0f s stopped, average %.2f kn while moving, ascent %.1f m, descent %.1f m,\n"
+    "          altitude %.1f..%.1f m, %u fixes, %u ignored, %u gaps, %u glitches, now %s\n",
+    trip.elapsedMs() / 1000.0, trip.stoppedMs() / 1000.0, trip.averageSpeed() / 100.0, trip.ascent() / 100.0,
+    trip.descent() / 100.0, trip.minAltitude() / 100.0, trip.maxAltitude() / 100.0, trip.fixes(), trip.ignored(),
+    trip.gaps(), trip.glitches(), trip.state() == GP02Trip::Moving ? "moving" : "stopped");
+}
+
+static int replay(const char *path)
+{
+  FILE *f = fopen(path, "rb");
+  if (f == NULL)
+  {
+    perror(path);
+    return 1;
+  }
+  GP02 gps;
+  gps.enableEpochs();
+  GP02Trip trip;
+  Naive naive;
+  uint64_t tripNanos = 0;
+  int c;
+  while ((c = getc(f)) != EOF)
+  {
+    gps.encode((char)c);
+    if (gps.epoch.isUpdated())
+    {
+      const GP02Fix &fix = gps.epoch.value();
+      if (!fix.has(GP02Fix::HasLocation))
+        continue;
+      Clock::time_point t = Clock::now();
+      trip.add(fix);
+      tripNanos += nanosSince(t);
+      naive.add(gps.location.lat(), gps.location.lng());
+    }
+  }
+  fclose(f);
+  report(trip, naive, tripNanos, NULL, 0, 0, 0, 0);
+  return 0;
+}
+
+static void usage()
+{
+  fprintf(stderr,
+    "usage: gp02trip [options] [CAPTURE]\n"
+    "  -n, --epochs N          synthetic epochs (default 7200)\n"
+    "  -r, --rate HZ           synthetic epoch rate (default 1)\n"
+    "  -s, --seed N            random seed (default 1)\n"
+    "      --position-error M  meters of error per unit of HDOP (default 1.5)\n");
+}
+
+int main(int argc, char **argv)
+{
+  enum { OPT_POSERR = 256 };
+  static const struct option options[] = {
+    { "epochs", required_argument, NULL, 'n' },
+    { "rate", required_argument, NULL, 'r' },
+    { "seed", required_argument, NULL, 's' },
+    { "position-error", required_argument, NULL, OPT_POSERR },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 } };
+
+  unsigned long epochs = 7200;
+  GP02SynthConfig cfg;
+  cfg.positionError = 1.5;
+
+  int opt;
+  while ((opt = getopt_long(argc, argv, "n:r:s:h", options, NULL)) != -1)
+  {
+    switch (opt)
+    {
+    case 'n': epochs = strtoul(optarg, NULL, 10); break;
+    case 'r': cfg.rateHz = (uint16_t)atoi(optarg); break;
+    case 's': cfg.seed = (uint32_t)strtoul(optarg, NULL, 10); break;
+    case OPT_POSERR: cfg.positionError = atof(optarg); break;
+    default: usage(); return opt == 'h' ? 0 : 2;
+    }
+  }
+  if (optind < argc)
+    return replay(argv[optind]);
+  if (epochs == 0 || cfg.rateHz == 0)
+  {
+    usage();
+    return 2;
+  }
+
+  // about 5.2 km per lap: a traffic light, a delivery stop and a depot stop
+  GP02Synth synth(cfg);
+  const GP02SynthWaypoint lap[] = {
+    { 41.00820, 28.97840, 15, 40, 0 }, { 41.01620, 28.97840, 25, 55, 20 }, { 41.02020, 28.98440, 30, 60, 0 },
+    { 41.02020, 28.99640, 18, 70, 90 }, { 41.01220, 28.99840, 35, 52, 0 }, { 41.00820, 28.98640, 12, 45, 0 },
+    { 41.00820, 28.97840, 8, 40, 180 } };
+  for (size_t i = 0; i < sizeof(lap) / sizeof(lap[0]); ++i)
+    synth.addWaypoint(lap[i]);
+
+  GP02 gps;
+  gps.enableEpochs(GP02Epoch::VTG);
+  GP02Trip trip;
+  Naive naive;
+  uint64_t tripNanos = 0;
+
+  GP02SynthTruth truth, last;
+  double truthMeters = 0, truthMoving = 0, truthMaxKnots = 0;
+  unsigned truthStops = 0;
+  for (unsigned long e = 0; e < epochs; ++e)
+  {
+    std::string bytes;
+    truth = synth.next(bytes);
+    if (e > 0)
+    {
+      truthMeters += GP02::distanceBetween(last.lat, last.lng, truth.lat, truth.lng);
+      if (last.knots > 0 && truth.knots == 0)
+        ++truthStops;
+    }
+    if (truth.knots > 0)
+      truthMoving += synth.epochInterval();
+    if (truth.knots > truthMaxKnots)
+      truthMaxKnots = truth.knots;
+    last = truth;
+
+    gps.encode(bytes.data(), bytes.size());
+    Clock::time_point t = Clock::now();
+    trip.update(gps);
+    tripNanos += nanosSince(t);
+    naive.add(gps.location.lat(), gps.location.lng());
+  }
+
+  printf("%lu epochs at %u Hz, %.1f m position error per unit of HDOP\n\n", epochs, (unsigned)cfg.rateHz, cfg.positionError);
+  report(trip, naive, tripNanos, &truth, truthMeters, truthMoving, truthStops, truthMaxKnots);
+  return 0;
+}
@@ -29,6 +29,15 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #define _RMCterm "RMC"
 #define _GGAterm "GGA"
+#define _GSAterm "GSA"
+#define _GSVterm "GSV"
+#define _VTGterm "VTG"
+
+#ifdef _GPS_EPOCHS
+#define EPOCH_FIELD(field) (epoch.newFields |= (field))
+#else
+#define EPOCH_FIELD(field)
+#endif
 
 #if !defined(ARDUINO) && !defined(__AVR__)
 // Alternate implementation of millis() that relies on std
@@ -41,21 +50,41 @@ unsigned long millis()
 
     return static_cast<unsigned long>(duration.count());
 }
+
+// Alternate implementation of micros(), used by encodeFor()
+unsigned long micros()
+{
+    static auto start_time = std::chrono::high_resolution_clock::now();
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
+
+    return static_cast<unsigned long>(duration.count());
+}
 #endif
 
-GP02::GP02()
+GP02::GP02(GP02ConfigTag)
   :  parity(0)
   ,  isChecksumTerm(false)
   ,  curSentenceType(GPS_SENTENCE_OTHER)
   ,  curTermNumber(0)
   ,  curTermOffset(0)
   ,  sentenceHasFix(false)
+  ,  strictFraming(false)
+  ,  inSentence(false)
+  ,  sentenceLength(0)
   ,  customElts(0)
   ,  customCandidates(0)
+  ,  traceHandler(0)
+  ,  traceContext(0)
   ,  encodedCharCount(0)
   ,  sentencesWithFixCount(0)
   ,  failedChecksumCount(0)
   ,  passedChecksumCount(0)
+  ,  invalidCharCount(0)
+  ,  oversizeTermCount(0)
+  ,  oversizeSentenceCount(0)
+  ,  truncatedSentenceCount(0)
 {
   term[0] = '\0';
 }
@@ -77,6 +106,9 @@ bool GP02::encode(char c)
 {
   ++encodedCharCount;
 
+  if (strictFraming && !frameCheck(c))
+    return false;
+
   switch(c)
   {
   case ',': // term terminators
@@ -104,6 +136,11 @@ bool GP02::encode(char c)
     curSentenceType = GPS_SENTENCE_OTHER;
     isChecksumTerm = false;
     sentenceHasFix = false;
+#ifdef _GPS_EPOCHS
+    epoch.begin();
+#endif
+    if (traceHandler)
+      trace(TraceStart);
     return false;
 
   default: // ordinary characters
@@ -117,10 +154,119 @@ bool GP02::encode(char c)
   return false;
 }
 
+/**
+ * @brief Encodes a block of characters for processing GPS data.
+ * 
+ * This function feeds every character of the block to encode(char), which lets serial
+ * backends that read many bytes at once hand them over in a single call.
+ * 
+ * @param data The characters received from the GPS.
+ * @param length The number of characters in data.
+ * @return The number of valid sentences completed within the block.
+ */
+size_t GP02::encode(const char *data, size_t length)
+{
+  size_t sentences = 0;
+  for (size_t i = 0; i < length; ++i)
+    if (encode(data[i]))
+      ++sentences;
+  return sentences;
+}
+
 //
 // internal utilities
 //
 
+/**
+ * @brief Decides whether a character may be parsed under strict framing.
+ *
+ * Outside a sentence everything but '$' is skipped after a single comparison. Inside one,
+ * a character that breaks the NMEA framing discards the sentence, so that nothing of it is
+ * committed and the parser waits for the next '$'.
+ *
+ * @param c The character about to be parsed.
+ * @return True if encode() should parse the character.
+ */
+bool GP02::frameCheck(char c)
+{
+  if (c == '$')
+  {
+    // the previous sentence never reached its checksum, e.g. the line dropped bytes
+    if (inSentence)
+    {
+      ++truncatedSentenceCount;
+      if (traceHandler)
+        trace(TraceFail);
+    }
+    inSentence = true;
+    sentenceLength = 1;
+    return true;
+  }
+  if (!inSentence)
+    return false;
+  if (++sentenceLength > _GPS_MAX_SENTENCE_LENGTH)
+    return abortSentence(oversizeSentenceCount);
+
+  switch(c)
+  {
+  case '\r':
+  case '\n':
+    if (!isChecksumTerm || curTermOffset != 2)
+      return abortSentence(truncatedSentenceCount);
+    inSentence = false;
+    return true;
+
+  case ',':
+    if (isChecksumTerm)
+      return abortSentence(invalidCharCount);
+    if (curTermNumber + 1 >= _GPS_MAX_TERMS)
+      return abortSentence(oversizeSentenceCount);
+    return true;
+
+  case '*':
+    if (isChecksumTerm)
+      return abortSentence(invalidCharCount);
+    return true;
+
+  default:
+    if ((uint8_t)c < 0x20 || (uint8_t)c > 0x7E)
+      return abortSentence(invalidCharCount);
+    if (isChecksumTerm && (curTermOffset >= 2 || !isxdigit((uint8_t)c)))
+      return abortSentence(invalidCharCount);
+    if (curTermOffset >= sizeof(term) - 1)
+      return abortSentence(oversizeTermCount);
+    return true;
+  }
+}
+
+/**
+ * @brief Counts a framing error, reports the sentence as failed and skips the rest of it.
+ *
+ * @return Always false, for frameCheck() to return.
+ */
+bool GP02::abortSentence(uint32_t &counter)
+{
+  ++counter;
+  inSentence = false;
+  if (traceHandler)
+    trace(TraceFail);
+  return false;
+}
+
+/**
+ * @brief Calls the trace handler with the GP02Epoch::Sentence bit of the current sentence.
+ *
+ * Sentences the parser does not decode (and those whose type is not known yet) are reported
+ * as GP02Epoch::None.
+ *
+ * @param event The TraceEvent that just happened.
+ */
+void GP02::trace(uint8_t event)
+{
+  uint8_t sentence = curSentenceType == GPS_SENTENCE_OTHER ? (uint8_t)GP02Epoch::None : (uint8_t)(1 << curSentenceType);
+  traceHandler(traceContext, *this, event, sentence);
+}
+
 /**
  * @brief Converts a hexadecimal character to an integer.
  * 
@@ -203,6 +349,23 @@ void GP02::parseDegrees(const char *term, RawDegrees &deg)
   deg.negative = false;
 }
 
+/**
+ * @brief Copies a term into a fixed-size buffer, truncating it if necessary.
+ * 
+ * Used by the _GPS_LAZY_DECODE build to keep the raw text of a field until it is read.
+ * 
+ * @param dest The destination buffer.
+ * @param term The NUL-terminated term.
+ * @param size The size of dest in bytes.
+ */
+void GP02::copyTerm(char *dest, const char *term, size_t size)
+{
+  size_t i = 0;
+  for (; i + 1 < size && term[i]; ++i)
+    dest[i] = term[i];
+  dest[i] = '\0';
+}
+
 #define COMBINE(sentence_type, term_number) (((unsigned)(sentence_type) << 5) | term_number)
 
 // Processes a just-completed term
@@ -256,12 +419,21 @@ bool GP02::endOfTermHandler()
       // Commit all custom listeners of this sentence type
       for (GP02Custom *p = customCandidates; p != NULL && strcmp(p->sentenceName, customCandidates->sentenceName) == 0; p = p->next)
          p->commit();
+
+#ifdef _GPS_EPOCHS
+      if (epoch.enabled)
+        assembleEpoch();
+#endif
+      if (traceHandler)
+        trace(TraceCommit);
       return true;
     }
 
     else
     {
       ++failedChecksumCount;
+      if (traceHandler)
+        trace(TraceFail);
     }
 
     return false;
@@ -270,10 +442,18 @@ bool GP02::endOfTermHandler()
   // the first term determines the sentence type
   if (curTermNumber == 0)
   {
-    if (term[0] == 'G' && strchr("PNABL", term[1]) != NULL && !strcmp(term + 2, _RMCterm))
+    // GP-02 reports BeiDou satellites with a BD talker rather than GB
+    bool knownTalker = (term[0] == 'G' && term[1] && strchr("PNABL", term[1]) != NULL) || (term[0] == 'B' && term[1] == 'D');
+    if (knownTalker && !strcmp(term + 2, _RMCterm))
       curSentenceType = GPS_SENTENCE_RMC;
-    else if (term[0] == 'G' && strchr("PNABL", term[1]) != NULL && !strcmp(term + 2, _GGAterm))
+    else if (knownTalker && !strcmp(term + 2, _GGAterm))
       curSentenceType = GPS_SENTENCE_GGA;
+    else if (knownTalker && !strcmp(term + 2, _GSAterm))
+      curSentenceType = GPS_SENTENCE_GSA;
+    else if (knownTalker && !strcmp(term + 2, _GSVterm))
+      curSentenceType = GPS_SENTENCE_GSV;
+    else if (knownTalker && !strcmp(term + 2, _VTGterm))
+      curSentenceType = GPS_SENTENCE_VTG;
     else
       curSentenceType = GPS_SENTENCE_OTHER;
 
@@ -282,6 +462,8 @@ bool GP02::endOfTermHandler()
     if (customCandidates != NULL && strcmp(customCandidates->sentenceName, term) > 0)
        customCandidates = NULL;
 
+    if (traceHandler)
+      trace(TraceType);
     return false;
   }
 
@@ -291,6 +473,7 @@ bool GP02::endOfTermHandler()
     case COMBINE(GPS_SENTENCE_RMC, 1): // Time in both sentences
     case COMBINE(GPS_SENTENCE_GGA, 1):
       time.setTime(term);
+      EPOCH_FIELD(GP02Fix::HasTime);
       break;
     case COMBINE(GPS_SENTENCE_RMC, 2): // RMC validity
       sentenceHasFix = term[0] == 'A';
@@ -306,6 +489,7 @@ bool GP02::endOfTermHandler()
     case COMBINE(GPS_SENTENCE_RMC, 5): // Longitude
     case COMBINE(GPS_SENTENCE_GGA, 4):
       location.setLongitude(term);
+      EPOCH_FIELD(GP02Fix::HasLocation);
       break;
     case COMBINE(GPS_SENTENCE_RMC, 6): // E/W
     case COMBINE(GPS_SENTENCE_GGA, 5):
@@ -313,12 +497,15 @@ bool GP02::endOfTermHandler()
       break;
     case COMBINE(GPS_SENTENCE_RMC, 7): // Speed (RMC)
       speed.set(term);
+      EPOCH_FIELD(GP02Fix::HasSpeed);
       break;
     case COMBINE(GPS_SENTENCE_RMC, 8): // Course (RMC)
       course.set(term);
+      EPOCH_FIELD(GP02Fix::HasCourse);
       break;
     case COMBINE(GPS_SENTENCE_RMC, 9): // Date (RMC)
       date.setDate(term);
+      EPOCH_FIELD(GP02Fix::HasDate);
       break;
     case COMBINE(GPS_SENTENCE_GGA, 6): // Fix data (GGA)
       sentenceHasFix = term[0] > '0';
@@ -326,16 +513,51 @@ bool GP02::endOfTermHandler()
       break;
     case COMBINE(GPS_SENTENCE_GGA, 7): // Satellites used (GGA)
       satellites.set(term);
+      EPOCH_FIELD(GP02Fix::HasSatellites);
       break;
     case COMBINE(GPS_SENTENCE_GGA, 8): // HDOP
       hdop.set(term);
+      EPOCH_FIELD(GP02Fix::HasHDOP);
       break;
     case COMBINE(GPS_SENTENCE_GGA, 9): // Altitude (GGA)
       altitude.set(term);
+      EPOCH_FIELD(GP02Fix::HasAltitude);
       break;
     case COMBINE(GPS_SENTENCE_RMC, 12):
       location.newFixMode = (GP02Location::Mode)term[0];
       break;
+#ifdef _GPS_EPOCHS
+    case COMBINE(GPS_SENTENCE_GSA, 2): // Fix type (GSA)
+      epoch.newFixType = term[0] - '0';
+      break;
+    case COMBINE(GPS_SENTENCE_GSA, 15): // PDOP (GSA)
+      epoch.newPdop = parseDecimal(term);
+      EPOCH_FIELD(GP02Fix::HasDOP);
+      break;
+    case COMBINE(GPS_SENTENCE_GSA, 16): // HDOP (GSA)
+      epoch.newHdop = parseDecimal(term);
+      EPOCH_FIELD(GP02Fix::HasHDOP);
+      break;
+    case COMBINE(GPS_SENTENCE_GSA, 17): // VDOP (GSA)
+      epoch.newVdop = parseDecimal(term);
+      EPOCH_FIELD(GP02Fix::HasDOP);
+      break;
+    case COMBINE(GPS_SENTENCE_GSV, 2): // Message number (GSV)
+      epoch.newGsvMessage = (uint8_t)atol(term);
+      break;
+    case COMBINE(GPS_SENTENCE_GSV, 3): // Satellites in view (GSV)
+      epoch.newInView = (uint8_t)atol(term);
+      EPOCH_FIELD(GP02Fix::HasInView);
+      break;
+    case COMBINE(GPS_SENTENCE_VTG, 1): // Course (VTG)
+      epoch.newCourse = parseDecimal(term);
+      EPOCH_FIELD(GP02Fix::HasCourse);
+      break;
+    case COMBINE(GPS_SENTENCE_VTG, 5): // Speed in knots (VTG)
+      epoch.newSpeed = parseDecimal(term);
+      EPOCH_FIELD(GP02Fix::HasSpeed);
+      break;
+#endif
   }
 
   // Set custom values as needed
@@ -346,6 +568,136 @@ bool GP02::endOfTermHandler()
   return false;
 }
 
+#ifdef _GPS_EPOCHS
+/**
+ * @brief Folds the sentence that just passed its checksum into the current epoch.
+ * 
+ * This function merges the staged values of a validated RMC, GGA, GSA, GSV or VTG sentence
+ * into the pending epoch. When the sentence carries a UTC time different from the pending
+ * epoch's, the pending epoch is closed and published first. If the sentence is the configured
+ * terminator, the epoch is published right after the merge. Timed sentences that arrive for an
+ * epoch that has already been closed by the terminator are discarded.
+ */
+void GP02::assembleEpoch()
+{
+  if (curSentenceType == GPS_SENTENCE_OTHER)
+    return;
+
+  GP02Fix &p = epoch.pending;
+  uint16_t fields = epoch.newFields;
+  if (!sentenceHasFix && (curSentenceType == GPS_SENTENCE_RMC || curSentenceType == GPS_SENTENCE_GGA))
+    fields &= ~(GP02Fix::HasLocation | GP02Fix::HasSpeed | GP02Fix::HasCourse | GP02Fix::HasAltitude);
+  if (curSentenceType == GPS_SENTENCE_GSV && epoch.newGsvMessage != 1)
+    fields &= ~GP02Fix::HasInView;
+
+  if (fields & GP02Fix::HasTime)
+  {
+    if (p.has(GP02Fix::HasTime) && p.time != time.newTime)
+      commitEpoch();
+    else if (p.fields == 0 && time.newTime == epoch.closedTime)
+      return;
+    epoch.trailing = false;
+  }
+  else if (epoch.trailing)
+    return;
+
+  p.sentences |= 1 << curSentenceType;
+  p.fields |= fields;
+  if (fields & GP02Fix::HasTime)
+    p.time = time.newTime;
+  if (fields & GP02Fix::HasDate)
+    p.date = date.newDate;
+  if (fields & GP02Fix::HasLocation)
+  {
+    p.lat = location.stagedLat();
+    p.lng = location.stagedLng();
+  }
+
+  switch(curSentenceType)
+  {
+  case GPS_SENTENCE_RMC:
+    if (fields & GP02Fix::HasLocation)
+      p.fixMode = location.newFixMode;
+    if (fields & GP02Fix::HasSpeed)
+      p.speed = speed.staged();
+    if (fields & GP02Fix::HasCourse)
+      p.course = course.staged();
+    break;
+  case GPS_SENTENCE_GGA:
+    p.fixQuality = location.newFixQuality;
+    if (fields & GP02Fix::HasAltitude)
+      p.altitude = altitude.staged();
+    if (fields & GP02Fix::HasSatellites)
+      p.satellites = satellites.staged();
+    if (fields & GP02Fix::HasHDOP)
+      p.hdop = hdop.staged();
+    break;
+  case GPS_SENTENCE_GSA:
+    if (epoch.newFixType)
+      p.fixType = epoch.newFixType;
+    if (epoch.newPdop >= 0)
+      p.pdop = epoch.newPdop;
+    if (epoch.newVdop >= 0)
+      p.vdop = epoch.newVdop;
+    if (fields & GP02Fix::HasHDOP)
+      p.hdop = epoch.newHdop;
+    break;
+  case GPS_SENTENCE_GSV:
+    if (fields & GP02Fix::HasInView)
+      p.satellitesInView += epoch.newInView;
+    break;
+  case GPS_SENTENCE_VTG:
+    if (fields & GP02Fix::HasSpeed)
+      p.speed = epoch.newSpeed;
+    if (fields & GP02Fix::HasCourse)
+      p.course = epoch.newCourse;
+    break;
+  }
+
+  if (epoch.terminator & (1 << curSentenceType))
+  {
+    commitEpoch();
+    epoch.trailing = true;
+  }
+}
+
+/**
+ * @brief Stamps the pending epoch with its Unix time and publishes it.
+ * 
+ * The day number of the epoch's date is taken from the GP02Date cache when the date matches
+ * the last committed one, so the calendar conversion runs at most once per day.
+ */
+void GP02::commitEpoch()
+{
+  GP02Fix &p = epoch.pending;
+  if (p.has(GP02Fix::HasDate) && p.has(GP02Fix::HasTime))
+  {
+    int32_t days = date.valid && p.date == date.date ? date.days : GP02Date::daysFromPacked(p.date);
+    p.unixMillis = (uint64_t)days * _GPS_SECONDS_PER_DAY * 1000 + GP02Time::millisFromPacked(p.time);
+  }
+  epoch.commit();
+}
+
+/**
+ * @brief Starts assembling sentences into per-epoch GP02Fix records.
+ * 
+ * Once enabled, every validated RMC, GGA, GSA, GSV and VTG sentence is merged into a pending
+ * epoch keyed on its UTC time, and the epoch object is updated once per receiver epoch instead
+ * of once per sentence. An epoch closes when a sentence with a new UTC time arrives or, if a
+ * terminator is given, immediately after that sentence type has been received.
+ * 
+ * @param terminator A GP02Epoch::Sentence value (or a mask of them) that closes the epoch, or GP02Epoch::None.
+ */
+void GP02::enableEpochs(uint8_t terminator)
+{
+  epoch.pending.clear();
+  epoch.closedTime = (uint32_t)ULONG_MAX;
+  epoch.trailing = false;
+  epoch.terminator = terminator;
+  epoch.enabled = true;
+}
+#endif
+
 /* static */
 
 /**
@@ -441,13 +793,22 @@ const char *GP02::cardinal(double course)
  * @brief Commits the new location data to the GP02Location object.
  * 
  * This function updates the GP02Location object with the new latitude, longitude, fix quality,
- * and fix mode data. It also sets the last commit time to the current millis() value and marks
+ * and fix mode data. With _GPS_LAZY_DECODE only the raw coordinate text is copied and decoding
+ * is left to the first accessor call. It also sets the last commit time to the current millis() value and marks
  * the location data as valid and updated.
  */
 void GP02Location::commit()
 {
+#ifdef _GPS_LAZY_DECODE
+   memcpy(latText, newLatText, sizeof(latText));
+   memcpy(lngText, newLngText, sizeof(lngText));
+   rawLatData.negative = rawNewLatData.negative;
+   rawLngData.negative = rawNewLngData.negative;
+   decoded = 0;
+#else
    rawLatData = rawNewLatData;
    rawLngData = rawNewLngData;
+#endif
    fixQuality = newFixQuality;
    fixMode = newFixMode;
    lastCommitTime = millis();
@@ -464,7 +825,11 @@ void GP02Location::commit()
  */
 void GP02Location::setLatitude(const char *term)
 {
+#ifdef _GPS_LAZY_DECODE
+   GP02::copyTerm(newLatText, term, sizeof(newLatText));
+#else
    GP02::parseDegrees(term, rawNewLatData);
+#endif
 }
 
 /**
@@ -477,65 +842,325 @@ void GP02Location::setLatitude(const char *term)
  */
 void GP02Location::setLongitude(const char *term)
 {
+#ifdef _GPS_LAZY_DECODE
+   GP02::copyTerm(newLngText, term, sizeof(newLngText));
+#else
    GP02::parseDegrees(term, rawNewLngData);
+#endif
+}
+
+/**
+ * @brief Returns the latitude of the sentence being parsed, before it is committed.
+ */
+RawDegrees GP02Location::stagedLat() const
+{
+#ifdef _GPS_LAZY_DECODE
+   RawDegrees deg;
+   GP02::parseDegrees(newLatText, deg);
+   deg.negative = rawNewLatData.negative;
+   return deg;
+#else
+   return rawNewLatData;
+#endif
+}
+
+/**
+ * @brief Returns the longitude of the sentence being parsed, before it is committed.
+ */
+RawDegrees GP02Location::stagedLng() const
+{
+#ifdef _GPS_LAZY_DECODE
+   RawDegrees deg;
+   GP02::parseDegrees(newLngText, deg);
+   deg.negative = rawNewLngData.negative;
+   return deg;
+#else
+   return rawNewLngData;
+#endif
+}
+
+#ifdef _GPS_LAZY_DECODE
+/**
+ * @brief Returns the raw latitude, decoding the committed text on the first call after a commit.
+ * 
+ * @return The latitude as degrees and billionths of a degree.
+ */
+const RawDegrees &GP02Location::rawLat()
+{
+   updated = false;
+   if (!(decoded & DecodedRawLat))
+   {
+      bool negative = rawLatData.negative;
+      GP02::parseDegrees(latText, rawLatData);
+      rawLatData.negative = negative;
+      decoded |= DecodedRawLat;
+   }
+   return rawLatData;
+}
+
+/**
+ * @brief Returns the raw longitude, decoding the committed text on the first call after a commit.
+ * 
+ * @return The longitude as degrees and billionths of a degree.
+ */
+const RawDegrees &GP02Location::rawLng()
+{
+   updated = false;
+   if (!(decoded & DecodedRawLng))
+   {
+      bool negative = rawLngData.negative;
+      GP02::parseDegrees(lngText, rawLngData);
+      rawLngData.negative = negative;
+      decoded |= DecodedRawLng;
+   }
+   return rawLngData;
 }
+#endif
 
 /**
  * @brief Returns the latitude value of the GP02Location object.
  * 
  * This function returns the latitude value of the GP02Location object. It combines the
- * degree and billionths parts of the latitude data to calculate the actual latitude value.
+ * degree and billionths parts of the latitude data to calculate the actual latitude value;
+ * with _GPS_LAZY_DECODE the result is cached until the next commit.
  * 
  * @return The latitude value in decimal-degrees.
  */
 double GP02Location::lat()
 {
+#ifdef _GPS_LAZY_DECODE
+   if (!(decoded & DecodedLat))
+   {
+      const RawDegrees &raw = rawLat();
+      latCache = raw.deg + raw.billionths / 1000000000.0;
+      if (raw.negative)
+         latCache = -latCache;
+      decoded |= DecodedLat;
+   }
+   updated = false;
+   return latCache;
+#else
    updated = false;
    double ret = rawLatData.deg + rawLatData.billionths / 1000000000.0;
    return rawLatData.negative ? -ret : ret;
+#endif
 }
 
 /**
  * @brief Returns the longitude value of the GP02Location object.
  * 
  * This function returns the longitude value of the GP02Location object. It combines the
- * degree and billionths parts of the longitude data to calculate the actual longitude value.
+ * degree and billionths parts of the longitude data to calculate the actual longitude value;
+ * with _GPS_LAZY_DECODE the result is cached until the next commit.
  * 
  * @return The longitude value in decimal-degrees.
  */
 double GP02Location::lng()
 {
+#ifdef _GPS_LAZY_DECODE
+   if (!(decoded & DecodedLng))
+   {
+      const RawDegrees &raw = rawLng();
+      lngCache = raw.deg + raw.billionths / 1000000000.0;
+      if (raw.negative)
+         lngCache = -lngCache;
+      decoded |= DecodedLng;
+   }
+   updated = false;
+   return lngCache;
+#else
    updated = false;
    double ret = rawLngData.deg + rawLngData.billionths / 1000000000.0;
    return rawLngData.negative ? -ret : ret;
+#endif
+}
+
+/**
+ * @brief Resets the GP02Fix record to an empty state.
+ * 
+ * This function clears all values of the record and marks every field as absent.
+ */
+void GP02Fix::clear()
+{
+   fields = 0;
+   sentences = 0;
+   date = time = 0;
+   unixMillis = 0;
+   lat = lng = RawDegrees();
+   fixQuality = GP02Location::Invalid;
+   fixMode = GP02Location::N;
+   fixType = satellitesInView = 0;
+   satellites = 0;
+   speed = course = altitude = 0;
+   hdop = pdop = vdop = 0;
+}
+
+#ifdef _GPS_EPOCHS
+/**
+ * @brief Clears the values staged for the epoch at the start of a sentence.
+ *
+ * Only terms that are present in a sentence overwrite these, so nothing of the previous
+ * sentence is carried into the next one.
+ */
+void GP02Epoch::begin()
+{
+   newFields = 0;
+   newFixType = newInView = newGsvMessage = 0;
+   newSpeed = newCourse = newHdop = 0;
+   newPdop = newVdop = -1;
+}
+
+/**
+ * @brief Publishes the pending epoch as the current GP02Fix record.
+ * 
+ * This function copies the pending epoch to the published record, remembers its UTC time so
+ * that late sentences of the same epoch can be recognized, sets the last commit time to the
+ * current millis() value and marks the epoch as valid and updated. Empty epochs are ignored.
+ */
+void GP02Epoch::commit()
+{
+   if (pending.fields == 0)
+      return;
+   record = pending;
+   closedTime = pending.has(GP02Fix::HasTime) ? pending.time : (uint32_t)ULONG_MAX;
+   pending.clear();
+   lastCommitTime = millis();
+   valid = updated = true;
 }
+#endif
 
 /**
  * @brief Commits the new date to the GP02Date object.
  * 
- * This function updates the GP02Date object with the new date value. It also sets the last commit
- * time to the current millis() value and marks the date data as valid and updated.
+ * This function updates the GP02Date object with the new date value. The calendar fields and
+ * the day number are decoded only when the date actually changes, so they are computed once
+ * per day rather than on every RMC sentence. It also sets the last commit time to the current
+ * millis() value and marks the date data as valid and updated.
  */
 void GP02Date::commit()
 {
+   if (!valid || newDate != date)
+   {
+      days = daysFromPacked(newDate);
+      civilFromDays(days, yearCache, monthCache, dayCache);
+   }
    date = newDate;
    lastCommitTime = millis();
    valid = updated = true;
 }
 
+int32_t GP02Date::rolloverFloor = _GPS_ROLLOVER_FLOOR;
+
+/**
+ * @brief Converts a packed NMEA date to days since 1970-01-01.
+ * 
+ * Two-digit years from _GPS_CENTURY_PIVOT on are taken as 19xx and the others as 20xx. If a
+ * rollover floor is set (see setRolloverFloor()), dates before it are assumed to come from a
+ * receiver that mishandles the GPS week-number rollover and are moved forward by multiples of
+ * 1024 weeks. Every date the library reports, as calendar fields, text or Unix time, goes
+ * through this function.
+ * 
+ * @param ddmmyy The date as reported in RMC, e.g. 181026.
+ * @return The number of days since 1970-01-01.
+ */
+int32_t GP02Date::daysFromPacked(uint32_t ddmmyy)
+{
+   uint8_t d = ddmmyy / 10000;
+   uint8_t m = (ddmmyy / 100) % 100;
+   int32_t days = daysFromCivil(fullYear(ddmmyy % 100), m, d);
+   if (rolloverFloor > 0)
+      while (days < rolloverFloor)
+         days += _GPS_ROLLOVER_DAYS;
+   return days;
+}
+
+/**
+ * @brief Converts a packed NMEA date to the calendar date daysFromPacked() stands for.
+ * 
+ * Without a rollover correction this only splits the digits.
+ * 
+ * @param ddmmyy The date as reported in RMC, e.g. 181026.
+ * @param y Receives the four-digit year.
+ * @param m Receives the month (1-12).
+ * @param d Receives the day of the month (1-31).
+ */
+void GP02Date::civilFromPacked(uint32_t ddmmyy, uint16_t &y, uint8_t &m, uint8_t &d)
+{
+   d = ddmmyy / 10000;
+   m = (ddmmyy / 100) % 100;
+   y = fullYear(ddmmyy % 100);
+   if (rolloverFloor > 0 && daysFromCivil(y, m, d) < rolloverFloor)
+      civilFromDays(daysFromPacked(ddmmyy), y, m, d);
+}
+
+/**
+ * @brief Converts days since 1970-01-01 back to a calendar date.
+ * 
+ * @param days The number of days since 1970-01-01.
+ * @param y Receives the year.
+ * @param m Receives the month (1-12).
+ * @param d Receives the day of the month (1-31).
+ */
+void GP02Date::civilFromDays(int32_t days, uint16_t &y, uint8_t &m, uint8_t &d)
+{
+   days += 719468L;
+   int32_t era = days / 146097L;
+   uint32_t doe = (uint32_t)(days - era * 146097L);
+   uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+   uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+   uint32_t mp = (5 * doy + 2) / 153;
+   d = (uint8_t)(doy - (153 * mp + 2) / 5 + 1);
+   m = (uint8_t)(mp < 10 ? mp + 3 : mp - 9);
+   y = (uint16_t)(yoe + era * 400 + (m <= 2));
+}
+
 /**
  * @brief Commits the new time to the GP02Time object.
  * 
- * This function updates the GP02Time object with the new time value. It also sets the last commit
- * time to the current millis() value and marks the time data as valid and updated.
+ * This function updates the GP02Time object with the new time value and decodes the hour,
+ * minute, second, centisecond and milliseconds of the day once, so that the accessors do not
+ * repeat the divisions. With _GPS_LAZY_DECODE that happens on the first accessor call instead. It also sets the last commit time to the current millis() value and
+ * marks the time data as valid and updated.
  */
 void GP02Time::commit()
 {
    time = newTime;
+#ifdef _GPS_LAZY_DECODE
+   decoded = false;
+#else
+   decode();
+#endif
    lastCommitTime = millis();
    valid = updated = true;
 }
 
+/**
+ * @brief Splits the committed time into its cached hour, minute, second and centisecond fields.
+ */
+void GP02Time::decode()
+{
+   hourCache = time / 1000000;
+   minuteCache = (time / 10000) % 100;
+   secondCache = (time / 100) % 100;
+   centisecondCache = time % 100;
+   msOfDay = ((hourCache * 60UL + minuteCache) * 60UL + secondCache) * 1000UL + centisecondCache * 10UL;
+   decoded = true;
+}
+
+/**
+ * @brief Converts a packed NMEA time to milliseconds since midnight.
+ * 
+ * @param hhmmsscc The time as returned by GP02Time::value().
+ * @return The number of milliseconds since 00:00:00.
+ */
+uint32_t GP02Time::millisFromPacked(uint32_t hhmmsscc)
+{
+   uint8_t hh = hhmmsscc / 1000000;
+   uint8_t mm = (hhmmsscc / 10000) % 100;
+   uint8_t ss = (hhmmsscc / 100) % 100;
+   return ((hh * 60UL + mm) * 60UL + ss) * 1000UL + (hhmmsscc % 100) * 10UL;
+}
+
 /**
  * @brief Sets the time of the GP02Time object using the provided term.
  * 
@@ -565,100 +1190,102 @@ void GP02Date::setDate(const char *term)
 /**
  * @brief Returns the year value of the GP02Date object.
  * 
- * This function calculates and returns the year value of the GP02Date object by extracting
- * the last two digits of the date and adding 2000 to it.
+ * This function returns the four-digit year decoded at commit time. Two-digit years from
+ * _GPS_CENTURY_PIVOT on are 19xx, the others 20xx, after any week-number rollover correction
+ * set with setRolloverFloor().
  * 
  * @return The year value.
  */
 uint16_t GP02Date::year()
 {
    updated = false;
-   uint16_t year = date % 100;
-   return year + 2000;
+   return yearCache;
 }
 
 /**
  * @brief Returns the month value of the GP02Date object.
  * 
- * This function calculates and returns the month value of the GP02Date object by extracting
- * the middle two digits of the date.
+ * This function returns the month value of the GP02Date object decoded at commit time.
  * 
  * @return The month value.
  */
 uint8_t GP02Date::month()
 {
    updated = false;
-   return (date / 100) % 100;
+   return monthCache;
 }
 
 /**
  * @brief Returns the day value of the GP02Date object.
  * 
- * This function calculates and returns the day value of the GP02Date object by extracting
- * the first two digits of the date.
+ * This function returns the day value of the GP02Date object decoded at commit time.
  * 
  * @return The day value.
  */
 uint8_t GP02Date::day()
 {
    updated = false;
-   return date / 10000;
+   return dayCache;
 }
 
 /**
  * @brief Returns the hour value of the GP02Time object.
  * 
- * This function calculates and returns the hour value of the GP02Time object by extracting
- * the first two digits of the time.
+ * This function returns the hour value of the GP02Time object decoded at commit time.
  * 
  * @return The hour value.
  */
 uint8_t GP02Time::hour()
 {
    updated = false;
-   return time / 1000000;
+   if (!decoded)
+      decode();
+   return hourCache;
 }
 
 /**
  * @brief Returns the minute value of the GP02Time object.
  * 
- * This function calculates and returns the minute value of the GP02Time object by extracting
- * the middle two digits of the time.
+ * This function returns the minute value of the GP02Time object decoded at commit time.
  * 
  * @return The minute value.
  */
 uint8_t GP02Time::minute()
 {
    updated = false;
-   return (time / 10000) % 100;
+   if (!decoded)
+      decode();
+   return minuteCache;
 }
 
 /**
  * @brief Returns the second value of the GP02Time object.
  * 
- * This function calculates and returns the second value of the GP02Time object by extracting
- * the last two digits of the time.
+ * This function returns the second value of the GP02Time object decoded at commit time.
  * 
  * @return The second value.
  */
 uint8_t GP02Time::second()
 {
    updated = false;
-   return (time / 100) % 100;
+   if (!decoded)
+      decode();
+   return secondCache;
 }
 
 /**
  * @brief Returns the centisecond value of the GP02Time object.
  * 
- * This function calculates and returns the centisecond value of the GP02Time object by extracting
- * the last two digits of the time.
+ * This function returns the centisecond value of the GP02Time object decoded at commit time.
  * 
  * @return The centisecond value.
  */
 uint8_t GP02Time::centisecond()
 {
    updated = false;
-   return time % 100;
+   if (!decoded)
+      decode();
+   return centisecondCache;
 }
 
 /**
@@ -669,7 +1296,12 @@ uint8_t GP02Time::centisecond()
  */
 void GP02Decimal::commit()
 {
+#ifdef _GPS_LAZY_DECODE
+   memcpy(text, newText, sizeof(text));
+   decoded = false;
+#else
    val = newval;
+#endif
    lastCommitTime = millis();
    valid = updated = true;
 }
@@ -683,9 +1315,43 @@ void GP02Decimal::commit()
  */
 void GP02Decimal::set(const char *term)
 {
+#ifdef _GPS_LAZY_DECODE
+   GP02::copyTerm(newText, term, sizeof(newText));
+#else
    newval = GP02::parseDecimal(term);
+#endif
 }
 
+/**
+ * @brief Returns the value of the sentence being parsed, before it is committed.
+ */
+int32_t GP02Decimal::staged() const
+{
+#ifdef _GPS_LAZY_DECODE
+   return GP02::parseDecimal(newText);
+#else
+   return newval;
+#endif
+}
+
+#ifdef _GPS_LAZY_DECODE
+/**
+ * @brief Returns the value in hundredths, decoding the committed text on the first call after a commit.
+ * 
+ * @return The value in hundredths.
+ */
+int32_t GP02Decimal::value()
+{
+   updated = false;
+   if (!decoded)
+   {
+      val = GP02::parseDecimal(text);
+      decoded = true;
+   }
+   return val;
+}
+#endif
+
 /**
  * @brief Commits the new value to the GP02Integer object.
  * 
@@ -694,7 +1360,12 @@ void GP02Decimal::set(const char *term)
  */
 void GP02Integer::commit()
 {
+#ifdef _GPS_LAZY_DECODE
+   memcpy(text, newText, sizeof(text));
+   decoded = false;
+#else
    val = newval;
+#endif
    lastCommitTime = millis();
    valid = updated = true;
 }
@@ -709,9 +1380,43 @@ void GP02Integer::commit()
  */
 void GP02Integer::set(const char *term)
 {
+#ifdef _GPS_LAZY_DECODE
+   GP02::copyTerm(newText, term, sizeof(newText));
+#else
    newval = atol(term);
+#endif
 }
 
+/**
+ * @brief Returns the value of the sentence being parsed, before it is committed.
+ */
+uint32_t GP02Integer::staged() const
+{
+#ifdef _GPS_LAZY_DECODE
+   return atol(newText);
+#else
+   return newval;
+#endif
+}
+
+#ifdef _GPS_LAZY_DECODE
+/**
+ * @brief Returns the value, decoding the committed text on the first call after a commit.
+ * 
+ * @return The value.
+ */
+uint32_t GP02Integer::value()
+{
+   updated = false;
+   if (!decoded)
+   {
+      val = atol(text);
+      decoded = true;
+   }
+   return val;
+}
+#endif
+
 /**
  * @brief Constructs a GP02Custom object with the given parameters.
  * 
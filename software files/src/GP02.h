@@ -4,6 +4,7 @@
 #include <inttypes.h>
 #include "Arduino.h"
 #include <limits.h>
+#include "GP02Config.h"
 
 #define _GPS_VERSION "1.1.0" // software version of this library
 #define _GPS_MPH_PER_KNOT 1.15077945
@@ -14,6 +15,16 @@
 #define _GPS_FEET_PER_METER 3.2808399
 #define _GPS_MAX_FIELD_SIZE 15
 #define _GPS_EARTH_MEAN_RADIUS 6371009 // old: 6372795
+#define _GPS_SECONDS_PER_DAY 86400UL
+#define _GPS_CENTURY_PIVOT 80 // two-digit years from 80 are 19xx (GPS epoch 1980), below are 20xx
+#ifndef _GPS_ROLLOVER_FLOOR
+#define _GPS_ROLLOVER_FLOOR 0 // days since 1970 before which dates are taken as week-number rollovers; 0 = none
+#endif
+#define _GPS_ROLLOVER_DAYS 7168 // 1024 GPS weeks
+#define _GPS_RAW_TERM_SIZE _GPS_MAX_FIELD_SIZE // raw text kept per field with _GPS_LAZY_DECODE, including the NUL
+#define _GPS_MAX_SENTENCE_LENGTH 82 // NMEA 0183 limit from '$' to LF inclusive, enforced by strict framing
+#define _GPS_MAX_TERMS 32 // terms per sentence the term switch can tell apart
+#define _GPS_BUDGET_CHECK_INTERVAL 4 // encodeFor() reads the clock every this many bytes and after each sentence
 
 struct RawDegrees
 {
@@ -35,15 +46,25 @@ public:
    bool isValid() const    { return valid; }
    bool isUpdated() const  { return updated; }
    uint32_t age() const    { return valid ? millis() - lastCommitTime : (uint32_t)ULONG_MAX; }
+#ifdef _GPS_LAZY_DECODE
+   const RawDegrees &rawLat();
+   const RawDegrees &rawLng();
+#else
    const RawDegrees &rawLat()     { updated = false; return rawLatData; }
    const RawDegrees &rawLng()     { updated = false; return rawLngData; }
+#endif
    double lat();
    double lng();
    Quality FixQuality()           { updated = false; return fixQuality; }
    Mode FixMode()                 { updated = false; return fixMode; }
 
+#ifdef _GPS_LAZY_DECODE
+   GP02Location() : valid(false), updated(false), fixQuality(Invalid), fixMode(N), decoded(DecodedAll), latCache(0), lngCache(0)
+   { latText[0] = lngText[0] = newLatText[0] = newLngText[0] = '\0'; }
+#else
    GP02Location() : valid(false), updated(false), fixQuality(Invalid), fixMode(N)
    {}
+#endif
 
 private:
    bool valid, updated;
@@ -51,9 +72,18 @@ private:
    Quality fixQuality, newFixQuality;
    Mode fixMode, newFixMode;
    uint32_t lastCommitTime;
+#ifdef _GPS_LAZY_DECODE
+   enum { DecodedRawLat = 0x01, DecodedRawLng = 0x02, DecodedLat = 0x04, DecodedLng = 0x08, DecodedAll = 0x0F };
+   uint8_t decoded;
+   double latCache, lngCache;
+   char latText[_GPS_RAW_TERM_SIZE], lngText[_GPS_RAW_TERM_SIZE];
+   char newLatText[_GPS_RAW_TERM_SIZE], newLngText[_GPS_RAW_TERM_SIZE];
+#endif
    void commit();
    void setLatitude(const char *term);
    void setLongitude(const char *term);
+   RawDegrees stagedLat() const;
+   RawDegrees stagedLng() const;
 };
 
 struct GP02Date
@@ -68,16 +98,42 @@ public:
    uint16_t year();
    uint8_t month();
    uint8_t day();
-
-   GP02Date() : valid(false), updated(false), date(0)
+   uint32_t unixTime()        { updated = false; return (uint32_t)days * _GPS_SECONDS_PER_DAY; } // 00:00 UTC
+   int32_t daysSinceEpoch() const { return days; }
+
+   // days since 1970-01-01 (proleptic Gregorian), usable in constant expressions
+   static constexpr int32_t daysFromCivil(int16_t y, uint8_t m, uint8_t d)
+   { return daysFromShiftedYear(m <= 2 ? y - 1 : y, m, d); }
+   static constexpr uint16_t fullYear(uint8_t yy)
+   { return yy >= _GPS_CENTURY_PIVOT ? 1900 + yy : 2000 + yy; }
+   static int32_t daysFromPacked(uint32_t ddmmyy);
+   static void civilFromPacked(uint32_t ddmmyy, uint16_t &y, uint8_t &m, uint8_t &d);
+
+   // dates before this day (since 1970) are moved forward by 1024 GPS weeks until they are not,
+   // for receivers with a week-number rollover bug; e.g. the day the firmware was built, set
+   // before the first date is parsed. 0 (the default, see _GPS_ROLLOVER_FLOOR) corrects nothing.
+   static void setRolloverFloor(int32_t days) { rolloverFloor = days; }
+   static int32_t rolloverFloorDays()         { return rolloverFloor; }
+
+   GP02Date() : valid(false), updated(false), date(0), days(0), yearCache(2000), monthCache(0), dayCache(0)
    {}
 
 private:
    bool valid, updated;
    uint32_t date, newDate;
    uint32_t lastCommitTime;
+   int32_t days;
+   uint16_t yearCache;
+   uint8_t monthCache, dayCache;
+   static int32_t rolloverFloor;
    void commit();
    void setDate(const char *term);
+   static void civilFromDays(int32_t days, uint16_t &y, uint8_t &m, uint8_t &d);
+
+   static constexpr int32_t daysFromShiftedYear(int32_t y, uint8_t m, uint8_t d)
+   { return (y / 400) * 146097L + dayOfEra(y % 400, (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1) - 719468L; }
+   static constexpr int32_t dayOfEra(int32_t yoe, int32_t doy)
+   { return yoe * 365L + yoe / 4 - yoe / 100 + doy; }
 };
 
 struct GP02Time
@@ -93,15 +149,21 @@ public:
    uint8_t minute();
    uint8_t second();
    uint8_t centisecond();
+   uint32_t millisOfDay()     { updated = false; if (!decoded) decode(); return msOfDay; }
+
+   static uint32_t millisFromPacked(uint32_t hhmmsscc);
 
-   GP02Time() : valid(false), updated(false), time(0)
+   GP02Time() : valid(false), updated(false), decoded(true), time(0), msOfDay(0), hourCache(0), minuteCache(0), secondCache(0), centisecondCache(0)
    {}
 
 private:
-   bool valid, updated;
+   bool valid, updated, decoded;
    uint32_t time, newTime;
    uint32_t lastCommitTime;
+   uint32_t msOfDay;
+   uint8_t hourCache, minuteCache, secondCache, centisecondCache;
    void commit();
+   void decode();
    void setTime(const char *term);
 };
 
@@ -112,17 +174,31 @@ public:
    bool isValid() const    { return valid; }
    bool isUpdated() const  { return updated; }
    uint32_t age() const    { return valid ? millis() - lastCommitTime : (uint32_t)ULONG_MAX; }
+#ifdef _GPS_LAZY_DECODE
+   int32_t value();
+
+   GP02Decimal() : valid(false), updated(false), decoded(true), val(0)
+   { text[0] = newText[0] = '\0'; }
+#else
    int32_t value()         { updated = false; return val; }
 
    GP02Decimal() : valid(false), updated(false), val(0)
    {}
+#endif
 
 private:
    bool valid, updated;
    uint32_t lastCommitTime;
+#ifdef _GPS_LAZY_DECODE
+   bool decoded;
+   int32_t val;
+   char text[_GPS_RAW_TERM_SIZE], newText[_GPS_RAW_TERM_SIZE];
+#else
    int32_t val, newval;
+#endif
    void commit();
    void set(const char *term);
+   int32_t staged() const;
 };
 
 struct GP02Integer
@@ -132,17 +208,31 @@ public:
    bool isValid() const    { return valid; }
    bool isUpdated() const  { return updated; }
    uint32_t age() const    { return valid ? millis() - lastCommitTime : (uint32_t)ULONG_MAX; }
+#ifdef _GPS_LAZY_DECODE
+   uint32_t value();
+
+   GP02Integer() : valid(false), updated(false), decoded(true), val(0)
+   { text[0] = newText[0] = '\0'; }
+#else
    uint32_t value()        { updated = false; return val; }
 
    GP02Integer() : valid(false), updated(false), val(0)
    {}
+#endif
 
 private:
    bool valid, updated;
    uint32_t lastCommitTime;
+#ifdef _GPS_LAZY_DECODE
+   bool decoded;
+   uint32_t val;
+   char text[_GPS_RAW_TERM_SIZE], newText[_GPS_RAW_TERM_SIZE];
+#else
    uint32_t val, newval;
+#endif
    void commit();
    void set(const char *term);
+   uint32_t staged() const;
 };
 
 struct GP02Speed : GP02Decimal
@@ -171,6 +261,62 @@ struct GP02HDOP : GP02Decimal
    double hdop() { return value() / 100.0; }
 };
 
+struct GP02Fix
+{
+   enum Field { HasDate = 0x001, HasTime = 0x002, HasLocation = 0x004, HasSpeed = 0x008, HasCourse = 0x010,
+                HasAltitude = 0x020, HasSatellites = 0x040, HasHDOP = 0x080, HasDOP = 0x100, HasInView = 0x200 };
+
+   bool has(Field f) const { return (fields & f) != 0; }
+   void clear();
+
+   GP02Fix() { clear(); }
+
+   uint16_t fields;              // Field bits present in this record
+   uint8_t sentences;            // GP02Epoch::Sentence bits that contributed
+   uint32_t date;                // ddmmyy, as GP02Date::value()
+   uint32_t time;                // hhmmsscc, as GP02Time::value()
+   uint64_t unixMillis;          // milliseconds since 1970, when HasDate and HasTime
+   RawDegrees lat, lng;
+   GP02Location::Quality fixQuality;
+   GP02Location::Mode fixMode;
+   uint8_t fixType;              // GSA: 1 = none, 2 = 2D, 3 = 3D
+   uint8_t satellitesInView;     // GSV, summed over talkers
+   uint32_t satellites;          // GGA, satellites used
+   int32_t speed, course;        // hundredths of knots / degrees
+   int32_t altitude;             // hundredths of meters
+   int32_t hdop, pdop, vdop;     // hundredths
+};
+
+struct GP02Epoch
+{
+   friend class GP02;
+public:
+   enum Sentence { None = 0, GGA = 0x01, RMC = 0x02, GSA = 0x04, GSV = 0x08, VTG = 0x10 };
+
+   bool isValid() const       { return valid; }
+   bool isUpdated() const     { return updated; }
+   uint32_t age() const       { return valid ? millis() - lastCommitTime : (uint32_t)ULONG_MAX; }
+   const GP02Fix &value()     { updated = false; return record; }
+
+   GP02Epoch() : valid(false), updated(false), enabled(false), trailing(false), terminator(None), lastCommitTime(0)
+     , closedTime((uint32_t)ULONG_MAX), newFields(0), newFixType(0), newInView(0), newGsvMessage(0)
+     , newSpeed(0), newCourse(0), newHdop(0), newPdop(-1), newVdop(-1)
+   {}
+
+private:
+   bool valid, updated, enabled;
+   bool trailing;                // the terminator closed the last epoch and no timed sentence has followed
+   uint8_t terminator;
+   GP02Fix record, pending;
+   uint32_t lastCommitTime;
+   uint32_t closedTime;
+   uint16_t newFields;
+   uint8_t newFixType, newInView, newGsvMessage;
+   int32_t newSpeed, newCourse, newHdop, newPdop, newVdop; // PDOP and VDOP are -1 until parsed
+   void begin();
+   void commit();
+};
+
 class GP02;
 class GP02Custom
 {
@@ -198,13 +344,35 @@ private:
    GP02Custom *next;
 };
 
+struct GP02Drain
+{
+   enum Stop { Drained, ByteBudget, TimeBudget };
+
+   uint16_t bytes;               // characters consumed by this call, at most 65535 (see encodeFor())
+   uint16_t sentences;           // valid sentences completed by this call
+   uint8_t stop;                 // Stop: why the call returned
+   uint16_t elapsed;             // microseconds spent, clamped to 65535
+   int backlog;                  // source.available() on return; bytes left for the next call
+};
+
+// called at the events of GP02::TraceEvent with the GP02Epoch::Sentence bit of the sentence
+typedef void (*GP02TraceHandler)(void *context, GP02 &gps, uint8_t event, uint8_t sentence);
+
 class GP02
 {
 public:
-  GP02();
+  // the tag only makes a sketch built with other GP02Config.h switches than the library fail to link
+  GP02(GP02ConfigTag = GP02ConfigTag());
   bool encode(char c); // process one character received from GPS
+  size_t encode(const char *data, size_t length); // process a block, returns valid sentences
   GP02 &operator << (char c) {encode(c); return *this;}
 
+  // drain a Stream-like source (available()/read()) until it is empty or a budget is spent;
+  // a budget of 0 is unlimited, except that one call never consumes more than 65535 bytes.
+  // Parsing resumes mid-sentence on the next call.
+  template <class Source>
+  GP02Drain encodeFor(Source &source, uint16_t maxBytes, uint16_t maxMicros = 0);
+
   GP02Location location;
   GP02Date date;
   GP02Time time;
@@ -213,23 +381,56 @@ public:
   GP02Altitude altitude;
   GP02Integer satellites;
   GP02HDOP hdop;
+#ifdef _GPS_EPOCHS
+  GP02Epoch epoch;
+
+  // collect RMC/GGA/GSA/GSV/VTG of one UTC epoch into a single GP02Fix;
+  // an epoch closes when the time changes or after the terminator sentence
+  void enableEpochs(uint8_t terminator = GP02Epoch::None);
+  void disableEpochs() { epoch.enabled = false; }
+#endif
+
+  // strict framing for noisy links: a sentence is dropped at the first invalid character,
+  // oversize term or byte beyond the NMEA length limit, or when it ends without a two digit
+  // checksum; bytes outside sentences are skipped until the next '$'
+  void enableStrictFraming()  { strictFraming = true; inSentence = false; }
+  void disableStrictFraming() { strictFraming = false; }
 
   static const char *libraryVersion() { return _GPS_VERSION; }
 
+  // instrumentation: the handler runs at '$', when the sentence type is known, and when the
+  // checksum passes (after everything is committed) or fails. Under strict framing a dropped
+  // sentence also fails, so every start ends in exactly one commit or failure. The handler
+  // takes its own timestamp; charsProcessed() tells which byte of the stream raised the event.
+  enum TraceEvent { TraceStart, TraceType, TraceCommit, TraceFail };
+  void onTrace(GP02TraceHandler handler, void *context) { traceHandler = handler; traceContext = context; }
+
+  // UTC from the last committed date and time, as Unix seconds / milliseconds
+  uint32_t unixTime()         { return date.unixTime() + time.millisOfDay() / 1000; }
+  uint64_t unixMillis()       { return (uint64_t)date.unixTime() * 1000 + time.millisOfDay(); }
+
   static double distanceBetween(double lat1, double long1, double lat2, double long2);
   static double courseTo(double lat1, double long1, double lat2, double long2);
   static const char *cardinal(double course);
 
   static int32_t parseDecimal(const char *term);
   static void parseDegrees(const char *term, RawDegrees &deg);
+  static void copyTerm(char *dest, const char *term, size_t size);
 
   uint32_t charsProcessed()   const { return encodedCharCount; }
   uint32_t sentencesWithFix() const { return sentencesWithFixCount; }
   uint32_t failedChecksum()   const { return failedChecksumCount; }
   uint32_t passedChecksum()   const { return passedChecksumCount; }
 
+  // sentences discarded by strict framing, by cause
+  uint32_t invalidCharacters()  const { return invalidCharCount; }
+  uint32_t oversizeTerms()      const { return oversizeTermCount; }
+  uint32_t oversizeSentences()  const { return oversizeSentenceCount; }
+  uint32_t truncatedSentences() const { return truncatedSentenceCount; }
+  uint32_t framingErrors()      const { return invalidCharCount + oversizeTermCount + oversizeSentenceCount + truncatedSentenceCount; }
+
 private:
-  enum {GPS_SENTENCE_GGA, GPS_SENTENCE_RMC, GPS_SENTENCE_OTHER};
+  enum {GPS_SENTENCE_GGA, GPS_SENTENCE_RMC, GPS_SENTENCE_GSA, GPS_SENTENCE_GSV, GPS_SENTENCE_VTG, GPS_SENTENCE_OTHER};
 
   // parsing state variables
   uint8_t parity;
@@ -240,21 +441,102 @@ private:
   uint8_t curTermOffset;
   bool sentenceHasFix;
 
+  // strict framing
+  bool strictFraming;
+  bool inSentence;
+  uint8_t sentenceLength;
+
   // custom element support
   friend class GP02Custom;
   GP02Custom *customElts;
   GP02Custom *customCandidates;
   void insertCustom(GP02Custom *pElt, const char *sentenceName, int index);
 
+  // instrumentation
+  GP02TraceHandler traceHandler;
+  void *traceContext;
+  void trace(uint8_t event);
+
   // statistics
   uint32_t encodedCharCount;
   uint32_t sentencesWithFixCount;
   uint32_t failedChecksumCount;
   uint32_t passedChecksumCount;
+  uint32_t invalidCharCount;
+  uint32_t oversizeTermCount;
+  uint32_t oversizeSentenceCount;
+  uint32_t truncatedSentenceCount;
 
   // internal utilities
   int fromHex(char a);
   bool endOfTermHandler();
+  bool frameCheck(char c);
+  bool abortSentence(uint32_t &counter);
+#ifdef _GPS_EPOCHS
+  void assembleEpoch();
+  void commitEpoch();
+#endif
 };
 
+/**
+ * @brief Encodes characters from a source until it runs dry or a byte or time budget is spent.
+ *
+ * The clock is read every _GPS_BUDGET_CHECK_INTERVAL bytes and after every completed sentence,
+ * so a call may overrun maxMicros by that many bytes of parsing. Benchmark.ino reports the
+ * worst-case cost of a single byte on the target, which is the figure to size the slack by.
+ *
+ * A call stops with ByteBudget after 65535 bytes even without a byte budget, so that the byte
+ * count in GP02Drain cannot wrap; the rest is left in the source for the next call. The
+ * sentence count cannot wrap before that, as every sentence takes at least a few bytes.
+ *
+ * @param source Anything with int available() and int read(), e.g. Serial or SoftwareSerial.
+ * @param maxBytes The most characters to consume, or 0 for no limit other than 65535.
+ * @param maxMicros The most microseconds to spend, or 0 for no limit.
+ * @return What was consumed, why the call stopped and how many bytes are still waiting.
+ */
+template <class Source>
+GP02Drain GP02::encodeFor(Source &source, uint16_t maxBytes, uint16_t maxMicros)
+{
+  GP02Drain d = { 0, 0, GP02Drain::Drained, 0, 0 };
+  unsigned long start = micros(), now = start;
+  uint8_t untilCheck = _GPS_BUDGET_CHECK_INTERVAL;
+
+  for (;;)
+  {
+    if (d.bytes == 0xFFFF || (maxBytes && d.bytes >= maxBytes))
+    {
+      d.stop = GP02Drain::ByteBudget;
+      break;
+    }
+    if (maxMicros && untilCheck == 0)
+    {
+      untilCheck = _GPS_BUDGET_CHECK_INTERVAL;
+      now = micros();
+      if (now - start >= maxMicros)
+      {
+        d.stop = GP02Drain::TimeBudget;
+        break;
+      }
+    }
+    if (source.available() <= 0)
+      break;
+    int c = source.read();
+    if (c < 0)
+      break;
+    ++d.bytes;
+    --untilCheck;
+    if (encode((char)c))
+    {
+      ++d.sentences;
+      untilCheck = 0; // completing a sentence is the most expensive byte
+    }
+  }
+
+  if (d.stop != GP02Drain::TimeBudget)
+    now = micros();
+  d.elapsed = now - start > 0xFFFFUL ? 0xFFFF : (uint16_t)(now - start);
+  d.backlog = source.available();
+  return d;
+}
+
 #endif // def(__GP02_h)
\ No newline at end of file
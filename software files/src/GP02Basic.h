@@ -0,0 +1,507 @@
+#ifndef GP02Basic_h
+#define GP02Basic_h
+
+/*
+GP02Basic - a feature-selectable variant of the GP02 parser for RAM-constrained targets.
+
+   GP02Basic<GP02Feature::Location, GP02Feature::Time> gps;
+
+Only the listed fields exist in the object, only their RMC/GGA terms are parsed, and the
+sentence types nobody needs are not even recognized. GP02Feature::Age adds the per-field
+lastCommitTime needed by age(), GP02Feature::Stats the character/checksum counters.
+
+GP02Basic is a separate, smaller parser, not a configuration of GP02. GP02Basic<All> commits
+the same RMC/GGA values as GP02 and its fields have the accessors of the GP02 fields listed
+below, but everything else of GP02 is missing:
+
+   - GP02Custom elements, epoch assembly (enableEpochs(), GP02::epoch) and onTrace()
+   - enableStrictFraming() and the framing error counters
+   - encode(data, length) and encodeFor(); feed it one character at a time
+   - _GPS_LAZY_DECODE, which it ignores: fields are always decoded as they are parsed
+   - GP02Time::millisOfDay(), GP02Date::unixTime() and daysSinceEpoch(), GP02::unixTime()
+     and unixMillis(); year(), month() and day() are computed on every call
+   - GSA, GSV and VTG sentences are not recognized
+   - libraryVersion() and the static helpers, which are called as GP02::distanceBetween() etc.
+
+The Benchmark example reports sizeof() for several configurations, and
+extras/bench/footprint.sh builds it once per configuration to tabulate flash usage.
+*/
+
+#include "GP02.h"
+#include <stdlib.h>
+#include <string.h>
+
+namespace GP02Feature
+{
+   struct Location {};
+   struct Date {};
+   struct Time {};
+   struct Speed {};
+   struct Course {};
+   struct Altitude {};
+   struct Satellites {};
+   struct HDOP {};
+   struct Age {};
+   struct Stats {};
+   struct All {};
+
+   enum
+   {
+      LocationBit = 0x001, DateBit = 0x002, TimeBit = 0x004, SpeedBit = 0x008, CourseBit = 0x010,
+      AltitudeBit = 0x020, SatellitesBit = 0x040, HDOPBit = 0x080, AgeBit = 0x100, StatsBit = 0x200,
+      AllBits = 0x3FF
+   };
+
+   template <typename F> struct Bit;
+   template <> struct Bit<Location>   { static const uint16_t value = LocationBit; };
+   template <> struct Bit<Date>       { static const uint16_t value = DateBit; };
+   template <> struct Bit<Time>       { static const uint16_t value = TimeBit; };
+   template <> struct Bit<Speed>      { static const uint16_t value = SpeedBit; };
+   template <> struct Bit<Course>     { static const uint16_t value = CourseBit; };
+   template <> struct Bit<Altitude>   { static const uint16_t value = AltitudeBit; };
+   template <> struct Bit<Satellites> { static const uint16_t value = SatellitesBit; };
+   template <> struct Bit<HDOP>       { static const uint16_t value = HDOPBit; };
+   template <> struct Bit<Age>        { static const uint16_t value = AgeBit; };
+   template <> struct Bit<Stats>      { static const uint16_t value = StatsBit; };
+   template <> struct Bit<All>        { static const uint16_t value = AllBits; };
+
+   template <typename... Fs> struct Mask { static const uint16_t value = 0; };
+   template <typename F, typename... Rest> struct Mask<F, Rest...>
+   { static const uint16_t value = Bit<F>::value | Mask<Rest...>::value; };
+}
+
+// lastCommitTime only exists when GP02Feature::Age is selected
+template <bool Age> struct GP02Stamp
+{
+   void stamp() {}
+   uint32_t since(bool) const { return (uint32_t)ULONG_MAX; }
+};
+
+template <> struct GP02Stamp<true>
+{
+   uint32_t lastCommitTime;
+   void stamp() { lastCommitTime = millis(); }
+   uint32_t since(bool valid) const { return valid ? millis() - lastCommitTime : (uint32_t)ULONG_MAX; }
+};
+
+// stand-in for a field that has been compiled out
+struct GP02Absent
+{
+   bool isValid() const    { return false; }
+   bool isUpdated() const  { return false; }
+   uint32_t age() const    { return (uint32_t)ULONG_MAX; }
+   void set(const char *) {}
+   void setLatitude(const char *) {}
+   void setLongitude(const char *) {}
+   void setSouth(bool) {}
+   void setWest(bool) {}
+   void setQuality(char) {}
+   void setMode(char) {}
+   void commit() {}
+};
+
+template <bool Age>
+struct GP02BasicLocation : GP02Stamp<Age>
+{
+   template <typename... F> friend class GP02Basic;
+public:
+   bool isValid() const    { return valid; }
+   bool isUpdated() const  { return updated; }
+   uint32_t age() const    { return this->since(valid); }
+   const RawDegrees &rawLat()     { updated = false; return rawLatData; }
+   const RawDegrees &rawLng()     { updated = false; return rawLngData; }
+   double lat()   { updated = false; double ret = rawLatData.deg + rawLatData.billionths / 1000000000.0; return rawLatData.negative ? -ret : ret; }
+   double lng()   { updated = false; double ret = rawLngData.deg + rawLngData.billionths / 1000000000.0; return rawLngData.negative ? -ret : ret; }
+   GP02Location::Quality FixQuality() { updated = false; return (GP02Location::Quality)fixQuality; }
+   GP02Location::Mode FixMode()       { updated = false; return (GP02Location::Mode)fixMode; }
+
+   GP02BasicLocation() : valid(false), updated(false), fixQuality(GP02Location::Invalid), fixMode(GP02Location::N)
+   {}
+
+private:
+   bool valid, updated;
+   char fixQuality, newFixQuality, fixMode, newFixMode;
+   RawDegrees rawLatData, rawLngData, rawNewLatData, rawNewLngData;
+   void setLatitude(const char *term)  { GP02::parseDegrees(term, rawNewLatData); }
+   void setLongitude(const char *term) { GP02::parseDegrees(term, rawNewLngData); }
+   void setSouth(bool south)           { rawNewLatData.negative = south; }
+   void setWest(bool west)             { rawNewLngData.negative = west; }
+   void setQuality(char q)             { newFixQuality = q; }
+   void setMode(char m)                { newFixMode = m; }
+   void commit()
+   {
+      rawLatData = rawNewLatData;
+      rawLngData = rawNewLngData;
+      fixQuality = newFixQuality;
+      fixMode = newFixMode;
+      this->stamp();
+      valid = updated = true;
+   }
+};
+
+// common storage for the packed date/time and the fixed-point and integer fields
+template <typename T, bool Age>
+struct GP02BasicValue : GP02Stamp<Age>
+{
+   template <typename... F> friend class GP02Basic;
+public:
+   bool isValid() const    { return valid; }
+   bool isUpdated() const  { return updated; }
+   uint32_t age() const    { return this->since(valid); }
+   T value()               { updated = false; return val; }
+
+   GP02BasicValue() : valid(false), updated(false), val(0)
+   {}
+
+protected:
+   bool valid, updated;
+   T val, newval;
+   void commit() { val = newval; this->stamp(); valid = updated = true; }
+};
+
+template <bool Age>
+struct GP02BasicDate : GP02BasicValue<uint32_t, Age>
+{
+   template <typename... F> friend class GP02Basic;
+   uint16_t year()  { uint16_t y; uint8_t m, d; GP02Date::civilFromPacked(this->value(), y, m, d); return y; }
+   uint8_t month()  { uint16_t y; uint8_t m, d; GP02Date::civilFromPacked(this->value(), y, m, d); return m; }
+   uint8_t day()    { uint16_t y; uint8_t m, d; GP02Date::civilFromPacked(this->value(), y, m, d); return d; }
+private:
+   void set(const char *term) { this->newval = atol(term); }
+};
+
+template <bool Age>
+struct GP02BasicTime : GP02BasicValue<uint32_t, Age>
+{
+   template <typename... F> friend class GP02Basic;
+   uint8_t hour()        { return this->value() / 1000000; }
+   uint8_t minute()      { return (this->value() / 10000) % 100; }
+   uint8_t second()      { return (this->value() / 100) % 100; }
+   uint8_t centisecond() { return this->value() % 100; }
+private:
+   void set(const char *term) { this->newval = (uint32_t)GP02::parseDecimal(term); }
+};
+
+template <bool Age>
+struct GP02BasicDecimal : GP02BasicValue<int32_t, Age>
+{
+   template <typename... F> friend class GP02Basic;
+private:
+   void set(const char *term) { this->newval = GP02::parseDecimal(term); }
+};
+
+template <bool Age>
+struct GP02BasicInteger : GP02BasicValue<uint32_t, Age>
+{
+   template <typename... F> friend class GP02Basic;
+private:
+   void set(const char *term) { this->newval = atol(term); }
+};
+
+template <bool Age>
+struct GP02BasicSpeed : GP02BasicDecimal<Age>
+{
+   double knots()    { return this->value() / 100.0; }
+   double mph()      { return _GPS_MPH_PER_KNOT * this->value() / 100.0; }
+   double mps()      { return _GPS_MPS_PER_KNOT * this->value() / 100.0; }
+   double kmph()     { return _GPS_KMPH_PER_KNOT * this->value() / 100.0; }
+};
+
+template <bool Age>
+struct GP02BasicCourse : GP02BasicDecimal<Age>
+{
+   double deg()      { return this->value() / 100.0; }
+};
+
+template <bool Age>
+struct GP02BasicAltitude : GP02BasicDecimal<Age>
+{
+   double meters()       { return this->value() / 100.0; }
+   double miles()        { return _GPS_MILES_PER_METER * this->value() / 100.0; }
+   double kilometers()   { return _GPS_KM_PER_METER * this->value() / 100.0; }
+   double feet()         { return _GPS_FEET_PER_METER * this->value() / 100.0; }
+};
+
+template <bool Age>
+struct GP02BasicHDOP : GP02BasicDecimal<Age>
+{
+   double hdop() { return this->value() / 100.0; }
+};
+
+// statistics counters only exist when GP02Feature::Stats is selected
+template <bool Stats> struct GP02BasicStats
+{
+   uint32_t charsProcessed()   const { return 0; }
+   uint32_t sentencesWithFix() const { return 0; }
+   uint32_t failedChecksum()   const { return 0; }
+   uint32_t passedChecksum()   const { return 0; }
+protected:
+   void countChar() {}
+   void countFix() {}
+   void countFailed() {}
+   void countPassed() {}
+};
+
+template <> struct GP02BasicStats<true>
+{
+   GP02BasicStats() : encodedCharCount(0), sentencesWithFixCount(0), failedChecksumCount(0), passedChecksumCount(0) {}
+   uint32_t charsProcessed()   const { return encodedCharCount; }
+   uint32_t sentencesWithFix() const { return sentencesWithFixCount; }
+   uint32_t failedChecksum()   const { return failedChecksumCount; }
+   uint32_t passedChecksum()   const { return passedChecksumCount; }
+protected:
+   void countChar()   { ++encodedCharCount; }
+   void countFix()    { ++sentencesWithFixCount; }
+   void countFailed() { ++failedChecksumCount; }
+   void countPassed() { ++passedChecksumCount; }
+private:
+   uint32_t encodedCharCount;
+   uint32_t sentencesWithFixCount;
+   uint32_t failedChecksumCount;
+   uint32_t passedChecksumCount;
+};
+
+template <bool B, typename T> struct GP02Select { typedef T type; };
+template <typename T> struct GP02Select<false, T> { typedef GP02Absent type; };
+
+template <typename... Features>
+class GP02Basic : public GP02BasicStats<(GP02Feature::Mask<Features...>::value & GP02Feature::StatsBit) != 0>
+{
+public:
+  static const uint16_t features = GP02Feature::Mask<Features...>::value;
+  static const bool hasAge = (features & GP02Feature::AgeBit) != 0;
+  static const bool needRMC = (features & (GP02Feature::LocationBit | GP02Feature::DateBit | GP02Feature::TimeBit | GP02Feature::SpeedBit | GP02Feature::CourseBit)) != 0;
+  static const bool needGGA = (features & (GP02Feature::LocationBit | GP02Feature::TimeBit | GP02Feature::AltitudeBit | GP02Feature::SatellitesBit | GP02Feature::HDOPBit)) != 0;
+
+  static bool has(uint16_t bits) { return (features & bits) == bits; }
+
+  GP02Basic()
+    :  parity(0)
+    ,  isChecksumTerm(false)
+    ,  curSentenceType(GPS_SENTENCE_OTHER)
+    ,  curTermNumber(0)
+    ,  curTermOffset(0)
+    ,  sentenceHasFix(false)
+  {
+    term[0] = '\0';
+  }
+
+  bool encode(char c);
+  GP02Basic &operator << (char c) { encode(c); return *this; }
+
+  typename GP02Select<(features & GP02Feature::LocationBit) != 0, GP02BasicLocation<hasAge> >::type location;
+  typename GP02Select<(features & GP02Feature::DateBit) != 0, GP02BasicDate<hasAge> >::type date;
+  typename GP02Select<(features & GP02Feature::TimeBit) != 0, GP02BasicTime<hasAge> >::type time;
+  typename GP02Select<(features & GP02Feature::SpeedBit) != 0, GP02BasicSpeed<hasAge> >::type speed;
+  typename GP02Select<(features & GP02Feature::CourseBit) != 0, GP02BasicCourse<hasAge> >::type course;
+  typename GP02Select<(features & GP02Feature::AltitudeBit) != 0, GP02BasicAltitude<hasAge> >::type altitude;
+  typename GP02Select<(features & GP02Feature::SatellitesBit) != 0, GP02BasicInteger<hasAge> >::type satellites;
+  typename GP02Select<(features & GP02Feature::HDOPBit) != 0, GP02BasicHDOP<hasAge> >::type hdop;
+
+private:
+  enum {GPS_SENTENCE_GGA, GPS_SENTENCE_RMC, GPS_SENTENCE_OTHER};
+
+  // parsing state variables
+  uint8_t parity;
+  bool isChecksumTerm;
+  char term[_GPS_MAX_FIELD_SIZE];
+  uint8_t curSentenceType;
+  uint8_t curTermNumber;
+  uint8_t curTermOffset;
+  bool sentenceHasFix;
+
+  static int fromHex(char a)
+  {
+    if (a >= 'A' && a <= 'F')
+      return a - 'A' + 10;
+    else if (a >= 'a' && a <= 'f')
+      return a - 'a' + 10;
+    else
+      return a - '0';
+  }
+
+  bool endOfTermHandler();
+};
+
+/**
+ * @brief Encodes a character for processing GPS data.
+ *
+ * Identical in behaviour to GP02::encode() for the fields selected in the configuration.
+ *
+ * @param c The character to be encoded.
+ * @return A boolean value indicating if a valid sentence has been processed.
+ */
+template <typename... Features>
+bool GP02Basic<Features...>::encode(char c)
+{
+  this->countChar();
+
+  switch(c)
+  {
+  case ',': // term terminators
+    parity ^= (uint8_t)c;
+    // fall through
+  case '\r':
+  case '\n':
+  case '*':
+    {
+      bool isValidSentence = false;
+      if (curTermOffset < sizeof(term))
+      {
+        term[curTermOffset] = 0;
+        isValidSentence = endOfTermHandler();
+      }
+      ++curTermNumber;
+      curTermOffset = 0;
+      isChecksumTerm = c == '*';
+      return isValidSentence;
+    }
+
+  case '$': // sentence begin
+    curTermNumber = curTermOffset = 0;
+    parity = 0;
+    curSentenceType = GPS_SENTENCE_OTHER;
+    isChecksumTerm = false;
+    sentenceHasFix = false;
+    return false;
+
+  default: // ordinary characters
+    if (curTermOffset < sizeof(term) - 1)
+      term[curTermOffset++] = c;
+    if (!isChecksumTerm)
+      parity ^= c;
+    return false;
+  }
+}
+
+#define GP02_BASIC_COMBINE(sentence_type, term_number) (((unsigned)(sentence_type) << 5) | term_number)
+
+/**
+ * @brief Handles the end of a term for the fields selected in the configuration.
+ *
+ * The conditions on the feature mask are compile-time constants, so the cases of fields
+ * that are not selected are removed by the compiler together with their parsing helpers.
+ *
+ * @return Returns true if the checksum is valid and the data is committed; otherwise, returns false.
+ */
+template <typename... Features>
+bool GP02Basic<Features...>::endOfTermHandler()
+{
+  if (isChecksumTerm)
+  {
+    byte checksum = 16 * fromHex(term[0]) + fromHex(term[1]);
+    if (checksum != parity)
+    {
+      this->countFailed();
+      return false;
+    }
+
+    this->countPassed();
+    if (sentenceHasFix)
+      this->countFix();
+
+    if (curSentenceType == GPS_SENTENCE_RMC)
+    {
+      date.commit();
+      time.commit();
+      if (sentenceHasFix)
+      {
+        location.commit();
+        speed.commit();
+        course.commit();
+      }
+    }
+    else if (curSentenceType == GPS_SENTENCE_GGA)
+    {
+      time.commit();
+      if (sentenceHasFix)
+      {
+        location.commit();
+        altitude.commit();
+      }
+      satellites.commit();
+      hdop.commit();
+    }
+    return true;
+  }
+
+  if (curTermNumber == 0)
+  {
+    bool knownTalker = (term[0] == 'G' && term[1] && strchr("PNABL", term[1]) != NULL) || (term[0] == 'B' && term[1] == 'D');
+    if (needRMC && knownTalker && !strcmp(term + 2, "RMC"))
+      curSentenceType = GPS_SENTENCE_RMC;
+    else if (needGGA && knownTalker && !strcmp(term + 2, "GGA"))
+      curSentenceType = GPS_SENTENCE_GGA;
+    else
+      curSentenceType = GPS_SENTENCE_OTHER;
+    return false;
+  }
+
+  if (curSentenceType != GPS_SENTENCE_OTHER && term[0])
+    switch(GP02_BASIC_COMBINE(curSentenceType, curTermNumber))
+  {
+    case GP02_BASIC_COMBINE(GPS_SENTENCE_RMC, 1): // Time in both sentences
+    case GP02_BASIC_COMBINE(GPS_SENTENCE_GGA, 1):
+      if (has(GP02Feature::TimeBit))
+        time.set(term);
+      break;
+    case GP02_BASIC_COMBINE(GPS_SENTENCE_RMC, 2): // RMC validity
+      sentenceHasFix = term[0] == 'A';
+      break;
+    case GP02_BASIC_COMBINE(GPS_SENTENCE_RMC, 3): // Latitude
+    case GP02_BASIC_COMBINE(GPS_SENTENCE_GGA, 2):
+      if (has(GP02Feature::LocationBit))
+        location.setLatitude(term);
+      break;
+    case GP02_BASIC_COMBINE(GPS_SENTENCE_RMC, 4): // N/S
+    case GP02_BASIC_COMBINE(GPS_SENTENCE_GGA, 3):
+      location.setSouth(term[0] == 'S');
+      break;
+    case GP02_BASIC_COMBINE(GPS_SENTENCE_RMC, 5): // Longitude
+    case GP02_BASIC_COMBINE(GPS_SENTENCE_GGA, 4):
+      if (has(GP02Feature::LocationBit))
+        location.setLongitude(term);
+      break;
+    case GP02_BASIC_COMBINE(GPS_SENTENCE_RMC, 6): // E/W
+    case GP02_BASIC_COMBINE(GPS_SENTENCE_GGA, 5):
+      location.setWest(term[0] == 'W');
+      break;
+    case GP02_BASIC_COMBINE(GPS_SENTENCE_RMC, 7): // Speed (RMC)
+      if (has(GP02Feature::SpeedBit))
+        speed.set(term);
+      break;
+    case GP02_BASIC_COMBINE(GPS_SENTENCE_RMC, 8): // Course (RMC)
+      if (has(GP02Feature::CourseBit))
+        course.set(term);
+      break;
+    case GP02_BASIC_COMBINE(GPS_SENTENCE_RMC, 9): // Date (RMC)
+      if (has(GP02Feature::DateBit))
+        date.set(term);
+      break;
+    case GP02_BASIC_COMBINE(GPS_SENTENCE_GGA, 6): // Fix data (GGA)
+      sentenceHasFix = term[0] > '0';
+      location.setQuality(term[0]);
+      break;
+    case GP02_BASIC_COMBINE(GPS_SENTENCE_GGA, 7): // Satellites used (GGA)
+      if (has(GP02Feature::SatellitesBit))
+        satellites.set(term);
+      break;
+    case GP02_BASIC_COMBINE(GPS_SENTENCE_GGA, 8): // HDOP
+      if (has(GP02Feature::HDOPBit))
+        hdop.set(term);
+      break;
+    case GP02_BASIC_COMBINE(GPS_SENTENCE_GGA, 9): // Altitude (GGA)
+      if (has(GP02Feature::AltitudeBit))
+        altitude.set(term);
+      break;
+    case GP02_BASIC_COMBINE(GPS_SENTENCE_RMC, 12):
+      location.setMode(term[0]);
+      break;
+  }
+
+  return false;
+}
+
+#undef GP02_BASIC_COMBINE
+
+#endif // def(GP02Basic_h)
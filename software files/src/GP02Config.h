@@ -0,0 +1,45 @@
+#ifndef GP02Config_h
+#define GP02Config_h
+
+/*
+GP02Config - build switches that change the layout of the GP02 classes.
+
+The sketch and the library's .cpp files must be compiled with the same switches, or they
+disagree about the size and members of GP02 and its fields. Either uncomment the switches
+below, which every translation unit sees, or pass them to the whole build, e.g. with
+--build-property "compiler.cpp.extra_flags=-D_GPS_EPOCHS" for arduino-cli. A #define in the
+sketch before #include "GP02.h" does not reach the library and is not enough.
+
+A mismatch is caught when linking: GP02's constructor takes a tag type named after the
+switches, so a sketch built with other switches than the library refers to a constructor,
+e.g. GP02::GP02(GP02ConfigEpochs), that the library does not define.
+*/
+
+// Compiles in GP02::epoch, which collects the sentences of one receiver epoch into a single
+// GP02Fix (see GP02::enableEpochs()). It costs two GP02Fix records and the staging values,
+// about 170 bytes of RAM on AVR, so sketches that only read the individual fields do not pay
+// for it. GP02Fusion, GP02Trip and the host tools need it; the host Arduino.h stand-in
+// defines it.
+// #define _GPS_EPOCHS
+
+// Keeps the validated text of the location, speed, course, altitude, HDOP and satellite
+// fields and decodes it only when it is first read after a commit. Sketches that read few
+// fields then skip most of the per-sentence parsing, at the cost of about 200 bytes of RAM
+// for the staged and committed text.
+// #define _GPS_LAZY_DECODE
+
+#if defined(_GPS_EPOCHS) && defined(_GPS_LAZY_DECODE)
+struct GP02ConfigEpochsLazyDecode {};
+typedef GP02ConfigEpochsLazyDecode GP02ConfigTag;
+#elif defined(_GPS_EPOCHS)
+struct GP02ConfigEpochs {};
+typedef GP02ConfigEpochs GP02ConfigTag;
+#elif defined(_GPS_LAZY_DECODE)
+struct GP02ConfigLazyDecode {};
+typedef GP02ConfigLazyDecode GP02ConfigTag;
+#else
+struct GP02ConfigDefault {};
+typedef GP02ConfigDefault GP02ConfigTag;
+#endif
+
+#endif // def(GP02Config_h)
@@ -0,0 +1,592 @@
+/*
+GP02Format - allocation-free, integer-only formatters for GP02 fixes.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+*/
+
+#include "GP02Format.h"
+
+static const uint32_t powersOfTen[] = { 1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL,
+   1000000UL, 10000000UL, 100000000UL, 1000000000UL };
+
+namespace
+{
+
+// Appends to a bounded buffer; text records keep one byte for the terminating NUL.
+class GP02Writer
+{
+public:
+   GP02Writer(char *buf, size_t size, bool terminate)
+      : out(buf), capacity(size), limit(terminate && size ? size - 1 : size), len(0), full(false), nul(terminate)
+   {}
+
+   void put(char c)
+   {
+      if (len < limit)
+         out[len++] = c;
+      else
+         full = true;
+   }
+
+   void str(const char *s)
+   {
+      while (*s)
+         put(*s++);
+   }
+
+   void digits(uint32_t v, uint8_t width)
+   {
+      char tmp[10];
+      uint8_t n = 0;
+      do
+      {
+         tmp[n++] = '0' + v % 10;
+         v /= 10;
+      } while (v != 0 || n < width);
+      while (n)
+         put(tmp[--n]);
+   }
+
+   void fixed(bool negative, uint32_t whole, uint32_t frac, uint8_t decimals)
+   {
+      if (negative && (whole || frac))
+         put('-');
+      digits(whole, 1);
+      if (decimals)
+      {
+         put('.');
+         digits(frac, decimals);
+      }
+   }
+
+   void coordinate(const RawDegrees &deg, uint8_t decimals)
+   {
+      if (decimals > 9)
+         decimals = 9;
+      uint32_t divisor = powersOfTen[9 - decimals];
+      uint32_t frac = (deg.billionths + divisor / 2) / divisor;
+      uint32_t whole = deg.deg;
+      if (frac >= powersOfTen[decimals])
+      {
+         ++whole;
+         frac -= powersOfTen[decimals];
+      }
+      fixed(deg.negative, whole, frac, decimals);
+   }
+
+   void hundredths(int32_t v)
+   {
+      uint32_t magnitude = v < 0 ? 0UL - (uint32_t)v : (uint32_t)v;
+      fixed(v < 0, magnitude / 100, magnitude % 100, 2);
+   }
+
+   void date(uint32_t ddmmyy)
+   {
+      uint16_t y;
+      uint8_t m, d;
+      GP02Date::civilFromPacked(ddmmyy, y, m, d);
+      digits(y, 4);
+      put('-');
+      digits(m, 2);
+      put('-');
+      digits(d, 2);
+   }
+
+   void time(uint32_t hhmmsscc)
+   {
+      digits(hhmmsscc / 1000000, 2);
+      put(':');
+      digits((hhmmsscc / 10000) % 100, 2);
+      put(':');
+      digits((hhmmsscc / 100) % 100, 2);
+      put('.');
+      digits(hhmmsscc % 100, 2);
+   }
+
+   // CBOR initial byte plus argument (RFC 8949 section 3)
+   void head(uint8_t major, uint32_t v)
+   {
+      major <<= 5;
+      if (v < 24)
+         put(major | v);
+      else if (v < 0x100)
+      {
+         put(major | 24);
+         put(v);
+      }
+      else if (v < 0x10000)
+      {
+         put(major | 25);
+         put(v >> 8);
+         put(v);
+      }
+      else
+      {
+         put(major | 26);
+         put(v >> 24);
+         put(v >> 16);
+         put(v >> 8);
+         put(v);
+      }
+   }
+
+   void cborUnsigned64(uint64_t v)
+   {
+      if (v <= 0xFFFFFFFFUL)
+      {
+         head(0, (uint32_t)v);
+         return;
+      }
+      put(0x1B);
+      for (int8_t shift = 56; shift >= 0; shift -= 8)
+         put((uint8_t)(v >> shift));
+   }
+
+   void cborInteger(bool negative, uint32_t magnitude)
+   {
+      if (negative && magnitude)
+         head(1, magnitude - 1);
+      else
+         head(0, magnitude);
+   }
+
+   void cborKey(const char *key)
+   {
+      uint8_t n = 0;
+      while (key[n])
+         ++n;
+      head(3, n);
+      str(key);
+   }
+
+   // decimal fraction: tag 4 [exponent, mantissa]
+   void cborDecimal(const char *key, bool negative, uint32_t mantissa, uint8_t decimals)
+   {
+      cborKey(key);
+      head(6, 4);
+      head(4, 2);
+      head(1, decimals - 1);
+      cborInteger(negative, mantissa);
+   }
+
+   void cborDegrees(const char *key, const RawDegrees &deg)
+   {
+      uint32_t divisor = powersOfTen[9 - _GPS_FORMAT_DECIMALS];
+      uint32_t mantissa = deg.deg * powersOfTen[_GPS_FORMAT_DECIMALS] + (deg.billionths + divisor / 2) / divisor;
+      cborDecimal(key, deg.negative, mantissa, _GPS_FORMAT_DECIMALS);
+   }
+
+   void cborHundredths(const char *key, int32_t v)
+   {
+      cborDecimal(key, v < 0, v < 0 ? 0UL - (uint32_t)v : (uint32_t)v, 2);
+   }
+
+   void cborUnsigned(const char *key, uint32_t v)
+   {
+      cborKey(key);
+      head(0, v);
+   }
+
+   size_t finish()
+   {
+      if (full)
+         len = 0;
+      if (nul && capacity)
+         out[len] = '\0';
+      return len;
+   }
+
+private:
+   char *out;
+   size_t capacity, limit, len;
+   bool full, nul;
+};
+
+}
+
+/**
+ * @brief Formats a fix as a human-readable line.
+ *
+ * The line has the form "2026-10-18 12:00:00.00 41.0082000,28.9784000 alt 40.00 m 35.00 kn
+ * 0.00 deg 9 sats hdop 1.30"; parts whose fields are missing from the fix are left out.
+ *
+ * @param buf The destination buffer.
+ * @param size The size of buf in bytes.
+ * @param fix The fix to format.
+ * @return The length of the line, or 0 if it did not fit.
+ */
+size_t GP02Format::text(char *buf, size_t size, const GP02Fix &fix)
+{
+   GP02Writer w(buf, size, true);
+   const char *sep = "";
+   if (fix.has(GP02Fix::HasDate))
+   {
+      w.date(fix.date);
+      sep = " ";
+   }
+   if (fix.has(GP02Fix::HasTime))
+   {
+      w.str(sep);
+      w.time(fix.time);
+      sep = " ";
+   }
+   if (fix.has(GP02Fix::HasLocation))
+   {
+      w.str(sep);
+      w.coordinate(fix.lat, _GPS_FORMAT_DECIMALS);
+      w.put(',');
+      w.coordinate(fix.lng, _GPS_FORMAT_DECIMALS);
+      sep = " ";
+   }
+   if (fix.has(GP02Fix::HasAltitude))
+   {
+      w.str(sep);
+      w.str("alt ");
+      w.hundredths(fix.altitude);
+      w.str(" m");
+      sep = " ";
+   }
+   if (fix.has(GP02Fix::HasSpeed))
+   {
+      w.str(sep);
+      w.hundredths(fix.speed);
+      w.str(" kn");
+      sep = " ";
+   }
+   if (fix.has(GP02Fix::HasCourse))
+   {
+      w.str(sep);
+      w.hundredths(fix.course);
+      w.str(" deg");
+      sep = " ";
+   }
+   if (fix.has(GP02Fix::HasSatellites))
+   {
+      w.str(sep);
+      w.digits(fix.satellites, 1);
+      w.str(" sats");
+      sep = " ";
+   }
+   if (fix.has(GP02Fix::HasHDOP))
+   {
+      w.str(sep);
+      w.str("hdop ");
+      w.hundredths(fix.hdop);
+   }
+   return w.finish();
+}
+
+/**
+ * @brief Formats a fix as one CSV record with the columns of _GPS_CSV_HEADER.
+ *
+ * Date and time are ISO 8601, coordinates have _GPS_FORMAT_DECIMALS decimals and the other
+ * values two. Columns whose fields are missing from the fix are empty.
+ *
+ * @param buf The destination buffer.
+ * @param size The size of buf in bytes.
+ * @param fix The fix to format.
+ * @return The length of the record, or 0 if it did not fit.
+ */
+size_t GP02Format::csv(char *buf, size_t size, const GP02Fix &fix)
+{
+   GP02Writer w(buf, size, true);
+   if (fix.has(GP02Fix::HasDate))
+      w.date(fix.date);
+   w.put(',');
+   if (fix.has(GP02Fix::HasTime))
+      w.time(fix.time);
+   w.put(',');
+   if (fix.has(GP02Fix::HasLocation))
+   {
+      w.coordinate(fix.lat, _GPS_FORMAT_DECIMALS);
+      w.put(',');
+      w.coordinate(fix.lng, _GPS_FORMAT_DECIMALS);
+   }
+   else
+      w.put(',');
+   w.put(',');
+   if (fix.has(GP02Fix::HasSpeed))
+      w.hundredths(fix.speed);
+   w.put(',');
+   if (fix.has(GP02Fix::HasCourse))
+      w.hundredths(fix.course);
+   w.put(',');
+   if (fix.has(GP02Fix::HasAltitude))
+      w.hundredths(fix.altitude);
+   w.put(',');
+   if (fix.has(GP02Fix::HasSatellites))
+      w.digits(fix.satellites, 1);
+   w.put(',');
+   if (fix.has(GP02Fix::HasHDOP))
+      w.hundredths(fix.hdop);
+   w.put(',');
+   if (fix.has(GP02Fix::HasLocation))
+      w.put((char)fix.fixQuality);
+   return w.finish();
+}
+
+/**
+ * @brief Formats a fix as one JSON object.
+ *
+ * The object has the members "time" (ISO 8601, "Z" suffix when the date is known), "lat",
+ * "lng", "knots", "course", "alt", "sats", "hdop" and "quality"; members whose fields are
+ * missing from the fix are omitted.
+ *
+ * @param buf The destination buffer.
+ * @param size The size of buf in bytes.
+ * @param fix The fix to format.
+ * @return The length of the object, or 0 if it did not fit.
+ */
+size_t GP02Format::json(char *buf, size_t size, const GP02Fix &fix)
+{
+   GP02Writer w(buf, size, true);
+   char sep = '{';
+   if (fix.has(GP02Fix::HasDate) || fix.has(GP02Fix::HasTime))
+   {
+      w.put(sep);
+      w.str("\"time\":\"");
+      if (fix.has(GP02Fix::HasDate))
+         w.date(fix.date);
+      if (fix.has(GP02Fix::HasDate) && fix.has(GP02Fix::HasTime))
+         w.put('T');
+      if (fix.has(GP02Fix::HasTime))
+      {
+         w.time(fix.time);
+         if (fix.has(GP02Fix::HasDate))
+            w.put('Z');
+      }
+      w.put('"');
+      sep = ',';
+   }
+   if (fix.has(GP02Fix::HasLocation))
+   {
+      w.put(sep);
+      w.str("\"lat\":");
+      w.coordinate(fix.lat, _GPS_FORMAT_DECIMALS);
+      w.str(",\"lng\":");
+      w.coordinate(fix.lng, _GPS_FORMAT_DECIMALS);
+      w.str(",\"quality\":");
+      w.put((char)fix.fixQuality);
+      sep = ',';
+   }
+   if (fix.has(GP02Fix::HasSpeed))
+   {
+      w.put(sep);
+      w.str("\"knots\":");
+      w.hundredths(fix.speed);
+      sep = ',';
+   }
+   if (fix.has(GP02Fix::HasCourse))
+   {
+      w.put(sep);
+      w.str("\"course\":");
+      w.hundredths(fix.course);
+      sep = ',';
+   }
+   if (fix.has(GP02Fix::HasAltitude))
+   {
+      w.put(sep);
+      w.str("\"alt\":");
+      w.hundredths(fix.altitude);
+      sep = ',';
+   }
+   if (fix.has(GP02Fix::HasSatellites))
+   {
+      w.put(sep);
+      w.str("\"sats\":");
+      w.digits(fix.satellites, 1);
+      sep = ',';
+   }
+   if (fix.has(GP02Fix::HasHDOP))
+   {
+      w.put(sep);
+      w.str("\"hdop\":");
+      w.hundredths(fix.hdop);
+      sep = ',';
+   }
+   if (sep == '{')
+      w.put(sep);
+   w.put('}');
+   return w.finish();
+}
+
+/**
+ * @brief Encodes a fix as one CBOR map (RFC 8949).
+ *
+ * Keys are the JSON member names. "ms" holds Unix milliseconds when both date and time are
+ * known, otherwise "time" holds hhmmsscc as an integer. Coordinates and hundredths are
+ * encoded as decimal fractions (tag 4), e.g. 41.0082 as 4([-7, 410082000]).
+ *
+ * @param buf The destination buffer.
+ * @param size The size of buf in bytes.
+ * @param fix The fix to encode.
+ * @return The number of bytes written, or 0 if the map did not fit.
+ */
+size_t GP02Format::cbor(uint8_t *buf, size_t size, const GP02Fix &fix)
+{
+   GP02Writer w((char *)buf, size, false);
+   uint8_t pairs = 0;
+   if (fix.has(GP02Fix::HasTime))
+      ++pairs;
+   if (fix.has(GP02Fix::HasLocation))
+      pairs += 3;
+   if (fix.has(GP02Fix::HasSpeed))
+      ++pairs;
+   if (fix.has(GP02Fix::HasCourse))
+      ++pairs;
+   if (fix.has(GP02Fix::HasAltitude))
+      ++pairs;
+   if (fix.has(GP02Fix::HasSatellites))
+      ++pairs;
+   if (fix.has(GP02Fix::HasHDOP))
+      ++pairs;
+   w.head(5, pairs);
+
+   if (fix.has(GP02Fix::HasDate) && fix.has(GP02Fix::HasTime))
+   {
+      w.cborKey("ms");
+      w.cborUnsigned64(fix.unixMillis);
+   }
+   else if (fix.has(GP02Fix::HasTime))
+      w.cborUnsigned("time", fix.time);
+   if (fix.has(GP02Fix::HasLocation))
+   {
+      w.cborDegrees("lat", fix.lat);
+      w.cborDegrees("lng", fix.lng);
+      w.cborUnsigned("quality", fix.fixQuality - '0');
+   }
+   if (fix.has(GP02Fix::HasSpeed))
+      w.cborHundredths("knots", fix.speed);
+   if (fix.has(GP02Fix::HasCourse))
+      w.cborHundredths("course", fix.course);
+   if (fix.has(GP02Fix::HasAltitude))
+      w.cborHundredths("alt", fix.altitude);
+   if (fix.has(GP02Fix::HasSatellites))
+      w.cborUnsigned("sats", fix.satellites);
+   if (fix.has(GP02Fix::HasHDOP))
+      w.cborHundredths("hdop", fix.hdop);
+   return w.finish();
+}
+
+/**
+ * @brief Formats a coordinate in decimal degrees, rounded to the given number of decimals.
+ *
+ * @param buf The destination buffer.
+ * @param size The size of buf in bytes.
+ * @param deg The coordinate, e.g. from GP02Location::rawLat().
+ * @param decimals The number of digits after the point (at most 9).
+ * @return The length of the string, or 0 if it did not fit.
+ */
+size_t GP02Format::coordinate(char *buf, size_t size, const RawDegrees &deg, uint8_t decimals)
+{
+   GP02Writer w(buf, size, true);
+   w.coordinate(deg, decimals);
+   return w.finish();
+}
+
+/**
+ * @brief Formats a GP02Decimal value (hundredths) with two decimals.
+ *
+ * @param buf The destination buffer.
+ * @param size The size of buf in bytes.
+ * @param value The value in hundredths, e.g. from GP02Speed::value().
+ * @return The length of the string, or 0 if it did not fit.
+ */
+size_t GP02Format::hundredths(char *buf, size_t size, int32_t value)
+{
+   GP02Writer w(buf, size, true);
+   w.hundredths(value);
+   return w.finish();
+}
+
+/**
+ * @brief Formats a packed NMEA date as an ISO 8601 date.
+ *
+ * @param buf The destination buffer.
+ * @param size The size of buf in bytes.
+ * @param ddmmyy The date as returned by GP02Date::value().
+ * @return The length of the string, or 0 if it did not fit.
+ */
+size_t GP02Format::date(char *buf, size_t size, uint32_t ddmmyy)
+{
+   GP02Writer w(buf, size, true);
+   w.date(ddmmyy);
+   return w.finish();
+}
+
+/**
+ * @brief Formats a packed NMEA time as hh:mm:ss.cc.
+ *
+ * @param buf The destination buffer.
+ * @param size The size of buf in bytes.
+ * @param hhmmsscc The time as returned by GP02Time::value().
+ * @return The length of the string, or 0 if it did not fit.
+ */
+size_t GP02Format::time(char *buf, size_t size, uint32_t hhmmsscc)
+{
+   GP02Writer w(buf, size, true);
+   w.time(hhmmsscc);
+   return w.finish();
+}
+
+/**
+ * @brief Fills a GP02Fix from the individual fields of a GP02 object.
+ *
+ * This is for sketches that do not use epochs. Only valid fields are copied; reading them
+ * clears their isUpdated() flags like the normal accessors do.
+ *
+ * @param gps The parser to read from.
+ * @param fix The record to fill.
+ */
+void GP02Format::capture(GP02 &gps, GP02Fix &fix)
+{
+   fix.clear();
+   if (gps.date.isValid())
+   {
+      fix.date = gps.date.value();
+      fix.fields |= GP02Fix::HasDate;
+   }
+   if (gps.time.isValid())
+   {
+      fix.time = gps.time.value();
+      fix.fields |= GP02Fix::HasTime;
+   }
+   if (fix.has(GP02Fix::HasDate) && fix.has(GP02Fix::HasTime))
+      fix.unixMillis = gps.unixMillis();
+   if (gps.location.isValid())
+   {
+      fix.lat = gps.location.rawLat();
+      fix.lng = gps.location.rawLng();
+      fix.fixQuality = gps.location.FixQuality();
+      fix.fixMode = gps.location.FixMode();
+      fix.fields |= GP02Fix::HasLocation;
+   }
+   if (gps.speed.isValid())
+   {
+      fix.speed = gps.speed.value();
+      fix.fields |= GP02Fix::HasSpeed;
+   }
+   if (gps.course.isValid())
+   {
+      fix.course = gps.course.value();
+      fix.fields |= GP02Fix::HasCourse;
+   }
+   if (gps.altitude.isValid())
+   {
+      fix.altitude = gps.altitude.value();
+      fix.fields |= GP02Fix::HasAltitude;
+   }
+   if (gps.satellites.isValid())
+   {
+      fix.satellites = gps.satellites.value();
+      fix.fields |= GP02Fix::HasSatellites;
+   }
+   if (gps.hdop.isValid())
+   {
+      fix.hdop = gps.hdop.value();
+      fix.fields |= GP02Fix::HasHDOP;
+   }
+}
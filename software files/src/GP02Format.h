@@ -0,0 +1,48 @@
+#ifndef GP02Format_h
+#define GP02Format_h
+
+/*
+GP02Format - allocation-free, integer-only formatters for GP02 fixes.
+
+Every formatter writes into a caller supplied buffer and works directly from RawDegrees and
+the hundredths held by GP02Decimal/GP02Fix, so neither floating point nor printf is linked:
+
+   char line[GP02_FORMAT_MAX];
+   if (GP02Format::csv(line, sizeof(line), gps.epoch.value()))
+     Serial.println(line);
+
+text(), csv() and json() write a NUL-terminated record without a line ending; cbor() writes
+an RFC 8949 map in which coordinates and hundredths are decimal fractions (tag 4), so the
+receiving side gets the exact values without any float on the target. All of them return
+the record length, or 0 (and an empty string) if the buffer is too small. Fields missing
+from the fix are left empty in CSV and omitted elsewhere.
+
+Without epochs (a library built without _GPS_EPOCHS, see GP02Config.h, or epochs not
+enabled), capture() fills a GP02Fix from the individual GP02 fields.
+*/
+
+#include "GP02.h"
+#include <stddef.h>
+
+#define _GPS_FORMAT_DECIMALS 7 // digits after the point for latitude/longitude (~1 cm)
+#define _GPS_CSV_HEADER "date,time,lat,lng,knots,course,altitude,satellites,hdop,quality"
+#define GP02_FORMAT_MAX 192 // large enough for any record produced by GP02Format
+
+class GP02Format
+{
+public:
+   static size_t text(char *buf, size_t size, const GP02Fix &fix);
+   static size_t csv(char *buf, size_t size, const GP02Fix &fix);
+   static size_t json(char *buf, size_t size, const GP02Fix &fix);
+   static size_t cbor(uint8_t *buf, size_t size, const GP02Fix &fix);
+
+   // single values, NUL-terminated
+   static size_t coordinate(char *buf, size_t size, const RawDegrees &deg, uint8_t decimals = _GPS_FORMAT_DECIMALS);
+   static size_t hundredths(char *buf, size_t size, int32_t value);   // 1234 -> "12.34"
+   static size_t date(char *buf, size_t size, uint32_t ddmmyy);        // "2026-10-18"
+   static size_t time(char *buf, size_t size, uint32_t hhmmsscc);      // "12:00:00.00"
+
+   static void capture(GP02 &gps, GP02Fix &fix);
+};
+
+#endif // def(GP02Format_h)
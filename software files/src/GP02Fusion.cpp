@@ -0,0 +1,428 @@
+/*
+GP02Fusion - combines the epochs of several GP-02 receivers on one vehicle into one fix.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+*/
+
+#include "GP02.h"
+
+// compiles to nothing unless the library is built with epochs, which GP02Fusion needs
+#ifdef _GPS_EPOCHS
+
+#include "GP02Fusion.h"
+
+#include <math.h>
+#include <string.h>
+
+#define _FUSION_MS_PER_DAY 86400000L
+#define _FUSION_NANO_HALF_TURN 180000000000LL // 180 degrees in nanodegrees
+#define _FUSION_METERS_PER_NANODEGREE (_GPS_EARTH_MEAN_RADIUS * PI / _FUSION_NANO_HALF_TURN)
+
+// how far UTC time of day a is ahead of b, folded into +-12 hours across midnight
+static int32_t offset(uint32_t a, uint32_t b)
+{
+   int32_t d = (int32_t)(a - b);
+   if (d > _FUSION_MS_PER_DAY / 2)
+      d -= _FUSION_MS_PER_DAY;
+   else if (d < -_FUSION_MS_PER_DAY / 2)
+      d += _FUSION_MS_PER_DAY;
+   return d;
+}
+
+static int64_t wrapLongitude(int64_t nano)
+{
+   if (nano > _FUSION_NANO_HALF_TURN)
+      nano -= 2 * _FUSION_NANO_HALF_TURN;
+   else if (nano <= -_FUSION_NANO_HALF_TURN)
+      nano += 2 * _FUSION_NANO_HALF_TURN;
+   return nano;
+}
+
+static uint8_t qualityFactor(GP02Location::Quality q)
+{
+   switch (q)
+   {
+   case GP02Location::GPS:       return 4;
+   case GP02Location::DGPS:
+   case GP02Location::PPS:       return 8;
+   case GP02Location::FloatRTK:  return 16;
+   case GP02Location::RTK:       return 64;
+   case GP02Location::Estimated: return 1;
+   default:                      return 0;
+   }
+}
+
+/**
+ * @brief Returns the number of receivers that contributed to the fused fix.
+ */
+uint8_t GP02FusedFix::contributors() const
+{
+   uint8_t n = 0;
+   for (uint8_t m = receivers; m; m &= m - 1)
+      ++n;
+   return n;
+}
+
+/**
+ * @brief Creates a fusion without receivers.
+ *
+ * @param policy Quality thresholds and epoch timing; see GP02FusionPolicy.
+ */
+GP02Fusion::GP02Fusion(const GP02FusionPolicy &policy)
+   : rules(policy)
+   , count(0)
+   , pending(0)
+   , openKey(0), closedKey(0)
+   , openedAt(0)
+   , closedAny(false)
+   , valid(false), updated(false)
+   , lastCommitTime(0)
+{
+   memset(&statistics, 0, sizeof(statistics));
+}
+
+/**
+ * @brief Adds a receiver. Its parser must have epochs enabled.
+ *
+ * The fusion reads the parser's GP02Epoch record, which clears its isUpdated() flag, so the
+ * sketch should read the receiver's epochs through the fusion only. A receiver is not waited
+ * for until it has delivered its first timed epoch.
+ *
+ * @param gps The parser fed from the receiver.
+ * @return The receiver's bit number in GP02FusedFix::receivers, or -1 if the fusion is full.
+ */
+int8_t GP02Fusion::add(GP02 &gps)
+{
+   if (count >= _GPS_FUSION_MAX_RECEIVERS)
+      return -1;
+   Receiver &r = slots[count];
+   r.gps = &gps;
+   r.fix.clear();
+   r.lastSeen = millis() - rules.staleMs - 1;
+   return (int8_t)count++;
+}
+
+/**
+ * @brief Collects new receiver epochs and fuses the open epoch when it is complete.
+ *
+ * Call it from loop() after feeding the parsers. Each call does work proportional to the
+ * number of receivers only.
+ *
+ * @return True if a fused fix was published by this call.
+ */
+bool GP02Fusion::update()
+{
+   uint32_t now = millis();
+   bool published = false;
+   for (uint8_t i = 0; i < count; ++i)
+      if (slots[i].gps->epoch.isUpdated() && accept(i, now))
+         published = true;
+
+   if (pending)
+   {
+      uint8_t expected = 0;
+      for (uint8_t i = 0; i < count; ++i)
+         if (now - slots[i].lastSeen <= rules.staleMs)
+            expected |= 1 << i;
+      if ((pending & expected) == expected || now - openedAt >= rules.waitMs)
+         published = close() || published;
+   }
+   return published;
+}
+
+// takes the new epoch of receiver i into the open epoch, fusing the open one first if the
+// new epoch is later
+bool GP02Fusion::accept(uint8_t i, uint32_t now)
+{
+   Receiver &r = slots[i];
+   const GP02Fix &fix = r.gps->epoch.value();
+   if (!fix.has(GP02Fix::HasTime))
+      return false;
+   r.lastSeen = now;
+
+   uint32_t key = GP02Time::millisFromPacked(fix.time);
+   bool published = false;
+   int32_t back = -(int32_t)rules.maxStepBackMs;
+   if ((closedAny && offset(key, closedKey) < back) || (pending && offset(key, openKey) < back))
+   {
+      // the clock stepped back; without a restart every epoch would be late for up to 12 hours
+      if (pending)
+         published = close();
+      closedAny = false;
+      ++statistics.resyncs;
+   }
+   if (closedAny && offset(key, closedKey) <= (int32_t)rules.windowMs)
+   {
+      ++statistics.late;
+      return false;
+   }
+   if (pending)
+   {
+      int32_t ahead = offset(key, openKey);
+      if (ahead < -(int32_t)rules.windowMs)
+      {
+         ++statistics.late;
+         return false;
+      }
+      if (ahead > (int32_t)rules.windowMs)
+         published = close();
+   }
+   if (!pending)
+   {
+      openKey = key;
+      openedAt = now;
+   }
+   r.fix = fix;
+   pending |= 1 << i;
+   return published;
+}
+
+/**
+ * @brief Computes how much a receiver's fix counts in the fused position.
+ *
+ * @param fix A receiver epoch.
+ * @param policy The thresholds a fix has to meet.
+ * @return The weight: quality factor * satellites used / HDOP squared, scaled to an integer;
+ * 0 if the fix lacks a location, HDOP or satellite count or fails the policy.
+ */
+uint32_t GP02Fusion::weight(const GP02Fix &fix, const GP02FusionPolicy &policy)
+{
+   if (!fix.has(GP02Fix::HasLocation) || !fix.has(GP02Fix::HasHDOP) || !fix.has(GP02Fix::HasSatellites))
+      return 0;
+   uint8_t q = qualityFactor(fix.fixQuality);
+   if (q == 0 || fix.hdop <= 0 || fix.hdop > (int32_t)policy.maxHdop || fix.satellites < policy.minSatellites)
+      return 0;
+   // below 0.5 HDOP no longer tracks the actual error, and 64 * 24 * 10^6 fits 32 bits
+   uint32_t h = fix.hdop < 50 ? 50 : (uint32_t)fix.hdop;
+   uint32_t sats = fix.satellites > 24 ? 24 : fix.satellites;
+   return q * sats * 1000000UL / (h * h);
+}
+
+/**
+ * @brief Converts raw degrees to signed nanodegrees.
+ */
+int64_t GP02Fusion::nanodegrees(const RawDegrees &deg)
+{
+   int64_t nano = (int64_t)deg.deg * 1000000000LL + deg.billionths;
+   return deg.negative ? -nano : nano;
+}
+
+/**
+ * @brief Converts signed nanodegrees to raw degrees.
+ */
+RawDegrees GP02Fusion::fromNanodegrees(int64_t nano)
+{
+   RawDegrees deg;
+   deg.negative = nano < 0;
+   if (deg.negative)
+      nano = -nano;
+   deg.deg = (uint16_t)(nano / 1000000000LL);
+   deg.billionths = (uint32_t)(nano % 1000000000LL);
+   return deg;
+}
+
+/**
+ * @brief Fuses the fixes of the open epoch and publishes the result.
+ *
+ * Positions are averaged as nanodegree offsets from the first usable fix. While two or more
+ * fixes remain and the farthest one is more than maxSpreadMeters from their weighted mean,
+ * it is rejected and the mean taken again, at most once per receiver. When only two remain,
+ * the one farther from the previous fused position is rejected instead, provided that
+ * position is younger than staleMs; without one, the lighter fix goes.
+ *
+ * @return False if no fix of the epoch was usable; the previous fused fix then stays current.
+ */
+bool GP02Fusion::close()
+{
+   uint8_t members = pending;
+   pending = 0;
+   closedKey = openKey;
+   closedAny = true;
+
+   uint32_t w[_GPS_FUSION_MAX_RECEIVERS];
+   uint8_t used = 0, first = 0;
+   for (uint8_t i = 0; i < count; ++i)
+   {
+      if (!(members & (1 << i)))
+         continue;
+      w[i] = weight(slots[i].fix, rules);
+      if (w[i] == 0)
+      {
+         ++statistics.unusable;
+         continue;
+      }
+      if (!used)
+         first = i;
+      used |= 1 << i;
+   }
+   if (!used)
+   {
+      ++statistics.empty;
+      return false;
+   }
+
+   int64_t refLat = nanodegrees(slots[first].fix.lat), refLng = nanodegrees(slots[first].fix.lng);
+   int64_t dLat[_GPS_FUSION_MAX_RECEIVERS], dLng[_GPS_FUSION_MAX_RECEIVERS];
+   for (uint8_t i = 0; i < count; ++i)
+      if (used & (1 << i))
+      {
+         dLat[i] = nanodegrees(slots[i].fix.lat) - refLat;
+         dLng[i] = wrapLongitude(nanodegrees(slots[i].fix.lng) - refLng);
+      }
+   double eastScale = cos(radians(refLat / 1e9));
+   // between two disagreeing fixes the mean cannot tell which is wrong, continuity can
+   bool hasPrevious = valid && millis() - lastCommitTime <= rules.staleMs;
+   int64_t prevLat = hasPrevious ? nanodegrees(record.lat) - refLat : 0;
+   int64_t prevLng = hasPrevious ? wrapLongitude(nanodegrees(record.lng) - refLng) : 0;
+
+   int64_t meanLat, meanLng;
+   double farthest;
+   for (;;)
+   {
+      int64_t sumLat = 0, sumLng = 0, sumW = 0;
+      uint8_t n = 0;
+      for (uint8_t i = 0; i < count; ++i)
+         if (used & (1 << i))
+         {
+            sumLat += (int64_t)w[i] * dLat[i];
+            sumLng += (int64_t)w[i] * dLng[i];
+            sumW += w[i];
+            ++n;
+         }
+      meanLat = sumLat / sumW;
+      meanLng = sumLng / sumW;
+
+      uint8_t worst = first;
+      farthest = 0;
+      for (uint8_t i = 0; i < count; ++i)
+         if (used & (1 << i))
+         {
+            double north = (dLat[i] - meanLat) * _FUSION_METERS_PER_NANODEGREE;
+            double east = (dLng[i] - meanLng) * _FUSION_METERS_PER_NANODEGREE * eastScale;
+            double d = sqrt(north * north + east * east);
+            if (d > farthest)
+            {
+               farthest = d;
+               worst = i;
+            }
+         }
+      if (rules.maxSpreadMeters == 0 || n < 2 || farthest <= rules.maxSpreadMeters)
+         break;
+      if (n == 2 && hasPrevious)
+      {
+         double jump = -1;
+         for (uint8_t i = 0; i < count; ++i)
+            if (used & (1 << i))
+            {
+               double north = (dLat[i] - prevLat) * _FUSION_METERS_PER_NANODEGREE;
+               double east = (dLng[i] - prevLng) * _FUSION_METERS_PER_NANODEGREE * eastScale;
+               double d = north * north + east * east;
+               if (d > jump)
+               {
+                  jump = d;
+                  worst = i;
+               }
+            }
+      }
+      used &= ~(1 << worst);
+      ++statistics.outliers;
+   }
+
+   GP02FusedFix &f = record;
+   f.clear();
+   f.receivers = used;
+   f.rejected = members & ~used;
+   f.spread = farthest * 10 > 65535 ? 65535 : (uint16_t)(farthest * 10 + 0.5);
+   f.lat = fromNanodegrees(refLat + meanLat);
+   f.lng = fromNanodegrees(wrapLongitude(refLng + meanLng));
+   f.fields = GP02Fix::HasTime | GP02Fix::HasLocation | GP02Fix::HasSatellites | GP02Fix::HasHDOP;
+
+   // velocity as a weighted north/east vector, so that courses either side of north average
+   double north = 0, east = 0, speedSum = 0, inverseHdop2 = 0;
+   int64_t altitudeSum = 0;
+   uint32_t velocityW = 0, speedW = 0, altitudeW = 0, best = 0;
+   uint8_t heaviest = first;
+   for (uint8_t i = 0; i < count; ++i)
+   {
+      if (!(used & (1 << i)))
+         continue;
+      const GP02Fix &fix = slots[i].fix;
+      if (w[i] > best)
+      {
+         best = w[i];
+         heaviest = i;
+      }
+      f.sentences |= fix.sentences;
+      if (fix.satellites > f.satellites)
+         f.satellites = fix.satellites;
+      if (fix.satellitesInView > f.satellitesInView)
+         f.satellitesInView = fix.satellitesInView;
+      inverseHdop2 += 1.0 / ((double)fix.hdop * fix.hdop);
+      if (fix.has(GP02Fix::HasAltitude))
+      {
+         altitudeSum += (int64_t)w[i] * fix.altitude;
+         altitudeW += w[i];
+      }
+      if (fix.has(GP02Fix::HasSpeed) && fix.has(GP02Fix::HasCourse))
+      {
+         double c = radians(fix.course / 100.0);
+         north += (double)w[i] * fix.speed * cos(c);
+         east += (double)w[i] * fix.speed * sin(c);
+         velocityW += w[i];
+      }
+      else if (fix.has(GP02Fix::HasSpeed))
+      {
+         speedSum += (double)w[i] * fix.speed;
+         speedW += w[i];
+      }
+   }
+
+   const GP02Fix &h = slots[heaviest].fix;
+   f.time = h.time;
+   if (h.has(GP02Fix::HasDate))
+   {
+      f.fields |= GP02Fix::HasDate;
+      f.date = h.date;
+      f.unixMillis = h.unixMillis;
+   }
+   f.fixQuality = h.fixQuality;
+   f.fixMode = h.fixMode;
+   if (h.has(GP02Fix::HasDOP))
+   {
+      f.fields |= GP02Fix::HasDOP;
+      f.fixType = h.fixType;
+      f.pdop = h.pdop;
+      f.vdop = h.vdop;
+   }
+   // the HDOP of an average of independent fixes
+   f.hdop = (int32_t)(1 / sqrt(inverseHdop2) + 0.5);
+   if (altitudeW)
+   {
+      f.fields |= GP02Fix::HasAltitude;
+      f.altitude = (int32_t)(altitudeSum / altitudeW);
+   }
+   if (velocityW)
+   {
+      f.fields |= GP02Fix::HasSpeed | GP02Fix::HasCourse;
+      f.speed = (int32_t)(sqrt(north * north + east * east) / velocityW + 0.5);
+      int32_t course = (int32_t)(atan2(east, north) * 18000 / PI + 0.5);
+      f.course = course < 0 ? course + 36000 : course >= 36000 ? course - 36000 : course;
+   }
+   else if (speedW)
+   {
+      f.fields |= GP02Fix::HasSpeed;
+      f.speed = (int32_t)(speedSum / speedW + 0.5);
+   }
+
+   valid = updated = true;
+   lastCommitTime = millis();
+   ++statistics.epochs;
+   if (f.contributors() > 1)
+      ++statistics.combined;
+   return true;
+}
+
+#endif // def(_GPS_EPOCHS)
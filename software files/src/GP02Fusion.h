@@ -0,0 +1,144 @@
+#ifndef GP02Fusion_h
+#define GP02Fusion_h
+
+/*
+GP02Fusion - combines the epochs of several GP-02 receivers on one vehicle into one fix.
+
+Each receiver has its own parser with epochs enabled; the fusion takes over their GP02Epoch
+records and is polled from loop() after feeding them:
+
+   GP02 bds, glonass;
+   GP02Fusion fusion;
+
+   void setup()
+   {
+     bds.enableEpochs(GP02Epoch::VTG);       // the last sentence of the receiver's epoch
+     glonass.enableEpochs(GP02Epoch::VTG);
+     fusion.add(bds);
+     fusion.add(glonass);
+   }
+
+   void loop()
+   {
+     while (Serial1.available()) bds.encode(Serial1.read());
+     while (Serial2.available()) glonass.encode(Serial2.read());
+     if (fusion.update()) { const GP02FusedFix &f = fusion.value(); ... }
+   }
+
+Epochs are aligned on their UTC time of day; fixes up to windowMs apart belong to the same
+epoch. An epoch is fused as soon as every receiver heard from within staleMs has delivered
+it, when a newer epoch starts, or waitMs after its first fix arrived, so a silent receiver
+delays the output by at most waitMs. Fixes for an epoch that has already been fused are
+dropped as late. A fix more than maxStepBackMs older than the last epoch is not late but a
+step of the receivers' clock (reacquisition, a clock set back): the open epoch is fused and
+the sequence restarts from that fix.
+
+A fix takes part when it has a location and a GGA quality other than Invalid, HDOP at most
+maxHdop and at least minSatellites used. Its weight is inverse to HDOP squared, the shape of
+the horizontal error variance, times the number of satellites used and a factor for the fix
+quality (differential and RTK fixes count more, dead reckoning less). The position is the
+weighted mean of fixed-point offsets from the first contributor, so no precision is lost to
+floats; velocity is averaged as a north/east vector, altitude as a scalar. With two or more
+contributors, the one farthest from the mean is rejected while it is more than
+maxSpreadMeters away. Of two receivers that disagree, the one that jumped farther from the
+previous fused position is dropped, or the lighter one if there is no recent fused position.
+
+Per epoch the cost is a fixed amount of work per receiver (_GPS_FUSION_MAX_RECEIVERS of
+them at most) plus a few trigonometric calls, independent of how long the fusion has run.
+*/
+
+#include "GP02.h"
+
+#ifndef _GPS_EPOCHS
+#error "GP02Fusion needs the library built with _GPS_EPOCHS (see GP02Config.h)"
+#endif
+
+#ifndef _GPS_FUSION_MAX_RECEIVERS
+#define _GPS_FUSION_MAX_RECEIVERS 4 // receivers per GP02Fusion, at most 8; each costs a GP02Fix of RAM
+#endif
+
+struct GP02FusionPolicy
+{
+   uint16_t maxHdop;             // hundredths
+   uint8_t minSatellites;
+   uint16_t windowMs;            // UTC difference still counted as the same epoch
+   uint16_t waitMs;              // longest wait for the other receivers after the first fix of an epoch
+   uint16_t staleMs;             // receivers silent this long are not waited for
+   uint16_t maxSpreadMeters;     // distance from the mean that rejects a fix; 0 keeps all
+   uint16_t maxStepBackMs;       // UTC steps further back restart the epoch sequence
+
+   GP02FusionPolicy()
+     : maxHdop(500), minSatellites(4), windowMs(50), waitMs(300), staleMs(2000), maxSpreadMeters(50)
+     , maxStepBackMs(2000)
+   {}
+};
+
+// the fused epoch; GP02Fix fields hold the combined solution
+struct GP02FusedFix : GP02Fix
+{
+   uint8_t receivers;            // bit i: receiver i contributed
+   uint8_t rejected;             // bit i: receiver i delivered this epoch but was left out
+   uint16_t spread;              // decimeters from the fused position to the farthest contributor
+
+   uint8_t contributors() const;
+
+   GP02FusedFix() : receivers(0), rejected(0), spread(0) {}
+};
+
+struct GP02FusionStats
+{
+   uint32_t epochs;              // epochs fused
+   uint32_t combined;            // ... from two or more receivers
+   uint32_t empty;               // ... with no usable fix; not published
+   uint32_t late;                // fixes dropped because their epoch was already fused
+   uint32_t unusable;            // fixes below the policy's quality
+   uint32_t outliers;            // fixes rejected by maxSpreadMeters
+   uint32_t resyncs;             // UTC steps back beyond maxStepBackMs
+};
+
+class GP02Fusion
+{
+public:
+   GP02Fusion(const GP02FusionPolicy &policy = GP02FusionPolicy());
+
+   int8_t add(GP02 &gps);
+   bool update();
+
+   bool isValid() const                  { return valid; }
+   bool isUpdated() const                { return updated; }
+   uint32_t age() const                  { return valid ? millis() - lastCommitTime : (uint32_t)ULONG_MAX; }
+   const GP02FusedFix &value()           { updated = false; return record; }
+
+   uint8_t receivers() const             { return count; }
+   const GP02FusionStats &stats() const  { return statistics; }
+   GP02FusionPolicy &policy()            { return rules; }
+
+   static uint32_t weight(const GP02Fix &fix, const GP02FusionPolicy &policy);
+   static int64_t nanodegrees(const RawDegrees &deg);
+   static RawDegrees fromNanodegrees(int64_t nano);
+
+private:
+   struct Receiver
+   {
+      GP02 *gps;
+      GP02Fix fix;
+      uint32_t lastSeen;
+   };
+
+   GP02FusionPolicy rules;
+   GP02FusionStats statistics;
+   Receiver slots[_GPS_FUSION_MAX_RECEIVERS];
+   uint8_t count;
+   uint8_t pending;              // bit per receiver holding a fix of the open epoch
+   uint32_t openKey, closedKey;  // milliseconds of the UTC day
+   uint32_t openedAt;
+   bool closedAny;
+   GP02FusedFix record;
+   bool valid, updated;
+   uint32_t lastCommitTime;
+
+   bool accept(uint8_t i, uint32_t now);
+   bool close();
+};
+
+#endif // def(GP02Fusion_h)
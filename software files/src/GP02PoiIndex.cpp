@@ -0,0 +1,308 @@
+/*
+GP02PoiIndex - nearest point-of-interest lookup over a static, pre-built k-d tree.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+*/
+
+#include "GP02PoiIndex.h"
+
+// State shared by the recursive searches. nearest() orders its results by GP02Poi::chord2
+// and converts them to meters once the result set is final.
+struct GP02PoiIndex::Query
+{
+   int64_t v[3];
+   uint64_t limit;               // squared chord of the search radius
+   GP02Poi *out;
+   size_t capacity, found, total;
+};
+
+static int64_t component(const GP02PoiPoint &p, uint8_t axis)
+{
+   return axis == 0 ? p.x : axis == 1 ? p.y : p.z;
+}
+
+static uint64_t chord2(const int64_t *v, const GP02PoiPoint &p)
+{
+   int64_t dx = v[0] - p.x, dy = v[1] - p.y, dz = v[2] - p.z;
+   return (uint64_t)(dx * dx) + (uint64_t)(dy * dy) + (uint64_t)(dz * dz);
+}
+
+// max-heap on the squared chord, so out[0] is the worst of the k best
+static void siftDown(GP02Poi *heap, size_t n, size_t i)
+{
+   for (;;)
+   {
+      size_t largest = i, l = 2 * i + 1, r = l + 1;
+      if (l < n && heap[l].chord2 > heap[largest].chord2)
+         largest = l;
+      if (r < n && heap[r].chord2 > heap[largest].chord2)
+         largest = r;
+      if (largest == i)
+         return;
+      GP02Poi t = heap[i];
+      heap[i] = heap[largest];
+      heap[largest] = t;
+      i = largest;
+   }
+}
+
+static void siftUp(GP02Poi *heap, size_t i)
+{
+   while (i > 0)
+   {
+      size_t parent = (i - 1) / 2;
+      if (heap[parent].chord2 >= heap[i].chord2)
+         return;
+      GP02Poi t = heap[i];
+      heap[i] = heap[parent];
+      heap[parent] = t;
+      i = parent;
+   }
+}
+
+/**
+ * @brief Uses a blob produced by the offline builder as the index.
+ *
+ * The blob is not copied and must outlive the index. It has to be 4-byte aligned.
+ *
+ * @param blob The GP02PoiHeader followed by the points in tree order.
+ * @param size The size of the blob in bytes.
+ * @return False (and an empty index) if the blob is truncated, misaligned or of another version.
+ */
+bool GP02PoiIndex::attach(const void *blob, size_t size)
+{
+   points = 0;
+   count = 0;
+   const GP02PoiHeader *h = static_cast<const GP02PoiHeader *>(blob);
+   if (blob == 0 || ((uintptr_t)blob & 3) != 0 || size < sizeof(GP02PoiHeader))
+      return false;
+   if (h->magic != _GPS_POI_MAGIC || h->version != _GPS_POI_VERSION || h->pointSize != sizeof(GP02PoiPoint))
+      return false;
+   if ((size - sizeof(GP02PoiHeader)) / sizeof(GP02PoiPoint) < h->count)
+      return false;
+   points = reinterpret_cast<const GP02PoiPoint *>(h + 1);
+   count = h->count;
+   return true;
+}
+
+/**
+ * @brief Converts a position to the fixed-point unit vector stored in the index.
+ *
+ * @param lat Latitude in degrees.
+ * @param lng Longitude in degrees.
+ * @param id The identifier returned by queries.
+ */
+GP02PoiPoint GP02PoiIndex::point(double lat, double lng, uint32_t id)
+{
+   double phi = radians(lat), lambda = radians(lng);
+   GP02PoiPoint p;
+   p.x = (int32_t)lround(cos(phi) * cos(lambda) * _GPS_POI_SCALE);
+   p.y = (int32_t)lround(cos(phi) * sin(lambda) * _GPS_POI_SCALE);
+   p.z = (int32_t)lround(sin(phi) * _GPS_POI_SCALE);
+   p.id = id;
+   return p;
+}
+
+/**
+ * @brief Converts a squared chord between two stored points to a great-circle distance.
+ *
+ * @param chord2 The squared straight-line distance in units of 1 / _GPS_POI_SCALE.
+ * @return The distance in meters on the sphere of GP02::distanceBetween().
+ */
+double GP02PoiIndex::metersFromChord(uint64_t chord2)
+{
+   double half = sqrt((double)chord2) / _GPS_POI_SCALE / 2;
+   if (half > 1)
+      half = 1;
+   return 2 * asin(half) * _GPS_EARTH_MEAN_RADIUS;
+}
+
+/**
+ * @brief Converts a great-circle distance to the squared chord compared during searches.
+ *
+ * @param meters The distance; negative or beyond half the circumference means unlimited.
+ */
+uint64_t GP02PoiIndex::chordFromMeters(double meters)
+{
+   double theta = meters / _GPS_EARTH_MEAN_RADIUS;
+   if (meters < 0 || theta >= PI)
+      return ~(uint64_t)0;
+   double chord = 2 * sin(theta / 2) * _GPS_POI_SCALE;
+   return (uint64_t)(chord * chord) + 1;
+}
+
+/**
+ * @brief Returns the position of an indexed point, e.g. GP02Poi::slot of a query result.
+ */
+void GP02PoiIndex::location(uint32_t slot, double &lat, double &lng) const
+{
+   if (slot >= count)
+   {
+      lat = lng = 0;
+      return;
+   }
+   const GP02PoiPoint &p = points[slot];
+   lat = degrees(atan2((double)p.z, sqrt((double)p.x * p.x + (double)p.y * p.y)));
+   lng = degrees(atan2((double)p.y, (double)p.x));
+}
+
+/**
+ * @brief Finds the k points nearest to a position.
+ *
+ * @param lat Latitude in degrees.
+ * @param lng Longitude in degrees.
+ * @param out Receives up to k results, nearest first.
+ * @param k The number of points wanted.
+ * @param maxMeters Ignore points farther than this; negative for no limit.
+ * @return The number of results written, less than k if the index or radius holds fewer.
+ */
+size_t GP02PoiIndex::nearest(double lat, double lng, GP02Poi *out, size_t k, double maxMeters) const
+{
+   return nearest(point(lat, lng, 0), out, k, maxMeters);
+}
+
+/**
+ * @brief Finds the k points nearest to a position already converted with point().
+ *
+ * The search is integer arithmetic only, so it gives the same results on every target.
+ *
+ * @param at The position; its id is ignored.
+ * @param out Receives up to k results, nearest first.
+ * @param k The number of points wanted.
+ * @param maxMeters Ignore points farther than this; negative for no limit.
+ * @return The number of results written, less than k if the index or radius holds fewer.
+ */
+size_t GP02PoiIndex::nearest(const GP02PoiPoint &at, GP02Poi *out, size_t k, double maxMeters) const
+{
+   if (count == 0 || k == 0)
+      return 0;
+   Query q = { { at.x, at.y, at.z }, chordFromMeters(maxMeters), out, k, 0, 0 };
+   searchNearest(q, 0, count, 0);
+
+   // heap sort leaves the results in ascending order
+   for (size_t n = q.found; n > 1; --n)
+   {
+      GP02Poi t = out[0];
+      out[0] = out[n - 1];
+      out[n - 1] = t;
+      siftDown(out, n - 1, 0);
+   }
+   for (size_t i = 0; i < q.found; ++i)
+      out[i].meters = metersFromChord(out[i].chord2);
+   return q.found;
+}
+
+void GP02PoiIndex::searchNearest(Query &q, size_t lo, size_t hi, uint8_t axis) const
+{
+   while (lo < hi)
+   {
+      size_t mid = lo + (hi - lo) / 2;
+      const GP02PoiPoint &p = points[mid];
+      uint64_t d = chord2(q.v, p);
+      if (d <= q.limit)
+      {
+         GP02Poi hit = { p.id, (uint32_t)mid, d, 0 };
+         if (q.found < q.capacity)
+         {
+            q.out[q.found] = hit;
+            siftUp(q.out, q.found++);
+         }
+         else if (d < q.out[0].chord2)
+         {
+            q.out[0] = hit;
+            siftDown(q.out, q.found, 0);
+         }
+         if (q.found == q.capacity && q.out[0].chord2 < q.limit)
+            q.limit = q.out[0].chord2;
+      }
+
+      int64_t diff = q.v[axis] - component(p, axis);
+      uint8_t next = axis == 2 ? 0 : axis + 1;
+      size_t nearLo = diff < 0 ? lo : mid + 1, nearHi = diff < 0 ? mid : hi;
+      size_t farLo = diff < 0 ? mid + 1 : lo, farHi = diff < 0 ? hi : mid;
+      searchNearest(q, nearLo, nearHi, next);
+      // the far half can only hold a closer point if the splitting plane is within reach
+      if ((uint64_t)(diff * diff) > q.limit)
+         return;
+      lo = farLo;
+      hi = farHi;
+      axis = next;
+   }
+}
+
+/**
+ * @brief Finds the points within a great-circle radius of a position.
+ *
+ * Results are in no particular order.
+ *
+ * @param lat Latitude in degrees.
+ * @param lng Longitude in degrees.
+ * @param meters The search radius.
+ * @param out Receives up to max results.
+ * @param max The capacity of out.
+ * @return The number of points in range, which may exceed max.
+ */
+size_t GP02PoiIndex::within(double lat, double lng, double meters, GP02Poi *out, size_t max) const
+{
+   return within(point(lat, lng, 0), meters, out, max);
+}
+
+/**
+ * @brief Finds the points within a great-circle radius of a position already converted with point().
+ *
+ * @param at The position; its id is ignored.
+ * @param meters The search radius.
+ * @param out Receives up to max results, in no particular order.
+ * @param max The capacity of out.
+ * @return The number of points in range, which may exceed max.
+ */
+size_t GP02PoiIndex::within(const GP02PoiPoint &at, double meters, GP02Poi *out, size_t max) const
+{
+   if (count == 0 || meters < 0)
+      return 0;
+   Query q = { { at.x, at.y, at.z }, chordFromMeters(meters), out, max, 0, 0 };
+   searchWithin(q, 0, count, 0);
+   return q.total;
+}
+
+void GP02PoiIndex::searchWithin(Query &q, size_t lo, size_t hi, uint8_t axis) const
+{
+   while (lo < hi)
+   {
+      size_t mid = lo + (hi - lo) / 2;
+      const GP02PoiPoint &p = points[mid];
+      uint64_t d = chord2(q.v, p);
+      if (d <= q.limit)
+      {
+         if (q.found < q.capacity)
+         {
+            GP02Poi hit = { p.id, (uint32_t)mid, d, metersFromChord(d) };
+            q.out[q.found++] = hit;
+         }
+         ++q.total;
+      }
+
+      int64_t diff = q.v[axis] - component(p, axis);
+      uint8_t next = axis == 2 ? 0 : axis + 1;
+      uint64_t plane = (uint64_t)(diff * diff);
+      // the half on the query's side is always searched; the other one only within reach
+      if (diff < 0)
+      {
+         searchWithin(q, lo, mid, next);
+         if (plane > q.limit)
+            return;
+         lo = mid + 1;
+      }
+      else
+      {
+         searchWithin(q, mid + 1, hi, next);
+         if (plane > q.limit)
+            return;
+         hi = mid;
+      }
+      axis = next;
+   }
+}
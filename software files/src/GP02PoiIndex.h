@@ -0,0 +1,89 @@
+#ifndef GP02PoiIndex_h
+#define GP02PoiIndex_h
+
+/*
+GP02PoiIndex - nearest point-of-interest lookup over a static, pre-built k-d tree.
+
+Points (depots, stops, waypoints) are stored as unit vectors on the sphere in a blob that is
+built offline (see extras/host/gp02poi) and used in place: memory-mapped on a host, or linked
+as a const array on targets whose flash is directly addressable (ESP32, ARM). The tree is
+implicit: each range of the array keeps its median point in the middle and the two halves on
+either side, so there are no child pointers and a subtree is one contiguous run of memory.
+
+   GP02PoiIndex depots;
+   depots.attach(blob, blobSize);
+   GP02Poi hit[4];
+   size_t n = depots.nearest(gps.location.lat(), gps.location.lng(), hit, 4);
+
+Straight-line distance between unit vectors grows monotonically with the great-circle angle,
+so searching in 3D is exact and has no trouble at the poles or the antimeridian. Distances
+are returned in meters on the same sphere as GP02::distanceBetween(). Coordinates are held
+to about 1 cm; neither query allocates memory.
+
+The searches compare squared chords of the fixed-point vectors as 64-bit integers, so they
+agree on every target once the query is a GP02PoiPoint. Where double is a 32-bit float (AVR),
+converting the query from degrees is good to about 2 m instead, so radii, and differences
+between the distances of two points, below _GPS_POI_MIN_METERS are not resolved there.
+*/
+
+#include "GP02.h"
+#include <stddef.h>
+
+#define _GPS_POI_MAGIC 0x494F5047UL // "GPOI"
+#define _GPS_POI_VERSION 1
+#define _GPS_POI_SCALE 536870912.0 // 2^29: unit vector components as int32, and squared distances fit 64 bits
+#define _GPS_POI_MIN_METERS 5 // smallest radius queries from degrees resolve where double is float
+
+struct GP02PoiHeader
+{
+   uint32_t magic;
+   uint16_t version;
+   uint16_t pointSize;           // sizeof(GP02PoiPoint)
+   uint32_t count;
+   uint32_t reserved;
+};
+
+struct GP02PoiPoint
+{
+   int32_t x, y, z;              // unit vector * _GPS_POI_SCALE
+   uint32_t id;                  // caller defined, e.g. a depot number
+};
+
+struct GP02Poi
+{
+   uint32_t id;
+   uint32_t slot;                // position in the index, for location()
+   uint64_t chord2;              // squared chord in units of 1 / _GPS_POI_SCALE, as compared by the searches
+   double meters;
+};
+
+class GP02PoiIndex
+{
+public:
+   GP02PoiIndex() : points(0), count(0) {}
+
+   bool attach(const void *blob, size_t size);
+   bool isValid() const { return points != 0; }
+   size_t size() const  { return count; }
+
+   size_t nearest(double lat, double lng, GP02Poi *out, size_t k, double maxMeters = -1) const;
+   size_t nearest(const GP02PoiPoint &at, GP02Poi *out, size_t k, double maxMeters = -1) const;
+   size_t within(double lat, double lng, double meters, GP02Poi *out, size_t max) const;
+   size_t within(const GP02PoiPoint &at, double meters, GP02Poi *out, size_t max) const;
+   void location(uint32_t slot, double &lat, double &lng) const;
+
+   static GP02PoiPoint point(double lat, double lng, uint32_t id);
+   static double metersFromChord(uint64_t chord2);
+   static uint64_t chordFromMeters(double meters);
+
+private:
+   struct Query;
+
+   const GP02PoiPoint *points;
+   size_t count;
+
+   void searchNearest(Query &q, size_t lo, size_t hi, uint8_t axis) const;
+   void searchWithin(Query &q, size_t lo, size_t hi, uint8_t axis) const;
+};
+
+#endif // def(GP02PoiIndex_h)
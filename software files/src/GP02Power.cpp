@@ -0,0 +1,206 @@
+/*
+GP02Power - duty-cycles the GP-02 between acquisition and standby from the parsed fix quality.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+*/
+
+#include "GP02Power.h"
+
+#include <string.h>
+
+#define _PCAS_STANDBY "PCAS12," // standby for the given number of seconds
+#define _PCAS_RESTART "PCAS10," // 0 hot, 1 warm, 2 cold start
+
+/**
+ * @brief Creates a scheduler that starts out acquiring.
+ *
+ * @param sink Called with every command to write to the receiver.
+ * @param context Passed to the sink unchanged.
+ * @param policy Thresholds and timings; see GP02PowerPolicy.
+ */
+GP02Power::GP02Power(GP02CommandSink commandSink, void *context, const GP02PowerPolicy &policy)
+   : sink(commandSink)
+   , sinkContext(context)
+   , rules(policy)
+   , current(Acquiring)
+   , sleepLength(policy.sleepSeconds)
+   , standbyLength(0)
+{
+   memset(&statistics, 0, sizeof(statistics));
+   stateStart = lastUpdate = millis();
+}
+
+/**
+ * @brief Frames a command body as a complete sentence with checksum and CR/LF.
+ *
+ * @param buf The output buffer.
+ * @param size The size of buf, at least _GPS_PCAS_MAX for the commands used here.
+ * @param body The characters between '$' and '*', e.g. "PCAS12,60".
+ * @return The sentence length, or 0 if buf is too small.
+ */
+size_t GP02Power::command(char *buf, size_t size, const char *body)
+{
+   static const char hex[] = "0123456789ABCDEF";
+   size_t len = strlen(body);
+   if (size < len + 7)
+      return 0;
+   uint8_t parity = 0;
+   buf[0] = '$';
+   for (size_t i = 0; i < len; ++i)
+   {
+      buf[i + 1] = body[i];
+      parity ^= (uint8_t)body[i];
+   }
+   char *p = buf + len + 1;
+   *p++ = '*';
+   *p++ = hex[parity >> 4];
+   *p++ = hex[parity & 0xF];
+   *p++ = '\r';
+   *p++ = '\n';
+   *p = '\0';
+   return len + 6;
+}
+
+void GP02Power::send(const char *body, uint16_t arg)
+{
+   char text[_GPS_PCAS_MAX - 6], digits[6];
+   uint8_t n = 0;
+   do
+   {
+      digits[n++] = '0' + arg % 10;
+      arg /= 10;
+   } while (arg);
+   size_t len = strlen(body);
+   memcpy(text, body, len);
+   while (n)
+      text[len++] = digits[--n];
+   text[len] = '\0';
+
+   char sentence[_GPS_PCAS_MAX];
+   if (sink && command(sentence, sizeof(sentence), text))
+      sink(sinkContext, sentence);
+}
+
+/**
+ * @brief Tests the current fields against the policy.
+ *
+ * @return True if the location is valid and fresh, GGA reports a fix, HDOP is low enough and
+ * enough satellites are used.
+ */
+bool GP02Power::isGoodFix(GP02 &gps) const
+{
+   if (!gps.location.isValid() || gps.location.age() > rules.maxAgeMs)
+      return false;
+   // the accessors clear isUpdated(), so they are called on copies the sketch never sees
+   GP02Location location = gps.location;
+   if (location.FixQuality() == GP02Location::Invalid)
+      return false;
+   GP02HDOP hdop = gps.hdop;
+   if (!hdop.isValid() || hdop.value() > (int32_t)rules.maxHdop)
+      return false;
+   GP02Integer satellites = gps.satellites;
+   return satellites.isValid() && satellites.value() >= rules.minSatellites;
+}
+
+/**
+ * @brief Advances the schedule; call it from loop() after feeding the parser.
+ *
+ * @param gps The parser fed from the receiver being managed.
+ * @return The state after the update.
+ */
+GP02Power::State GP02Power::update(GP02 &gps)
+{
+   uint32_t now = millis();
+   if (current == Standby)
+      statistics.standbyMs += now - lastUpdate;
+   else
+      statistics.awakeMs += now - lastUpdate;
+   lastUpdate = now;
+   uint32_t inState = now - stateStart;
+
+   switch (current)
+   {
+   case Acquiring:
+      // only a location committed since the wake-up counts; age() < inState says just that
+      if (gps.location.isValid() && gps.location.age() < inState && isGoodFix(gps))
+      {
+         statistics.lastTtff = inState;
+         statistics.totalTtff += inState;
+         if (statistics.acquisitions == 0 || inState < statistics.minTtff)
+            statistics.minTtff = inState;
+         if (inState > statistics.maxTtff)
+            statistics.maxTtff = inState;
+         ++statistics.acquisitions;
+
+         // a hot start means the ephemeris outlived the sleep, so try a longer one next time
+         if (inState < rules.hotFixMs)
+            sleepLength = sleepLength > rules.maxSleepSeconds / 2 ? rules.maxSleepSeconds : sleepLength * 2;
+         else
+            sleepLength = sleepLength / 2 < rules.minSleepSeconds ? rules.minSleepSeconds : sleepLength / 2;
+         enter(Tracking, now);
+      }
+      else if (inState >= rules.acquireSeconds * 1000UL)
+      {
+         ++statistics.failures;
+         standby(rules.retrySeconds);
+      }
+      break;
+
+   case Tracking:
+      if (!isGoodFix(gps))
+         enter(Acquiring, now);
+      else if (inState >= rules.holdSeconds * 1000UL)
+         standby(sleepLength);
+      break;
+
+   case Standby:
+      // the receiver ends a timed standby by itself
+      if (inState >= standbyLength)
+         enter(Acquiring, now);
+      break;
+   }
+   return current;
+}
+
+/**
+ * @brief Commands the receiver into standby now.
+ *
+ * @param seconds How long the receiver stays in standby before it wakes by itself.
+ */
+void GP02Power::standby(uint16_t seconds)
+{
+   send(_PCAS_STANDBY, seconds);
+   standbyLength = seconds * 1000UL;
+   enter(Standby, millis());
+}
+
+/**
+ * @brief Ends standby early with a hot start. Does nothing while the receiver is awake.
+ */
+void GP02Power::wake()
+{
+   if (current != Standby)
+      return;
+   send(_PCAS_RESTART, 0);
+   enter(Acquiring, millis());
+}
+
+/**
+ * @brief Returns the milliseconds left until the receiver wakes, or 0 while it is awake.
+ */
+uint32_t GP02Power::standbyRemaining() const
+{
+   if (current != Standby)
+      return 0;
+   uint32_t slept = millis() - stateStart;
+   return slept < standbyLength ? standbyLength - slept : 0;
+}
+
+void GP02Power::enter(State s, uint32_t now)
+{
+   current = s;
+   stateStart = now;
+}
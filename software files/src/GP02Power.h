@@ -0,0 +1,104 @@
+#ifndef GP02Power_h
+#define GP02Power_h
+
+/*
+GP02Power - duty-cycles the GP-02 between acquisition and standby from the parsed fix quality.
+
+The scheduler is polled from loop() next to the parser and sends CASIC (PCAS) commands
+through a caller supplied sink, so it works with any serial port:
+
+   static void toGps(void *, const char *sentence) { Serial1.print(sentence); }
+   GP02Power power(toGps, NULL);
+
+   void loop()
+   {
+     while (Serial1.available()) gps.encode(Serial1.read());
+     power.update(gps);
+     if (power.state() == GP02Power::Tracking && gps.location.isUpdated()) ...
+   }
+
+A fix counts as good when the location is valid and younger than maxAgeMs, the GGA quality
+is not Invalid, HDOP is at most maxHdop and at least minSatellites are used. While acquiring,
+the location must also have been committed after the wake-up, so a fix left over from before
+standby is not taken for a new one. While tracking, a fix that stops meeting these criteria
+sends the scheduler back to acquiring. The receiver is kept on for holdSeconds of good fixes,
+then put into standby with $PCAS12 for sleepSeconds and left to wake by itself. Short times to fix mean the ephemeris survived the sleep, so the
+sleep is doubled up to maxSleepSeconds; long ones halve it down to minSleepSeconds. When no
+good fix arrives within acquireSeconds the receiver sleeps for retrySeconds and tries again.
+wake() ends standby early (e.g. on a motion interrupt) with a hot start, $PCAS10,0.
+
+update() reads copies of the fields, so their isUpdated() flags are left to the sketch, and
+stats() keeps time-to-fix figures for every acquisition.
+*/
+
+#include "GP02.h"
+
+#define _GPS_PCAS_MAX 24 // longest command built by GP02Power, with CR/LF and NUL
+
+// receives complete sentences, "$PCAS12,60*28\r\n", to write to the receiver
+typedef void (*GP02CommandSink)(void *context, const char *sentence);
+
+struct GP02PowerPolicy
+{
+   uint16_t maxHdop;             // hundredths
+   uint8_t minSatellites;
+   uint16_t maxAgeMs;
+   uint16_t holdSeconds;         // good fixes delivered per wake-up
+   uint16_t acquireSeconds;      // give up on a wake-up after this long
+   uint16_t retrySeconds;        // standby after a failed acquisition
+   uint16_t sleepSeconds;        // first standby length
+   uint16_t minSleepSeconds, maxSleepSeconds;
+   uint16_t hotFixMs;            // a time to fix below this counts as a hot start
+
+   GP02PowerPolicy()
+     : maxHdop(250), minSatellites(5), maxAgeMs(1500), holdSeconds(5), acquireSeconds(120), retrySeconds(300)
+     , sleepSeconds(60), minSleepSeconds(15), maxSleepSeconds(900), hotFixMs(5000)
+   {}
+};
+
+struct GP02PowerStats
+{
+   uint16_t acquisitions;        // wake-ups that reached a good fix
+   uint16_t failures;            // wake-ups that timed out
+   uint32_t lastTtff, minTtff, maxTtff; // milliseconds from wake-up to the first good fix
+   uint32_t totalTtff;
+   uint32_t awakeMs, standbyMs;  // time spent in each, up to the last update()
+
+   uint32_t meanTtff() const     { return acquisitions ? totalTtff / acquisitions : 0; }
+   uint8_t dutyPercent() const   { return awakeMs + standbyMs ? (uint8_t)(100ULL * awakeMs / (awakeMs + standbyMs)) : 100; }
+};
+
+class GP02Power
+{
+public:
+   enum State { Acquiring, Tracking, Standby };
+
+   GP02Power(GP02CommandSink sink, void *context, const GP02PowerPolicy &policy = GP02PowerPolicy());
+
+   State update(GP02 &gps);
+   void wake();
+   void standby(uint16_t seconds);
+
+   State state() const                   { return current; }
+   uint16_t sleepSeconds() const         { return sleepLength; }
+   uint32_t standbyRemaining() const;
+   const GP02PowerStats &stats() const   { return statistics; }
+   GP02PowerPolicy &policy()             { return rules; }
+
+   bool isGoodFix(GP02 &gps) const;
+   static size_t command(char *buf, size_t size, const char *body);
+
+private:
+   GP02CommandSink sink;
+   void *sinkContext;
+   GP02PowerPolicy rules;
+   GP02PowerStats statistics;
+   State current;
+   uint16_t sleepLength;
+   uint32_t stateStart, standbyLength, lastUpdate;
+
+   void enter(State s, uint32_t now);
+   void send(const char *body, uint16_t arg);
+};
+
+#endif // def(GP02Power_h)
@@ -0,0 +1,268 @@
+/*
+GP02Trip - odometer, moving/stopped time, stops, speed and climb statistics of a trip.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+*/
+
+#include "GP02.h"
+
+// compiles to nothing unless the library is built with epochs, which GP02Trip needs
+#ifdef _GPS_EPOCHS
+
+#include "GP02Trip.h"
+
+#include <math.h>
+
+#define _TRIP_MS_PER_DAY 86400000L
+#define _TRIP_NANO_HALF_TURN 180000000000LL // 180 degrees in nanodegrees
+#define _TRIP_MM_PER_NANODEGREE (_GPS_EARTH_MEAN_RADIUS * 1000.0 * PI / _TRIP_NANO_HALF_TURN)
+#define _TRIP_RESCALE_NANODEGREES 1000000 // latitude change that refreshes the east scale
+#define _TRIP_KNOTS100_PER_MPS (100 / _GPS_MPS_PER_KNOT)
+
+static int64_t nanodegrees(const RawDegrees &deg)
+{
+   int64_t nano = (int64_t)deg.deg * 1000000000LL + deg.billionths;
+   return deg.negative ? -nano : nano;
+}
+
+/**
+ * @brief Creates an empty trip.
+ *
+ * @param policy Motion thresholds and glitch limits; see GP02TripPolicy.
+ */
+GP02Trip::GP02Trip(const GP02TripPolicy &policy)
+   : rules(policy)
+{
+   reset();
+}
+
+/**
+ * @brief Starts a new trip; the policy is kept.
+ */
+void GP02Trip::reset()
+{
+   current = Stopped;
+   started = candidate = hasAltitude = false;
+   lastTime = candidateTime = stateTime = 0;
+   prevLat = prevLng = fromLat = fromLng = scaleLat = 0;
+   runLat = runLng = 0;
+   run = 0;
+   eastScale = 1;
+   odometer = 0;
+   elapsed = moving = stopped = 0;
+   stopCount = gapCount = glitchCount = relocationCount = 0;
+   topSpeed = 0;
+   climbRef = climbed = descended = lowest = highest = 0;
+   used = skipped = 0;
+}
+
+/**
+ * @brief Adds the parser's epoch if a new one has been committed since the last call.
+ *
+ * @param gps A parser with epochs enabled.
+ * @return True if a fix was added.
+ */
+bool GP02Trip::update(GP02 &gps)
+{
+   if (!gps.epoch.isUpdated())
+      return false;
+   return add(gps.epoch.value());
+}
+
+/**
+ * @brief Returns the average speed over the time spent moving.
+ *
+ * @return Hundredths of knots, or 0 before the trip has moved.
+ */
+int32_t GP02Trip::averageSpeed() const
+{
+   if (moving == 0)
+      return 0;
+   // millimeters per millisecond are meters per second
+   return (int32_t)((double)odometer / moving * _TRIP_KNOTS100_PER_MPS + 0.5);
+}
+
+// millimeters between two positions, flat-earth over one step
+uint32_t GP02Trip::distance(int64_t lat0, int64_t lng0, int64_t lat1, int64_t lng1)
+{
+   int64_t north = lat1 - lat0, east = lng1 - lng0;
+   if (east > _TRIP_NANO_HALF_TURN)
+      east -= 2 * _TRIP_NANO_HALF_TURN;
+   else if (east <= -_TRIP_NANO_HALF_TURN)
+      east += 2 * _TRIP_NANO_HALF_TURN;
+   int64_t drift = lat1 - scaleLat;
+   if (drift > _TRIP_RESCALE_NANODEGREES || drift < -_TRIP_RESCALE_NANODEGREES)
+   {
+      scaleLat = lat1;
+      eastScale = cos(radians(lat1 / 1e9));
+   }
+   double n = (double)north * _TRIP_MM_PER_NANODEGREE, e = (double)east * _TRIP_MM_PER_NANODEGREE * eastScale;
+   double mm = sqrt(n * n + e * e) + 0.5;
+   return mm > 4294967295.0 ? 0xFFFFFFFFUL : (uint32_t)mm;
+}
+
+void GP02Trip::climb(int32_t altitude)
+{
+   if (!hasAltitude)
+   {
+      hasAltitude = true;
+      climbRef = lowest = highest = altitude;
+      return;
+   }
+   if (altitude < lowest)
+      lowest = altitude;
+   if (altitude > highest)
+      highest = altitude;
+   // the reference only follows changes beyond the deadband, so altitude noise adds nothing
+   if (altitude >= climbRef + rules.climbDeadband)
+   {
+      climbed += altitude - climbRef;
+      climbRef = altitude;
+   }
+   else if (altitude <= climbRef - rules.climbDeadband)
+   {
+      descended += climbRef - altitude;
+      climbRef = altitude;
+   }
+}
+
+/**
+ * @brief Adds one committed fix to the trip.
+ *
+ * @param fix A receiver epoch, or a fused one. Fixes should arrive in time order.
+ * @return False if the fix was ignored: no time or location, HDOP above the policy, not
+ * later than the previous fix, or a position jump faster than maxKnots that has not (yet)
+ * been confirmed by relocateFixes glitches in a row.
+ */
+bool GP02Trip::add(const GP02Fix &fix)
+{
+   if (!fix.has(GP02Fix::HasTime) || !fix.has(GP02Fix::HasLocation) ||
+       (fix.has(GP02Fix::HasHDOP) && fix.hdop > (int32_t)rules.maxHdop))
+   {
+      ++skipped;
+      return false;
+   }
+   uint32_t now = GP02Time::millisFromPacked(fix.time);
+   int64_t lat = nanodegrees(fix.lat), lng = nanodegrees(fix.lng);
+   if (!started)
+   {
+      started = true;
+      lastTime = now;
+      prevLat = fromLat = lat;
+      prevLng = fromLng = lng;
+      if (fix.has(GP02Fix::HasSpeed))
+         topSpeed = fix.speed;
+      if (fix.has(GP02Fix::HasAltitude))
+         climb(fix.altitude);
+      ++used;
+      return true;
+   }
+
+   // the time of day folded across midnight; repeated or older fixes are dropped
+   int32_t dt = (int32_t)(now - lastTime);
+   if (dt > _TRIP_MS_PER_DAY / 2)
+      dt -= _TRIP_MS_PER_DAY;
+   else if (dt < -_TRIP_MS_PER_DAY / 2)
+      dt += _TRIP_MS_PER_DAY;
+   if (dt <= 0)
+   {
+      ++skipped;
+      return false;
+   }
+   lastTime = now;
+   elapsed += dt;
+   bool gap = dt > (int32_t)rules.maxGapMs;
+   if (gap)
+   {
+      ++gapCount;
+      candidate = false;
+   }
+   else if (current == Moving)
+      moving += dt;
+   else
+      stopped += dt;
+   stateTime += dt;
+
+   double maxSpeed = rules.maxKnots * _GPS_MPS_PER_KNOT; // millimeters per millisecond
+   uint32_t mm = distance(prevLat, prevLng, lat, lng);
+   if (mm / (double)dt > maxSpeed)
+   {
+      // glitches that agree with each other may be the real track seen from a bad anchor
+      bool agrees = run > 0 && distance(runLat, runLng, lat, lng) / (double)dt <= maxSpeed;
+      if (rules.relocateFixes != 0)
+         run = agrees ? run + 1 : 1;
+      if (run < rules.relocateFixes || rules.relocateFixes == 0)
+      {
+         runLat = lat;
+         runLng = lng;
+         ++glitchCount;
+         ++skipped;
+         return false;
+      }
+      // re-anchor on the previous glitch and take this fix as a step from there
+      ++relocationCount;
+      prevLat = fromLat = runLat;
+      prevLng = fromLng = runLng;
+      mm = distance(prevLat, prevLng, lat, lng);
+   }
+   run = 0;
+   prevLat = lat;
+   prevLng = lng;
+   ++used;
+
+   int32_t speed = fix.has(GP02Fix::HasSpeed) ? fix.speed : (int32_t)(mm / (double)dt * _TRIP_KNOTS100_PER_MPS + 0.5);
+   if (speed > topSpeed)
+      topSpeed = speed;
+   if (fix.has(GP02Fix::HasAltitude))
+      climb(fix.altitude);
+
+   if (current == Moving)
+   {
+      odometer += mm;
+      fromLat = lat;
+      fromLng = lng;
+   }
+   bool toward = current == Moving ? speed < (int32_t)rules.stopSpeed : speed >= (int32_t)rules.startSpeed;
+   if (!toward)
+   {
+      candidate = false;
+      return true;
+   }
+   if (!candidate)
+   {
+      // the change is timed from this fix on
+      candidate = true;
+      candidateTime = 0;
+      return true;
+   }
+   if (!gap)
+      candidateTime += dt;
+   if (candidateTime < (current == Moving ? rules.stopMs : rules.startMs))
+      return true;
+
+   // the hold time already belonged to the new state
+   candidate = false;
+   stateTime = candidateTime;
+   if (current == Moving)
+   {
+      current = Stopped;
+      moving -= candidateTime;
+      stopped += candidateTime;
+      ++stopCount;
+   }
+   else
+   {
+      current = Moving;
+      stopped -= candidateTime;
+      moving += candidateTime;
+      odometer += distance(fromLat, fromLng, lat, lng);
+      fromLat = lat;
+      fromLng = lng;
+   }
+   return true;
+}
+
+#endif // def(_GPS_EPOCHS)
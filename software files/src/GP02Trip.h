@@ -0,0 +1,129 @@
+#ifndef GP02Trip_h
+#define GP02Trip_h
+
+/*
+GP02Trip - odometer, moving/stopped time, stops, speed and climb statistics of a trip.
+
+The trip is fed one committed fix per receiver epoch, either straight from a parser with
+epochs enabled or as any GP02Fix, e.g. a GP02FusedFix:
+
+   GP02Trip trip;
+
+   void setup()  { gps.enableEpochs(GP02Epoch::RMC); }
+   void loop()
+   {
+     while (Serial1.available()) gps.encode(Serial1.read());
+     if (trip.update(gps)) Serial.println(trip.meters());
+   }
+
+Distances are taken between successive positions as nanodegree differences of the raw
+fixed-point coordinates, scaled to meters on the sphere of GP02::distanceBetween() with a
+cosine of latitude that is recomputed only after 0.001 degrees of north-south travel. Steps
+are rounded to millimeters and summed in an integer, so the odometer carries no float error
+however long the trip, and no step needs more than a multiply-add and a square root.
+
+The trip is Moving or Stopped. It starts moving once the reported speed has stayed at or
+above startSpeed for startMs, and stops once it has stayed below stopSpeed for stopMs. While
+stopped, positions only wander, so no distance is added; when the trip moves again the
+straight line from where it stopped is added in one step. The hold time is credited to the
+new state, so a stop is counted from the first slow fix. Without a speed in the fix, the
+speed implied by the last step is used instead.
+
+Time comes from the UTC time of the fixes, so a trip replays identically from a log. A gap
+of more than maxGapMs between fixes counts towards the elapsed time only; a step across it
+is still added while moving (a tunnel) unless it implies more than maxKnots. Fixes without a
+time or location, or with an HDOP above maxHdop, are ignored.
+
+A step faster than maxKnots is dropped as a glitch, measured from the last position used.
+When that position was the glitch, e.g. a bad first fix, every later fix would be dropped,
+so relocateFixes glitches in a row that agree with each other (none faster than maxKnots from
+the one before) are taken as the real track: the trip re-anchors on them, without adding the
+jump to the odometer, and goes on from there.
+
+Each fix costs the same fixed amount of work, and the statistics take a fixed amount of RAM.
+*/
+
+#include "GP02.h"
+
+#ifndef _GPS_EPOCHS
+#error "GP02Trip needs the library built with _GPS_EPOCHS (see GP02Config.h)"
+#endif
+
+struct GP02TripPolicy
+{
+   uint16_t startSpeed;          // hundredths of knots held for startMs to start moving
+   uint16_t stopSpeed;           // hundredths of knots, below it for stopMs to stop
+   uint16_t startMs, stopMs;
+   uint16_t maxGapMs;            // longer gaps are not counted as moving or stopped time
+   uint16_t maxKnots;            // steps implying more are dropped as position glitches
+   uint16_t maxHdop;             // hundredths
+   uint16_t climbDeadband;       // centimeters of altitude change before ascent or descent counts
+   uint8_t relocateFixes;        // agreeing glitches in a row that re-anchor the trip; 0 never does
+
+   GP02TripPolicy()
+     : startSpeed(200), stopSpeed(100), startMs(2000), stopMs(5000), maxGapMs(10000), maxKnots(300)
+     , maxHdop(500), climbDeadband(300), relocateFixes(3)
+   {}
+};
+
+class GP02Trip
+{
+public:
+   enum State { Stopped, Moving };
+
+   GP02Trip(const GP02TripPolicy &policy = GP02TripPolicy());
+
+   bool update(GP02 &gps);
+   bool add(const GP02Fix &fix);
+   void reset();
+
+   State state() const                { return current; }
+   uint64_t millimeters() const       { return odometer; }
+   double meters() const              { return odometer / 1000.0; }
+   double kilometers() const          { return odometer / 1000000.0; }
+
+   uint32_t elapsedMs() const         { return elapsed; }
+   uint32_t movingMs() const          { return moving; }
+   uint32_t stoppedMs() const         { return stopped; }
+   uint32_t stoppedFor() const        { return current == Stopped ? stateTime : 0; }
+   uint16_t stops() const             { return stopCount; }
+
+   int32_t maxSpeed() const           { return topSpeed; }      // hundredths of knots
+   int32_t averageSpeed() const;                                // hundredths of knots while moving
+   int32_t ascent() const             { return climbed; }       // centimeters
+   int32_t descent() const            { return descended; }     // centimeters
+   int32_t minAltitude() const        { return lowest; }        // centimeters
+   int32_t maxAltitude() const        { return highest; }       // centimeters
+
+   uint32_t fixes() const             { return used; }
+   uint32_t ignored() const           { return skipped; }
+   uint16_t gaps() const              { return gapCount; }
+   uint16_t glitches() const          { return glitchCount; }
+   uint16_t relocations() const       { return relocationCount; }
+   GP02TripPolicy &policy()           { return rules; }
+
+private:
+   GP02TripPolicy rules;
+   State current;
+   bool started, candidate, hasAltitude;
+   uint32_t lastTime;            // milliseconds of the UTC day of the last fix
+   uint32_t candidateTime;       // milliseconds the state change has been pending
+   uint32_t stateTime;           // milliseconds in the current state
+   int64_t prevLat, prevLng;     // nanodegrees of the previous fix
+   int64_t fromLat, fromLng;     // ... of the last position counted, where the trip stopped
+   int64_t scaleLat;             // ... of the latitude eastScale was taken at
+   int64_t runLat, runLng;       // ... of the last glitch
+   uint8_t run;                  // glitches in a row that agree with each other
+   double eastScale;
+   uint64_t odometer;            // millimeters
+   uint32_t elapsed, moving, stopped;
+   uint16_t stopCount, gapCount, glitchCount, relocationCount;
+   int32_t topSpeed;
+   int32_t climbRef, climbed, descended, lowest, highest;
+   uint32_t used, skipped;
+
+   uint32_t distance(int64_t lat0, int64_t lng0, int64_t lat1, int64_t lng1);
+   void climb(int32_t altitude);
+};
+
+#endif // def(GP02Trip_h)